@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <opencv2/opencv.hpp>
+#include "Matrix2D.h"
 
 using std::vector;
 
@@ -10,14 +11,14 @@ public:
     KDebugDisplay();
 
     /**
-     * @brief Converts a 2D vector of ValueType (e.g. double) to a grayscale cv::Mat internally and
+     * @brief Converts a 2D matrix of ValueType (e.g. double) to a grayscale cv::Mat internally and
             displays it
      * @param InputVector: grayscale representation of an image
      * @param NormalizationFactor: Factor by which to normalize the values such that any value is
             no larger than 1.0
      */
     template<typename ValueType>
-    bool Display2DVector(const vector<vector<ValueType>>& InputVector,
+    bool Display2DVector(const ct::KMatrix2D<ValueType>& InputVector,
                          ValueType NormalizationFactor);
 
     /**
@@ -26,7 +27,7 @@ public:
      * @param
      * @param
      */
-    bool MarkPixelsAndDisplay(const vector<vector<bool>>& PixelsToMark,
+    bool MarkPixelsAndDisplay(const ct::KMatrix2D<bool>& PixelsToMark,
                               const cv::Mat& ImageToMark,
                               uchar Color = 255);
 
@@ -38,17 +39,17 @@ private:
 KDebugDisplay::KDebugDisplay() {}
 
 template<typename ValueType>
-bool KDebugDisplay::Display2DVector(const vector<vector<ValueType>>& InputVector,
+bool KDebugDisplay::Display2DVector(const ct::KMatrix2D<ValueType>& InputVector,
                                     ValueType NormalizationFactor)
 {
-    if (!(InputVector.size() > 0 && InputVector[0].size() > 0)) { return false; }
+    if (InputVector.Empty()) { return false; }
 
     // create an output matrix of the same dimensions as input
-    cv::Mat output(InputVector.size(), InputVector[0].size(), CV_8UC1);
+    cv::Mat output(InputVector.GetNumRows(), InputVector.GetNumColumns(), CV_8UC1);
 
-    for (uint32_t Row = 0; Row < InputVector.size(); Row++)
+    for (int32_t Row = 0; Row < InputVector.GetNumRows(); Row++)
     {
-        for (uint32_t Column = 0; Column < InputVector[0].size(); Column++)
+        for (int32_t Column = 0; Column < InputVector.GetNumColumns(); Column++)
         {
             output.at<uchar>(Row, Column) = (uchar)(InputVector[Row][Column] /
                                                     NormalizationFactor * ((2 << ((sizeof(uchar) * 8) - 1)) - 1));
@@ -62,14 +63,14 @@ bool KDebugDisplay::Display2DVector(const vector<vector<ValueType>>& InputVector
     return true;
 }
 
-bool KDebugDisplay::MarkPixelsAndDisplay(const vector<vector<bool>>& PixelsToMark,
+bool KDebugDisplay::MarkPixelsAndDisplay(const ct::KMatrix2D<bool>& PixelsToMark,
                                          const cv::Mat& ImageToMark, uchar Color)
 {
     int32_t NumChannels = ImageToMark.channels();
     int32_t NumColumns = ImageToMark.cols;
     int32_t NumRows = ImageToMark.rows;
 
-    if (!(PixelsToMark.size() == NumRows && PixelsToMark[0].size() == NumColumns))
+    if (!(PixelsToMark.GetNumRows() == NumRows && PixelsToMark.GetNumColumns() == NumColumns))
     {
         return false;
     }
@@ -25,7 +25,7 @@ public:
      * @brief copy constructor to perform deep copy
      * @param rhs source of deep copy
      */
-    ConstSizeMinBinaryHeap(ConstSizeMinBinaryHeap<_Tp>& rhs);
+    ConstSizeMinBinaryHeap(const ConstSizeMinBinaryHeap<_Tp>& rhs);
 
     /**
      * @brief initialize data members and allocate memory for new heap
@@ -129,7 +129,7 @@ ConstSizeMinBinaryHeap<_Tp>::~ConstSizeMinBinaryHeap()
 
 
 template<typename _Tp>
-ConstSizeMinBinaryHeap<_Tp>::ConstSizeMinBinaryHeap(ConstSizeMinBinaryHeap<_Tp>& rhs)
+ConstSizeMinBinaryHeap<_Tp>::ConstSizeMinBinaryHeap(const ConstSizeMinBinaryHeap<_Tp>& rhs)
 {
     N_ = rhs.N_;
     capacity_ = rhs.capacity_;
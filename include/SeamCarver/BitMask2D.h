@@ -0,0 +1,291 @@
+#pragma once
+#include <stdint.h>
+#include "Matrix2D.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace ct
+{
+    /**
+     * @brief 2D mask with one bit per pixel. Every row starts on its own 64 bit word, so a row can
+     *      be scanned and combined 64 pixels at a time. Bits past the last column are always 0
+     */
+    class KBitMask2D
+    {
+    public:
+        typedef uint64_t KWord;
+        static const int32_t CBitsPerWord = 64;
+
+        KBitMask2D() : NumColumns_(0) {}
+
+        /**
+         * @brief creates a mask with no pixel marked
+         */
+        KBitMask2D(int32_t NumRows, int32_t NumColumns) : NumColumns_(0)
+        {
+            Resize(NumRows, NumColumns);
+            Fill(false);
+        }
+
+        /**
+         * @brief resizes the mask, reallocating only when growing. Contents are unspecified
+         *      afterwards, call Fill to initialize them
+         * @return bool: true if the mask has the requested dimensions
+         */
+        bool Resize(int32_t NumRows, int32_t NumColumns)
+        {
+            if (!Words_.Resize(NumRows, (NumColumns + CBitsPerWord - 1) / CBitsPerWord))
+            {
+                return false;
+            }
+            NumColumns_ = NumColumns;
+            return true;
+        }
+
+        /**
+         * @brief marks or unmarks every pixel
+         */
+        void Fill(bool bMarked)
+        {
+            const int32_t NumWords = GetNumWords();
+            for (int32_t Row = 0; Row < GetNumRows(); Row++)
+            {
+                KWord* RowWords = Words_[Row];
+                for (int32_t Word = 0; Word < NumWords; Word++)
+                {
+                    RowWords[Word] = bMarked ? ~KWord(0) : 0;
+                }
+                if (bMarked && NumWords > 0)
+                {
+                    RowWords[NumWords - 1] &= LastWordMask();
+                }
+            }
+        }
+
+        void Release()
+        {
+            Words_.Release();
+            NumColumns_ = 0;
+        }
+
+        inline bool IsMarked(int32_t Row, int32_t Column) const
+        {
+            return IsMarked(Words_[Row], Column);
+        }
+
+        inline void Mark(int32_t Row, int32_t Column)
+        {
+            Words_[Row][Column / CBitsPerWord] |= KWord(1) << (Column % CBitsPerWord);
+        }
+
+        inline void Unmark(int32_t Row, int32_t Column)
+        {
+            Words_[Row][Column / CBitsPerWord] &= ~(KWord(1) << (Column % CBitsPerWord));
+        }
+
+        /**
+         * @brief returns the bit of Column in a row of words
+         */
+        static inline bool IsMarked(const KWord* RowWords, int32_t Column)
+        {
+            return ((RowWords[Column / CBitsPerWord] >> (Column % CBitsPerWord)) & 1) != 0;
+        }
+
+        /**
+         * @brief returns the words of a row, bit b of word w is column w * 64 + b
+         */
+        inline KWord* operator[](int32_t Row) { return Words_[Row]; }
+        inline const KWord* operator[](int32_t Row) const { return Words_[Row]; }
+
+        /**
+         * @brief returns the first unmarked column at or after StartColumn in Row, -1 if there is none
+         */
+        int32_t FindFirstUnmarked(int32_t Row, int32_t StartColumn) const
+        {
+            if (StartColumn >= NumColumns_)
+            {
+                return -1;
+            }
+
+            const KWord* RowWords = Words_[Row];
+            int32_t Word = StartColumn / CBitsPerWord;
+            KWord Unmarked = ~RowWords[Word] & (~KWord(0) << (StartColumn % CBitsPerWord));
+
+            // fully marked words are skipped with a single comparison
+            while (Unmarked == 0)
+            {
+                if (++Word == GetNumWords())
+                {
+                    return -1;
+                }
+                Unmarked = ~RowWords[Word];
+            }
+
+            int32_t Column = Word * CBitsPerWord + CountTrailingZeros(Unmarked);
+            return Column < NumColumns_ ? Column : -1;
+        }
+
+        /**
+         * @brief returns the first marked column at or after StartColumn in Row, -1 if there is none
+         */
+        int32_t FindFirstMarked(int32_t Row, int32_t StartColumn) const
+        {
+            if (StartColumn >= NumColumns_)
+            {
+                return -1;
+            }
+
+            const KWord* RowWords = Words_[Row];
+            int32_t Word = StartColumn / CBitsPerWord;
+            KWord Marked = RowWords[Word] & (~KWord(0) << (StartColumn % CBitsPerWord));
+
+            // unmarked words are skipped with a single comparison, bits past the last column are 0
+            while (Marked == 0)
+            {
+                if (++Word == GetNumWords())
+                {
+                    return -1;
+                }
+                Marked = RowWords[Word];
+            }
+
+            return Word * CBitsPerWord + CountTrailingZeros(Marked);
+        }
+
+        /**
+         * @brief returns the number of unmarked pixels in Row
+         */
+        int32_t CountUnmarked(int32_t Row) const
+        {
+            const KWord* RowWords = Words_[Row];
+            int32_t NumMarked = 0;
+            for (int32_t Word = 0; Word < GetNumWords(); Word++)
+            {
+                NumMarked += PopCount(RowWords[Word]);
+            }
+            return NumColumns_ - NumMarked;
+        }
+
+        /**
+         * @brief returns the number of unmarked pixels in the whole mask
+         */
+        int64_t CountUnmarked() const
+        {
+            int64_t NumUnmarked = 0;
+            for (int32_t Row = 0; Row < GetNumRows(); Row++)
+            {
+                NumUnmarked += CountUnmarked(Row);
+            }
+            return NumUnmarked;
+        }
+
+        /**
+         * @brief marks every pixel that is marked in rhs
+         * @return bool: false if the masks have different dimensions
+         */
+        bool Or(const KBitMask2D& rhs)
+        {
+            if (rhs.GetNumRows() != GetNumRows() || rhs.NumColumns_ != NumColumns_)
+            {
+                return false;
+            }
+
+            for (int32_t Row = 0; Row < GetNumRows(); Row++)
+            {
+                KWord* RowWords = Words_[Row];
+                const KWord* rhsRowWords = rhs.Words_[Row];
+                for (int32_t Word = 0; Word < GetNumWords(); Word++)
+                {
+                    RowWords[Word] |= rhsRowWords[Word];
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief unmarks every pixel that is marked in rhs
+         * @return bool: false if the masks have different dimensions
+         */
+        bool AndNot(const KBitMask2D& rhs)
+        {
+            if (rhs.GetNumRows() != GetNumRows() || rhs.NumColumns_ != NumColumns_)
+            {
+                return false;
+            }
+
+            for (int32_t Row = 0; Row < GetNumRows(); Row++)
+            {
+                KWord* RowWords = Words_[Row];
+                const KWord* rhsRowWords = rhs.Words_[Row];
+                for (int32_t Word = 0; Word < GetNumWords(); Word++)
+                {
+                    RowWords[Word] &= ~rhsRowWords[Word];
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief removes Column from Row by shifting every column to its right one column to the
+         *      left. The last column becomes unmarked
+         */
+        void EraseColumn(int32_t Row, int32_t Column)
+        {
+            KWord* RowWords = Words_[Row];
+            const int32_t NumWords = GetNumWords();
+            int32_t Word = Column / CBitsPerWord;
+
+            // bits below Column stay, bits above it move down by one
+            const KWord LowMask = (KWord(1) << (Column % CBitsPerWord)) - 1;
+            RowWords[Word] = (RowWords[Word] & LowMask) | ((RowWords[Word] >> 1) & ~LowMask);
+
+            // every following word moves down by one bit and hands its lowest bit to the word before
+            for (; Word + 1 < NumWords; Word++)
+            {
+                RowWords[Word] |= RowWords[Word + 1] << (CBitsPerWord - 1);
+                RowWords[Word + 1] >>= 1;
+            }
+        }
+
+        inline int32_t GetNumRows() const { return Words_.GetNumRows(); }
+        inline int32_t GetNumColumns() const { return NumColumns_; }
+        inline int32_t GetNumWords() const { return Words_.GetNumColumns(); }
+        inline bool Empty() const { return Words_.Empty(); }
+        inline size_t GetAllocatedBytes() const { return Words_.GetAllocatedBytes(); }
+
+    private:
+        /**
+         * @brief mask of the valid bits in the last word of a row
+         */
+        KWord LastWordMask() const
+        {
+            const int32_t NumBits = NumColumns_ % CBitsPerWord;
+            return NumBits == 0 ? ~KWord(0) : (KWord(1) << NumBits) - 1;
+        }
+
+        static inline int32_t PopCount(KWord Word)
+        {
+#ifdef _MSC_VER
+            return static_cast<int32_t>(__popcnt64(Word));
+#else
+            return __builtin_popcountll(Word);
+#endif
+        }
+
+        static inline int32_t CountTrailingZeros(KWord Word)
+        {
+#ifdef _MSC_VER
+            unsigned long Index;
+            _BitScanForward64(&Index, Word);
+            return static_cast<int32_t>(Index);
+#else
+            return __builtin_ctzll(Word);
+#endif
+        }
+
+        KMatrix2D<KWord> Words_;
+        int32_t NumColumns_;
+    };
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// x86 SIMD kernels are only built and dispatched to on x86 targets
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CT_X86_SIMD 1
+#endif
+
+namespace ct
+{
+    /**
+     * @brief Runtime detection of the instruction set extensions used by the SIMD kernels.
+     *      Results are queried once and cached
+     */
+    class KCpuFeatures
+    {
+    public:
+        /**
+         * @brief Indicates whether the CPU supports SSE4.1 (which implies SSSE3)
+         */
+        static bool HasSSE41();
+
+        /**
+         * @brief Indicates whether the CPU and the OS support AVX2
+         */
+        static bool HasAVX2();
+    };
+}
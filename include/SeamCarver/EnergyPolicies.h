@@ -0,0 +1,214 @@
+#pragma once
+#include <stdint.h>
+#include <cstdlib>
+#include <memory>
+#include "PixelEnergy2D.h"
+
+namespace ct
+{
+    /**
+     * Energy policies compute the energy of one interior pixel of an 8-bit interleaved image.
+     *      A policy is a copyable functor with the member
+     *          template<int32_t NumChannels>
+     *          int32_t Calculate(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below) const
+     *      where Current points at the first channel of the pixel and Above and Below at the
+     *      pixels above and below it. The pixels left and right of it are NumChannels bytes away.
+     *      KPolicyPixelEnergy2DT instantiates the row loop for every channel count and energy type,
+     *      so Calculate is inlined into it. Policies may carry state, it is read by several
+     *      threads at once and must not change while energies are calculated.
+     *      The maximum energy of every built-in policy is below the default margin energy 390150
+     */
+
+    /**
+     * @brief squared differences of the left and right and of the upper and lower neighbor,
+     *      summed over all channels. At most 6 * 255^2 = 390150. This is the energy
+     *      KPixelEnergy2DT calculates, with the SIMD kernels
+     */
+    struct KDualGradientEnergy
+    {
+        template<int32_t NumChannels>
+        int32_t Calculate(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below) const
+        {
+            int32_t Energy = 0;
+            for (int32_t Channel = 0; Channel < NumChannels; Channel++)
+            {
+                const int32_t DeltaX = Current[Channel + NumChannels] - Current[Channel - NumChannels];
+                const int32_t DeltaY = Below[Channel] - Above[Channel];
+                Energy += DeltaX * DeltaX + DeltaY * DeltaY;
+            }
+            return Energy;
+        }
+    };
+
+    /**
+     * @brief absolute responses of the 3 x 3 Sobel kernels in X and Y, summed over all channels.
+     *      At most 3 * 2 * 4 * 255 = 6120 for BGR images
+     */
+    struct KSobelEnergy
+    {
+        template<int32_t NumChannels>
+        int32_t Calculate(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below) const
+        {
+            return CalculateWeighted<NumChannels>(Above, Current, Below, 1, 2);
+        }
+
+        /**
+         * @brief |Gx| + |Gy| of the 3 x 3 kernels with CornerWeight in the corners and EdgeWeight
+         *      next to the center, also used by KScharrEnergy
+         */
+        template<int32_t NumChannels>
+        static int32_t CalculateWeighted(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below,
+                                         int32_t CornerWeight, int32_t EdgeWeight)
+        {
+            int32_t Energy = 0;
+            for (int32_t Channel = 0; Channel < NumChannels; Channel++)
+            {
+                const int32_t Left = Channel - NumChannels;
+                const int32_t Right = Channel + NumChannels;
+                const int32_t GradientX = CornerWeight * (Above[Right] - Above[Left] + Below[Right] - Below[Left]) +
+                                          EdgeWeight * (Current[Right] - Current[Left]);
+                const int32_t GradientY = CornerWeight * (Below[Left] - Above[Left] + Below[Right] - Above[Right]) +
+                                          EdgeWeight * (Below[Channel] - Above[Channel]);
+                Energy += std::abs(GradientX) + std::abs(GradientY);
+            }
+            return Energy;
+        }
+    };
+
+    /**
+     * @brief absolute responses of the 3 x 3 Scharr kernels in X and Y, summed over all channels.
+     *      More rotation invariant than Sobel. At most 3 * 2 * 16 * 255 = 24480 for BGR images
+     */
+    struct KScharrEnergy
+    {
+        template<int32_t NumChannels>
+        int32_t Calculate(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below) const
+        {
+            return KSobelEnergy::CalculateWeighted<NumChannels>(Above, Current, Below, 3, 10);
+        }
+    };
+
+    /**
+     * @brief absolute differences of the left and right neighbor, summed over all channels. This is
+     *      the new edge a removed pixel leaves between its neighbors, the part of the forward
+     *      energy of Rubinstein et al. that does not depend on the pixels of the seam in the rows
+     *      above and below. At most 3 * 255 = 765 for BGR images
+     */
+    struct KForwardEnergy
+    {
+        // the rows above and below are part of the transition costs of the seam search, see
+        //      KSeamCost::Forward, not of the energy of a pixel
+        template<int32_t NumChannels>
+        int32_t Calculate(const uint8_t*, const uint8_t* Current, const uint8_t*) const
+        {
+            int32_t Energy = 0;
+            for (int32_t Channel = 0; Channel < NumChannels; Channel++)
+            {
+                Energy += std::abs(Current[Channel + NumChannels] - Current[Channel - NumChannels]);
+            }
+            return Energy;
+        }
+    };
+
+    /**
+     * @brief dual-gradient energy of the luma of the pixels, which ignores changes of color at the
+     *      same brightness and computes a single channel. At most 2 * 255^2 = 130050
+     */
+    struct KLumaEnergy
+    {
+        template<int32_t NumChannels>
+        int32_t Calculate(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below) const
+        {
+            const int32_t DeltaX = Luma<NumChannels>(Current + NumChannels) - Luma<NumChannels>(Current - NumChannels);
+            const int32_t DeltaY = Luma<NumChannels>(Below) - Luma<NumChannels>(Above);
+            return DeltaX * DeltaX + DeltaY * DeltaY;
+        }
+
+        /**
+         * @brief BT.601 luma of a BGR pixel in 8 bit fixed point, the value of a grayscale pixel
+         */
+        template<int32_t NumChannels>
+        static int32_t Luma(const uint8_t* Pixel)
+        {
+            return NumChannels == 1 ? Pixel[0] : (29 * Pixel[0] + 150 * Pixel[1] + 77 * Pixel[2] + 128) >> 8;
+        }
+    };
+
+    /**
+     * @brief calculates pixel energies with an energy policy. Border pixels and threading are
+     *      handled by KPixelEnergy2DT, only the interior of every row is calculated by the policy
+     */
+    template<typename EnergyType, typename EnergyPolicy>
+    class KPolicyPixelEnergy2DT : public KPixelEnergy2DT<EnergyType>
+    {
+    public:
+        explicit KPolicyPixelEnergy2DT(EnergyType MarginEnergy = 390150,
+                                       const EnergyPolicy& Policy = EnergyPolicy()) :
+            KPixelEnergy2DT<EnergyType>(MarginEnergy),
+            Policy_(Policy)
+        {}
+
+        virtual std::unique_ptr<KPixelEnergy2DT<EnergyType>> Clone() const override
+        {
+            return std::unique_ptr<KPixelEnergy2DT<EnergyType>>(new KPolicyPixelEnergy2DT(*this));
+        }
+
+        const EnergyPolicy& GetPolicy() const { return Policy_; }
+
+    protected:
+        virtual void CalculateEnergyRow(const cv::Mat& Image, int32_t Row, int32_t StartColumn,
+                                        int32_t EndColumn, EnergyType* OutEnergy) override
+        {
+            // KPixelEnergy2DT only calculates images with a kernel for their number of channels
+            if (Image.channels() == 1)
+            {
+                CalculateEnergyRow<1>(Image, Row, StartColumn, EndColumn, OutEnergy);
+            }
+            else
+            {
+                CalculateEnergyRow<3>(Image, Row, StartColumn, EndColumn, OutEnergy);
+            }
+        }
+
+        template<int32_t NumChannels>
+        void CalculateEnergyRow(const cv::Mat& Image, int32_t Row, int32_t StartColumn,
+                                int32_t EndColumn, EnergyType* OutEnergy) const
+        {
+            const uint8_t* Above = Image.ptr<uint8_t>(Row - 1);
+            const uint8_t* Current = Image.ptr<uint8_t>(Row);
+            const uint8_t* Below = Image.ptr<uint8_t>(Row + 1);
+            for (int32_t Column = StartColumn; Column < EndColumn; Column++)
+            {
+                const int32_t Offset = Column * NumChannels;
+                OutEnergy[Column] = static_cast<EnergyType>(
+                    Policy_.template Calculate<NumChannels>(Above + Offset, Current + Offset, Below + Offset));
+            }
+        }
+
+        EnergyPolicy Policy_;
+    };
+
+    /**
+     * @brief the dual-gradient energy keeps the SIMD kernels of KPixelEnergy2DT
+     */
+    template<typename EnergyType>
+    class KPolicyPixelEnergy2DT<EnergyType, KDualGradientEnergy> : public KPixelEnergy2DT<EnergyType>
+    {
+    public:
+        explicit KPolicyPixelEnergy2DT(EnergyType MarginEnergy = 390150,
+                                       const KDualGradientEnergy& Policy = KDualGradientEnergy()) :
+            KPixelEnergy2DT<EnergyType>(MarginEnergy),
+            Policy_(Policy)
+        {}
+
+        virtual std::unique_ptr<KPixelEnergy2DT<EnergyType>> Clone() const override
+        {
+            return std::unique_ptr<KPixelEnergy2DT<EnergyType>>(new KPolicyPixelEnergy2DT(*this));
+        }
+
+        const KDualGradientEnergy& GetPolicy() const { return Policy_; }
+
+    protected:
+        KDualGradientEnergy Policy_;
+    };
+}
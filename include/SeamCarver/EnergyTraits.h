@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include <cfloat>
+
+namespace ct
+{
+    /**
+     * @brief Describes the value type used for pixel energies and cumulative path energies.
+     *      PosInf() marks unreachable pixels and Add() sums two non-negative energies without
+     *      ever reaching PosInf(), so a reachable path can never be mistaken for an unreachable one.
+     *      AddBias() adds a signed bias to a pixel energy and keeps the result non-negative and
+     *      below PosInf(), see KProtectionMask
+     */
+    template<typename EnergyType>
+    struct KEnergyTraits;
+
+    template<>
+    struct KEnergyTraits<double>
+    {
+        static inline double PosInf() { return DBL_MAX; }
+
+        static inline double Add(double Lhs, double Rhs) { return Lhs + Rhs; }
+
+        static inline double AddBias(double Energy, int32_t Bias)
+        {
+            const double Biased = Energy + Bias;
+            return Biased > 0.0 ? Biased : 0.0;
+        }
+    };
+
+    /**
+     * @brief Integer energies are exact, half the size of double and twice as many fit in a SIMD
+     *      register. The dual-gradient energy of a pixel is at most 6 * 255^2 = 390150, so paths
+     *      of more than 5500 rows can overflow and sums saturate at CMaxEnergy instead
+     */
+    template<>
+    struct KEnergyTraits<int32_t>
+    {
+        static const int32_t CMaxEnergy = INT32_MAX - 1;
+
+        static inline int32_t PosInf() { return INT32_MAX; }
+
+        static inline int32_t Add(int32_t Lhs, int32_t Rhs)
+        {
+            return Rhs < CMaxEnergy - Lhs ? Lhs + Rhs : CMaxEnergy;
+        }
+
+        static inline int32_t AddBias(int32_t Energy, int32_t Bias)
+        {
+            const int64_t Biased = static_cast<int64_t>(Energy) + Bias;
+            return Biased < 0 ? 0 : (Biased > CMaxEnergy ? CMaxEnergy : static_cast<int32_t>(Biased));
+        }
+    };
+}
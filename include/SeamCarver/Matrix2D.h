@@ -0,0 +1,342 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <stdint.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace ct
+{
+    /**
+     * @brief Contiguous, row-aligned 2D buffer. Rows are addressed through a single base pointer
+     *      and a stride (in elements), so a whole image lives in one allocation instead of one
+     *      allocation per row. Can also act as a non-owning view over a cv::Mat or raw memory.
+     */
+    template<typename ValueType>
+    class KMatrix2D
+    {
+    public:
+        /**
+         * @brief Default constructor, creates an empty matrix that owns no memory
+         */
+        KMatrix2D();
+
+        /**
+         * @brief Allocates a NumRows x NumColumns matrix. Contents are uninitialized
+         * @param NumRows: number of rows
+         * @param NumColumns: number of columns
+         */
+        KMatrix2D(int32_t NumRows, int32_t NumColumns);
+
+        /**
+         * @brief Allocates a NumRows x NumColumns matrix and sets every element to InitialValue
+         * @param NumRows: number of rows
+         * @param NumColumns: number of columns
+         * @param InitialValue: value every element is initialized to
+         */
+        KMatrix2D(int32_t NumRows, int32_t NumColumns, const ValueType& InitialValue);
+
+        /**
+         * @brief Non-owning view over a single channel cv::Mat whose element size matches
+         *      ValueType. The cv::Mat must outlive the view
+         * @param Image: matrix to wrap
+         */
+        explicit KMatrix2D(cv::Mat& Image);
+
+        /**
+         * @brief Non-owning view over raw memory
+         * @param Data: pointer to the first element of row 0
+         * @param NumRows: number of rows
+         * @param NumColumns: number of columns
+         * @param Stride: distance between the start of consecutive rows in elements
+         */
+        KMatrix2D(ValueType* Data, int32_t NumRows, int32_t NumColumns, int32_t Stride);
+
+        /**
+         * @brief Deep copy. Copying a view produces an owning matrix
+         */
+        KMatrix2D(const KMatrix2D<ValueType>& rhs);
+
+        KMatrix2D(KMatrix2D<ValueType>&& rhs);
+
+        ~KMatrix2D();
+
+        KMatrix2D<ValueType>& operator=(const KMatrix2D<ValueType>& rhs);
+
+        KMatrix2D<ValueType>& operator=(KMatrix2D<ValueType>&& rhs);
+
+        /**
+         * @brief Changes the dimensions of the matrix. Memory is only reallocated if the current
+         *      allocation is too small, and then grows geometrically. Contents are not preserved
+         * @param NumRows: new number of rows
+         * @param NumColumns: new number of columns
+         * @return bool: false if this is a view and the dimensions do not match
+         */
+        bool Resize(int32_t NumRows, int32_t NumColumns);
+
+        /**
+         * @brief Sets every element to Value
+         */
+        void Fill(const ValueType& Value);
+
+        /**
+         * @brief Releases owned memory and resets dimensions to 0
+         */
+        void Release();
+
+        /**
+         * @brief Returns a pointer to the first element of Row
+         */
+        inline ValueType* operator[](int32_t Row) { return Data_ + static_cast<size_t>(Row) * Stride_; }
+        inline const ValueType* operator[](int32_t Row) const { return Data_ + static_cast<size_t>(Row) * Stride_; }
+
+        inline ValueType& At(int32_t Row, int32_t Column) { return (*this)[Row][Column]; }
+        inline const ValueType& At(int32_t Row, int32_t Column) const { return (*this)[Row][Column]; }
+
+        inline ValueType* GetData() { return Data_; }
+        inline const ValueType* GetData() const { return Data_; }
+
+        inline int32_t GetNumRows() const { return NumRows_; }
+        inline int32_t GetNumColumns() const { return NumColumns_; }
+
+        /**
+         * @brief Distance between the start of consecutive rows in elements
+         */
+        inline int32_t GetStride() const { return Stride_; }
+
+        inline bool IsView() const { return !bOwnsMemory_ && Data_ != nullptr; }
+
+        /**
+         * @brief Bytes of the current allocation, 0 for a view
+         */
+        inline size_t GetAllocatedBytes() const { return Capacity_ * sizeof(ValueType); }
+        inline bool Empty() const { return NumRows_ == 0 || NumColumns_ == 0; }
+
+        // byte alignment of the start of every row of an owning matrix
+        static const size_t CAlignment = 64;
+
+    protected:
+        /**
+         * @brief Rounds NumColumns up so that every row starts on a CAlignment byte boundary
+         */
+        static int32_t CalculateStride(int32_t NumColumns);
+
+        static ValueType* AllocateAligned(size_t NumElements);
+        static void FreeAligned(ValueType* Memory);
+
+        ValueType* Data_;
+        int32_t NumRows_;
+        int32_t NumColumns_;
+        int32_t Stride_;
+
+        // number of elements that fit in the current allocation
+        size_t Capacity_;
+
+        bool bOwnsMemory_;
+    };
+
+
+    template<typename ValueType>
+    KMatrix2D<ValueType>::KMatrix2D() :
+        Data_(nullptr), NumRows_(0), NumColumns_(0), Stride_(0), Capacity_(0), bOwnsMemory_(false)
+    {}
+
+    template<typename ValueType>
+    KMatrix2D<ValueType>::KMatrix2D(int32_t NumRows, int32_t NumColumns) : KMatrix2D()
+    {
+        Resize(NumRows, NumColumns);
+    }
+
+    template<typename ValueType>
+    KMatrix2D<ValueType>::KMatrix2D(int32_t NumRows, int32_t NumColumns,
+                                    const ValueType& InitialValue) : KMatrix2D()
+    {
+        Resize(NumRows, NumColumns);
+        Fill(InitialValue);
+    }
+
+    template<typename ValueType>
+    KMatrix2D<ValueType>::KMatrix2D(cv::Mat& Image) : KMatrix2D()
+    {
+        if (Image.elemSize() != sizeof(ValueType) || Image.step[0] % sizeof(ValueType) != 0)
+        {
+            throw std::invalid_argument("cv::Mat element size does not match KMatrix2D value type");
+        }
+        Data_ = reinterpret_cast<ValueType*>(Image.data);
+        NumRows_ = Image.rows;
+        NumColumns_ = Image.cols;
+        Stride_ = static_cast<int32_t>(Image.step[0] / sizeof(ValueType));
+    }
+
+    template<typename ValueType>
+    KMatrix2D<ValueType>::KMatrix2D(ValueType* Data, int32_t NumRows, int32_t NumColumns,
+                                    int32_t Stride) :
+        Data_(Data), NumRows_(NumRows), NumColumns_(NumColumns), Stride_(Stride), Capacity_(0),
+        bOwnsMemory_(false)
+    {}
+
+    template<typename ValueType>
+    KMatrix2D<ValueType>::KMatrix2D(const KMatrix2D<ValueType>& rhs) : KMatrix2D()
+    {
+        *this = rhs;
+    }
+
+    template<typename ValueType>
+    KMatrix2D<ValueType>::KMatrix2D(KMatrix2D<ValueType>&& rhs) :
+        Data_(rhs.Data_), NumRows_(rhs.NumRows_), NumColumns_(rhs.NumColumns_),
+        Stride_(rhs.Stride_), Capacity_(rhs.Capacity_), bOwnsMemory_(rhs.bOwnsMemory_)
+    {
+        rhs.Data_ = nullptr;
+        rhs.bOwnsMemory_ = false;
+        rhs.Release();
+    }
+
+    template<typename ValueType>
+    KMatrix2D<ValueType>::~KMatrix2D()
+    {
+        Release();
+    }
+
+    template<typename ValueType>
+    KMatrix2D<ValueType>& KMatrix2D<ValueType>::operator=(const KMatrix2D<ValueType>& rhs)
+    {
+        if (this != &rhs)
+        {
+            // never write through a view when copying, always produce an owning matrix
+            if (IsView())
+            {
+                Release();
+            }
+            Resize(rhs.NumRows_, rhs.NumColumns_);
+            for (int32_t Row = 0; Row < NumRows_; Row++)
+            {
+                std::copy(rhs[Row], rhs[Row] + NumColumns_, (*this)[Row]);
+            }
+        }
+        return *this;
+    }
+
+    template<typename ValueType>
+    KMatrix2D<ValueType>& KMatrix2D<ValueType>::operator=(KMatrix2D<ValueType>&& rhs)
+    {
+        if (this != &rhs)
+        {
+            Release();
+            Data_ = rhs.Data_;
+            NumRows_ = rhs.NumRows_;
+            NumColumns_ = rhs.NumColumns_;
+            Stride_ = rhs.Stride_;
+            Capacity_ = rhs.Capacity_;
+            bOwnsMemory_ = rhs.bOwnsMemory_;
+            rhs.Data_ = nullptr;
+            rhs.bOwnsMemory_ = false;
+            rhs.Release();
+        }
+        return *this;
+    }
+
+    template<typename ValueType>
+    bool KMatrix2D<ValueType>::Resize(int32_t NumRows, int32_t NumColumns)
+    {
+        if (NumRows < 0 || NumColumns < 0)
+        {
+            return false;
+        }
+
+        if (IsView())
+        {
+            return NumRows == NumRows_ && NumColumns == NumColumns_;
+        }
+
+        int32_t NewStride = CalculateStride(NumColumns);
+        size_t NumElements = static_cast<size_t>(NumRows) * NewStride;
+
+        // only reallocate when growing beyond the current allocation. A matrix that grows again
+        //      grows by at least half its capacity, so frames of slowly changing size reallocate
+        //      only every few frames
+        if (NumElements > Capacity_)
+        {
+            if (Capacity_ > 0)
+            {
+                NumElements = std::max(NumElements, Capacity_ + Capacity_ / 2);
+            }
+            FreeAligned(Data_);
+            Data_ = AllocateAligned(NumElements);
+            Capacity_ = NumElements;
+            bOwnsMemory_ = true;
+        }
+
+        NumRows_ = NumRows;
+        NumColumns_ = NumColumns;
+        Stride_ = NewStride;
+        return true;
+    }
+
+    template<typename ValueType>
+    void KMatrix2D<ValueType>::Fill(const ValueType& Value)
+    {
+        for (int32_t Row = 0; Row < NumRows_; Row++)
+        {
+            std::fill((*this)[Row], (*this)[Row] + NumColumns_, Value);
+        }
+    }
+
+    template<typename ValueType>
+    void KMatrix2D<ValueType>::Release()
+    {
+        if (bOwnsMemory_)
+        {
+            FreeAligned(Data_);
+        }
+        Data_ = nullptr;
+        NumRows_ = 0;
+        NumColumns_ = 0;
+        Stride_ = 0;
+        Capacity_ = 0;
+        bOwnsMemory_ = false;
+    }
+
+    template<typename ValueType>
+    int32_t KMatrix2D<ValueType>::CalculateStride(int32_t NumColumns)
+    {
+        // can only pad rows to the alignment boundary if it is a whole number of elements
+        if (CAlignment % sizeof(ValueType) != 0)
+        {
+            return NumColumns;
+        }
+        const int32_t ElementsPerAlignment = static_cast<int32_t>(CAlignment / sizeof(ValueType));
+        return (NumColumns + ElementsPerAlignment - 1) / ElementsPerAlignment * ElementsPerAlignment;
+    }
+
+    template<typename ValueType>
+    ValueType* KMatrix2D<ValueType>::AllocateAligned(size_t NumElements)
+    {
+        if (NumElements == 0)
+        {
+            return nullptr;
+        }
+
+        // over-allocate to leave room for alignment and to store the original pointer right in
+        //      front of the aligned block
+        void* Raw = std::malloc(NumElements * sizeof(ValueType) + CAlignment + sizeof(void*));
+        if (Raw == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        uintptr_t Aligned = (reinterpret_cast<uintptr_t>(Raw) + sizeof(void*) + CAlignment - 1) &
+            ~static_cast<uintptr_t>(CAlignment - 1);
+        reinterpret_cast<void**>(Aligned)[-1] = Raw;
+        return reinterpret_cast<ValueType*>(Aligned);
+    }
+
+    template<typename ValueType>
+    void KMatrix2D<ValueType>::FreeAligned(ValueType* Memory)
+    {
+        if (Memory != nullptr)
+        {
+            std::free(reinterpret_cast<void**>(Memory)[-1]);
+        }
+    }
+}
@@ -1,21 +1,30 @@
 #pragma once
 #include <opencv2/opencv.hpp>
 #include <stdint.h>
+#include <memory>
 #include <vector>
 #include "ImageDimensionStruct.h"
+#include "Matrix2D.h"
+#include "PixelEnergyKernels.h"
+#include "ThreadPool.h"
 
 using std::vector;
 
 namespace ct
 {
-    class KPixelEnergy2D
+    /**
+     * @brief computes the dual-gradient energy of every pixel. EnergyType is double or int32_t,
+     *      the energies are exact integers in both
+     */
+    template<typename EnergyType>
+    class KPixelEnergy2DT
     {
     public:
         /**
          * @brief Default constructor, where the default pixel energy at the edges is 390150.0
          * @param
          */
-        explicit KPixelEnergy2D(double MarginEnergy = 390150.0);
+        explicit KPixelEnergy2DT(EnergyType MarginEnergy = 390150);
 
         /**
          * @brief CTOR that will initialize internal memory and
@@ -24,26 +33,33 @@ namespace ct
          * @param NumChannels: number of color channels in image (1 for grayscale, 3 for BGR color)
          * @param MarginEnergy: energy defined for border pixels
          */
-        explicit KPixelEnergy2D(int32_t NumColumns, int32_t NumRows,
-                                int32_t NumChannels, double MarginEnergy = 390150.0);
+        explicit KPixelEnergy2DT(int32_t NumColumns, int32_t NumRows,
+                                 int32_t NumChannels, EnergyType MarginEnergy = 390150);
 
         /**
          * @brief
          * @param
          * @param
          */
-        explicit KPixelEnergy2D(const cv::Mat& Image, double MarginEnergy = 390150.0);
+        explicit KPixelEnergy2DT(const cv::Mat& Image, EnergyType MarginEnergy = 390150);
+
+        virtual ~KPixelEnergy2DT() {}
+
+        /**
+         * @brief returns a copy of the calculator, of the same type as this one
+         */
+        virtual std::unique_ptr<KPixelEnergy2DT<EnergyType>> Clone() const;
 
         /**
          * @brief
          * @return
          */
-        virtual double GetMarginEnergy() const;
+        virtual EnergyType GetMarginEnergy() const;
 
         /**
          *
          */
-        virtual void SetMarginEnergy(double MarginEnergy);
+        virtual void SetMarginEnergy(EnergyType MarginEnergy);
 
         /**
          *
@@ -55,44 +71,84 @@ namespace ct
          */
         virtual void SetDimensions(int32_t NumColumns, int32_t NumRows, int32_t NumChannels);
 
+        /**
+         * @brief sets the number of threads used to compute energy. The image is split into
+         *      horizontal bands that are computed in parallel
+         * @param NumThreads: 1 computes serially, 0 uses every hardware thread
+         */
+        virtual void SetNumThreads(int32_t NumThreads);
+
+        /**
+         * @brief shares an existing thread pool instead of owning one
+         * @param ThreadPool: pool to use, nullptr computes serially
+         */
+        virtual void SetThreadPool(std::shared_ptr<KThreadPool> ThreadPool);
+
+        /**
+         * @brief returns the number of threads used to compute energy
+         */
+        virtual int32_t GetNumThreads() const;
+
         /**
          * @brief
          * @param Image: 2D matrix representation of the image
-         * @param OutPixelEnergy: Out parameter, 2D vector of calculated pixel energies
+         * @param OutPixelEnergy: Out parameter, 2D matrix of calculated pixel energies
          * @return bool: indicates if the operation was successful
          */
         virtual bool CalculatePixelEnergy(const cv::Mat& Image,
-                                          vector< vector<double> >& OutPixelEnergy);
+                                          KMatrix2D<EnergyType>& OutPixelEnergy);
 
-    protected:
         /**
-         * @brief
+         * @brief recomputes the energy of the pixels in columns [StartColumn, EndColumn) of one
+         *      row, e.g. after pixels next to them were removed. All other pixels keep their energy
          * @param Image: 2D matrix representation of the image
-         * @param OutPixelEnergy: Out parameter, 2D vector of calculated pixel energies
-         * @param bDoOddColumns: Indicates whether odd or even columns are done
+         * @param OutPixelEnergy: 2D matrix of pixel energies with the same dimensions as Image
+         * @param Row: row of the pixels
+         * @param StartColumn: first column to compute (inclusive), clamped to the image
+         * @param EndColumn: last column to compute (exclusive), clamped to the image
          * @return bool: indicates if the operation was successful
          */
-        virtual bool CalculatePixelEnergyForEveryRow(const cv::Mat& Image,
-                                                     vector< vector<double> >& OutPixelEnergy,
-                                                     bool bDoOddColumns);
+        virtual bool CalculatePixelEnergyForPixels(const cv::Mat& Image,
+                                                   KMatrix2D<EnergyType>& OutPixelEnergy,
+                                                   int32_t Row,
+                                                   int32_t StartColumn,
+                                                   int32_t EndColumn);
 
+    protected:
         /**
-         * @brief
-         * @param Image: 2D matrix representation of the image
-         * @param OutPixelEnergy: Out parameter, 2D vector of calculated pixel energies
-         * @param bDoOddRows: Indicates whether odd or even rows are done
+         * @brief computes the energy of every pixel in rows [StartRow, EndRow). Border pixels
+         *      are assigned MarginEnergy_, interior pixels are computed by the row kernel directly
+         *      from the interleaved image data
+         * @param Image: 2D matrix representation of the image (8UC1 or 8UC3)
+         * @param OutPixelEnergy: Out parameter, 2D matrix of calculated pixel energies. Must
+         *      already have the dimensions of the image
+         * @param StartRow: first row to compute (inclusive)
+         * @param EndRow: last row to compute (exclusive)
          * @return bool: indicates if the operation was successful
          */
-        virtual bool CalculatePixelEnergyForEveryColumn(const cv::Mat& Image,
-                                                        vector< vector<double> >& OutPixelEnergy,
-                                                        bool bDoOddRows);
+        virtual bool CalculatePixelEnergyForRows(const cv::Mat& Image,
+                                                 KMatrix2D<EnergyType>& OutPixelEnergy,
+                                                 int32_t StartRow,
+                                                 int32_t EndRow);
+
+        /**
+         * @brief computes the energy of the pixels in columns [StartColumn, EndColumn) of one row
+         *      with the row kernel. Caller guarantees that every pixel is an interior pixel
+         * @param Image: 2D matrix representation of the image (8UC1 or 8UC3)
+         * @param Row: row of the pixels
+         * @param StartColumn: first column to compute (inclusive)
+         * @param EndColumn: last column to compute (exclusive)
+         * @param OutEnergy: first element of the output row, indexed by column
+         */
+        virtual void CalculateEnergyRow(const cv::Mat& Image, int32_t Row, int32_t StartColumn,
+                                        int32_t EndColumn, EnergyType* OutEnergy);
 
     private:
         // stores number of columns, rows, color channels
         ImageDimensionStruct ImageDimensions;
 
         // energy at the borders of an image
-        double MarginEnergy_ = 0.0;
+        EnergyType MarginEnergy_ = 0;
 
         // indicates whether image dimensions and memory has already been allocated
         bool bDimensionsInitialized = false;
@@ -102,5 +158,16 @@ namespace ct
 
         // number of channels used for computing energy of a BGR image
         const int32_t CNumChannelsInColorImage_ = 3;
+
+        // fastest energy kernel supported by the CPU for the current number of channels
+        PixelEnergyKernels::KEnergyRowKernelT<EnergyType> EnergyRowKernel_ = nullptr;
+
+        // threads computing bands of rows in parallel, nullptr when computing serially
+        std::shared_ptr<KThreadPool> ThreadPool_;
+
+        // smallest band handed to one thread, so thin images are not split into tiny tasks
+        const int32_t CMinRowsPerBand_ = 16;
     };
+
+    typedef KPixelEnergy2DT<double> KPixelEnergy2D;
 }
@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+#include "CpuFeatures.h"
+
+namespace ct
+{
+    namespace PixelEnergyKernels
+    {
+        /**
+         * @brief Computes the dual-gradient energy of the pixels in columns [StartColumn, EndColumn)
+         *      of one row, reading interleaved 8-bit pixel data directly. The energy of a pixel is
+         *      the sum over all channels of the squared X gradient plus the squared Y gradient.
+         *      Caller guarantees 1 <= StartColumn and EndColumn <= NumColumns - 1 so every pixel
+         *      has a neighbor on all four sides
+         * @param Above: first byte of the row above
+         * @param Current: first byte of the current row
+         * @param Below: first byte of the row below
+         * @param StartColumn: first column to compute (inclusive)
+         * @param EndColumn: last column to compute (exclusive)
+         * @param OutEnergy: first element of the output row, indexed by column. Every kernel
+         *      exists for double and int32_t energies, the energies are exact integers in both
+         */
+        template<typename EnergyType>
+        using KEnergyRowKernelT = void(*)(const uint8_t* Above, const uint8_t* Current,
+                                          const uint8_t* Below, int32_t StartColumn,
+                                          int32_t EndColumn, EnergyType* OutEnergy);
+        typedef KEnergyRowKernelT<double> KEnergyRowKernel;
+
+        // portable kernels, always available
+        void CalculateEnergyRowC1Scalar(const uint8_t* Above, const uint8_t* Current,
+                                        const uint8_t* Below, int32_t StartColumn,
+                                        int32_t EndColumn, double* OutEnergy);
+        void CalculateEnergyRowC1Scalar(const uint8_t* Above, const uint8_t* Current,
+                                        const uint8_t* Below, int32_t StartColumn,
+                                        int32_t EndColumn, int32_t* OutEnergy);
+        void CalculateEnergyRowC3Scalar(const uint8_t* Above, const uint8_t* Current,
+                                        const uint8_t* Below, int32_t StartColumn,
+                                        int32_t EndColumn, double* OutEnergy);
+        void CalculateEnergyRowC3Scalar(const uint8_t* Above, const uint8_t* Current,
+                                        const uint8_t* Below, int32_t StartColumn,
+                                        int32_t EndColumn, int32_t* OutEnergy);
+
+#ifdef CT_X86_SIMD
+        // 16 pixels per iteration, requires SSE4.1
+        void CalculateEnergyRowC1SSE41(const uint8_t* Above, const uint8_t* Current,
+                                       const uint8_t* Below, int32_t StartColumn,
+                                       int32_t EndColumn, double* OutEnergy);
+        void CalculateEnergyRowC1SSE41(const uint8_t* Above, const uint8_t* Current,
+                                       const uint8_t* Below, int32_t StartColumn,
+                                       int32_t EndColumn, int32_t* OutEnergy);
+        void CalculateEnergyRowC3SSE41(const uint8_t* Above, const uint8_t* Current,
+                                       const uint8_t* Below, int32_t StartColumn,
+                                       int32_t EndColumn, double* OutEnergy);
+        void CalculateEnergyRowC3SSE41(const uint8_t* Above, const uint8_t* Current,
+                                       const uint8_t* Below, int32_t StartColumn,
+                                       int32_t EndColumn, int32_t* OutEnergy);
+
+        // 32 pixels per iteration, requires AVX2
+        void CalculateEnergyRowC1AVX2(const uint8_t* Above, const uint8_t* Current,
+                                      const uint8_t* Below, int32_t StartColumn,
+                                      int32_t EndColumn, double* OutEnergy);
+        void CalculateEnergyRowC1AVX2(const uint8_t* Above, const uint8_t* Current,
+                                      const uint8_t* Below, int32_t StartColumn,
+                                      int32_t EndColumn, int32_t* OutEnergy);
+        void CalculateEnergyRowC3AVX2(const uint8_t* Above, const uint8_t* Current,
+                                      const uint8_t* Below, int32_t StartColumn,
+                                      int32_t EndColumn, double* OutEnergy);
+        void CalculateEnergyRowC3AVX2(const uint8_t* Above, const uint8_t* Current,
+                                      const uint8_t* Below, int32_t StartColumn,
+                                      int32_t EndColumn, int32_t* OutEnergy);
+#endif
+
+        /**
+         * @brief Picks the fastest kernel supported by the CPU for the given number of channels
+         * @param NumChannels: 1 for grayscale, 3 for BGR
+         * @return KEnergyRowKernelT: nullptr if the number of channels is not supported
+         */
+        template<typename EnergyType = double>
+        KEnergyRowKernelT<EnergyType> SelectEnergyRowKernel(int32_t NumChannels);
+    }
+}
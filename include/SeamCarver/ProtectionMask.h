@@ -0,0 +1,174 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <stdint.h>
+#include <map>
+#include <utility>
+#include <vector>
+#include "BitMask2D.h"
+#include "Matrix2D.h"
+
+namespace ct
+{
+    /**
+     * @brief regions of an image that seams must not cross or should prefer, e.g. the objects
+     *      tracked in a video. Regions are rectangles or masks of any shape. Every region is
+     *      rasterized into two planes when it is added: a bit per pixel plane of protected pixels
+     *      and a plane of energy biases. Moving or removing a region only rasterizes the pixels of
+     *      that region again, so a mask kept from frame to frame costs nothing for the regions
+     *      that stayed put, see KSeamCarverT::FindAndRemoveVerticalSeams.
+     *      Regions may lie partly or entirely outside the image, only their pixels within it count
+     */
+    class KProtectionMask
+    {
+    public:
+        typedef int32_t KRegionId;
+
+        // columns [first, second) of a row
+        typedef std::pair<int32_t, int32_t> KColumnSpan;
+
+        // returned when a region could not be added
+        static const KRegionId CInvalidRegionId = -1;
+
+        KProtectionMask() : NumRows_(0), NumColumns_(0), NextRegionId_(0), NumBiasedRegions_(0) {}
+
+        /**
+         * @brief creates a mask without regions
+         */
+        KProtectionMask(int32_t NumRows, int32_t NumColumns);
+
+        /**
+         * @brief changes the dimensions of the planes and rasterizes every region again, e.g. when
+         *      the frame size changes. Regions keep their position in image coordinates
+         */
+        void Resize(int32_t NumRows, int32_t NumColumns);
+
+        /**
+         * @brief adds a region no seam may cross
+         * @param Region: pixels of the region
+         * @return KRegionId: id of the new region
+         */
+        KRegionId AddProtectedRegion(const cv::Rect& Region);
+
+        /**
+         * @brief adds a region no seam may cross, e.g. the segmentation mask of a detection
+         * @param Mask: CV_8UC1, every non-zero pixel belongs to the region
+         * @param Offset: position of the top left pixel of Mask in the image
+         * @return KRegionId: id of the new region, CInvalidRegionId if Mask is not CV_8UC1
+         */
+        KRegionId AddProtectedRegion(const cv::Mat& Mask, const cv::Point& Offset);
+
+        /**
+         * @brief adds a region whose pixel energies are raised or lowered by Bias. A negative bias
+         *      makes seams prefer the region, e.g. to remove an object first, and a positive one
+         *      protects it only as long as cheaper seams are left. Biases of overlapping regions
+         *      add up, and a biased energy never drops below 0
+         * @param Region: pixels of the region
+         * @param Bias: added to the energy of every pixel of the region
+         * @return KRegionId: id of the new region
+         */
+        KRegionId AddBiasedRegion(const cv::Rect& Region, int32_t Bias);
+
+        /**
+         * @brief adds a region of any shape whose pixel energies are raised or lowered by Bias,
+         *      see AddBiasedRegion and AddProtectedRegion
+         * @return KRegionId: id of the new region, CInvalidRegionId if Mask is not CV_8UC1
+         */
+        KRegionId AddBiasedRegion(const cv::Mat& Mask, const cv::Point& Offset, int32_t Bias);
+
+        /**
+         * @brief moves and resizes a region to a rectangle, e.g. the new bounding box of a tracked
+         *      object. Only the pixels of the old and the new region are rasterized
+         * @return bool: false if there is no region Id
+         */
+        bool UpdateRegion(KRegionId Id, const cv::Rect& Region);
+
+        /**
+         * @brief changes the shape of a region to Mask at Offset, see UpdateRegion
+         * @return bool: false if there is no region Id or Mask is not CV_8UC1
+         */
+        bool UpdateRegion(KRegionId Id, const cv::Mat& Mask, const cv::Point& Offset);
+
+        /**
+         * @brief moves a region without changing its shape
+         * @param Offset: new position of the top left pixel of the region
+         * @return bool: false if there is no region Id
+         */
+        bool MoveRegion(KRegionId Id, const cv::Point& Offset);
+
+        /**
+         * @brief removes a region, only its own pixels are rasterized
+         * @return bool: false if there is no region Id
+         */
+        bool RemoveRegion(KRegionId Id);
+
+        /**
+         * @brief removes every region
+         */
+        void Clear();
+
+        /**
+         * @brief returns the pixels covered by at least one protected region
+         */
+        const KBitMask2D& GetProtectedPixels() const { return ProtectedPixels_; }
+
+        /**
+         * @brief returns the sum of the biases of the regions covering every pixel. Empty until
+         *      the first biased region is added
+         */
+        const KMatrix2D<int32_t>& GetBiases() const { return Biases_; }
+
+        /**
+         * @brief returns the columns of Row covered by the bounds of a biased region, no other
+         *      column of Row has a bias. Empty span (0, 0) for rows without biased regions
+         */
+        inline KColumnSpan GetBiasSpan(int32_t Row) const
+        {
+            return BiasSpans_.empty() ? KColumnSpan(0, 0) : BiasSpans_[Row];
+        }
+
+        inline bool HasBiasedRegions() const { return NumBiasedRegions_ > 0; }
+        inline int32_t GetNumRegions() const { return static_cast<int32_t>(Regions_.size()); }
+        inline int32_t GetNumRows() const { return NumRows_; }
+        inline int32_t GetNumColumns() const { return NumColumns_; }
+
+    protected:
+        struct KRegion
+        {
+            // position and size in image coordinates, may extend beyond the image
+            cv::Rect Bounds;
+
+            // CV_8UC1 of the size of Bounds, empty for rectangles
+            cv::Mat Mask;
+
+            int32_t Bias;
+            bool bProtected;
+        };
+
+        KRegionId AddRegion(const KRegion& Region);
+
+        /**
+         * @brief adds (Sign = 1) or removes (Sign = -1) the pixels of Region to or from the planes
+         */
+        void Rasterize(const KRegion& Region, int32_t Sign);
+
+        /**
+         * @brief recalculates the bias span of every row from the bounds of the biased regions
+         */
+        void UpdateBiasSpans();
+
+        int32_t NumRows_;
+        int32_t NumColumns_;
+
+        std::map<KRegionId, KRegion> Regions_;
+        KRegionId NextRegionId_;
+        int32_t NumBiasedRegions_;
+
+        // number of protected regions covering every pixel, so overlapping regions can be
+        //      removed one at a time
+        KMatrix2D<uint16_t> ProtectionCounts_;
+        KBitMask2D ProtectedPixels_;
+
+        KMatrix2D<int32_t> Biases_;
+        std::vector<KColumnSpan> BiasSpans_;
+    };
+}
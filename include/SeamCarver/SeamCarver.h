@@ -1,28 +1,80 @@
 #pragma once
 #include <opencv2/opencv.hpp>
-#include "ConstSizeMinBinaryHeap.h"
+#include <array>
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <vector>
 #include "PixelEnergy2D.h"
+#include "BitMask2D.h"
+#include "EnergyPolicies.h"
+#include "EnergyTraits.h"
+#include "Matrix2D.h"
+#include "ProtectionMask.h"
+#include "SeamIndexMap.h"
+#include "SeamCarverStats.h"
+#include "SeamSearchReport.h"
+#include "SeamCarverKernels.h"
+#include "ThreadPool.h"
 
 using std::vector;
 
 namespace ct
 {
-    typedef void(*energyFunc)(const cv::Mat& img, vector<vector<double>>& outPixelEnergy);
-    typedef vector<ConstSizeMinBinaryHeap<int32_t>> VectorOfMinPQ;
+    template<typename EnergyType>
+    using energyFuncT = void(*)(const cv::Mat& img, KMatrix2D<EnergyType>& outPixelEnergy);
+    typedef energyFuncT<double> energyFunc;
 
-    class KSeamCarver
+    /**
+     * @brief seams found by one search, in a single allocation. Row r of a vertical seam matrix
+     *      holds the columns of the seam pixels in image row r in increasing order, row c of a
+     *      horizontal seam matrix holds the rows of the seam pixels in image column c
+     */
+    typedef KMatrix2D<int32_t> KSeamMatrix;
+
+    /**
+     * @brief what a vertical seam costs
+     */
+    enum class KSeamCost : uint8_t
+    {
+        // sum of the energies of the removed pixels
+        Backward,
+
+        // sum of the energies of the edges that removing the pixels creates between their
+        //      neighbors (Rubinstein et al.), see CalculateForwardCumulativeEnergyRowScalar
+        Forward
+    };
+
+    /**
+     * @brief content-aware image resizing. EnergyType is the type of pixel energies and
+     *      cumulative path energies, double or int32_t. Dual-gradient energies are integers, so
+     *      both find the same seams as long as no path saturates (see KEnergyTraits), but int32_t
+     *      moves half the memory and fits twice as many pixels in a SIMD register
+     */
+    template<typename EnergyType>
+    class KSeamCarverT
     {
     public:
-        KSeamCarver(double MarginEnergy = 390150.0) : CMarginEnergy(MarginEnergy),
+        typedef energyFuncT<EnergyType> KEnergyFunc;
+
+        KSeamCarverT(EnergyType MarginEnergy = 390150) : CMarginEnergy(MarginEnergy),
             NumRows_(0),
             NumColumns_(0),
             BottomRow_(0),
             RightColumn_(0),
-            PosInf_(std::numeric_limits<double>::max()),
-            PixelEnergyCalculator_(MarginEnergy)
+            PosInf_(KEnergyTraits<EnergyType>::PosInf()),
+            PixelEnergyCalculator_(new KPixelEnergy2DT<EnergyType>(MarginEnergy)),
+            CumulativeEnergyRowKernel_(SeamCarverKernels::SelectCumulativeEnergyRowKernel<EnergyType>()),
+            ForwardCumulativeEnergyRowKernel_(
+                SeamCarverKernels::SelectForwardCumulativeEnergyRowKernel<EnergyType>()),
+            ForwardCostImage_(nullptr),
+            SearchProtection_(nullptr),
+            SearchDeadline_(std::chrono::steady_clock::time_point::max()),
+            SearchReport_(nullptr),
+            StatsScopeDepth_(0)
         {}
 
-        virtual ~KSeamCarver() {}
+        virtual ~KSeamCarverT() {}
 
         /**
          * @brief find and remove vertical seams
@@ -36,52 +88,675 @@ namespace ct
         virtual bool FindAndRemoveVerticalSeams(int32_t numSeams,
                                                 const cv::Mat& img,
                                                 cv::Mat& outImg,
-                                                ct::energyFunc computeEnergyFn = nullptr);
+                                                KEnergyFunc computeEnergyFn = nullptr);
+
+        /**
+         * @brief find and remove vertical seams, trading seam quality for time once Deadline has
+         *      passed. Until then seams are found exactly as without a deadline. After it, a seam
+         *      whose path runs into an earlier seam is detoured around it on the outdated
+         *      cumulative energies, and when no path is left a seam is walked down greedily
+         *      instead of recalculating the cumulative energies. Only when that fails too are they
+         *      recalculated. The cheaper seams are less regular, so when most columns are removed
+         *      they can leave no path for the last seams where the exact search would still find one
+         * @param NumSeams: number of vertical seams to remove
+         * @param img: input image
+         * @param outImg: output paramter
+         * @param Deadline: time after which cheaper strategies are used
+         * @param OutReport: output parameter, strategy of every seam. May be nullptr
+         * @param computeEnergyFn: pointer to a user-defined energy function. If one is not provided,
+         *      internal one will be used
+         * @return bool: indicates whether seam removal was successful or not
+         */
+        virtual bool FindAndRemoveVerticalSeams(int32_t NumSeams,
+                                                const cv::Mat& img,
+                                                cv::Mat& outImg,
+                                                const std::chrono::steady_clock::time_point& Deadline,
+                                                KSeamSearchReport* OutReport,
+                                                KEnergyFunc computeEnergyFn = nullptr);
+
+        /**
+         * @brief find and remove vertical seams with the given seam cost. Forward energy carves
+         *      with fewer artifacts, since seams avoid pixels whose removal would join pixels that
+         *      differ. Its transition costs are computed row by row from the image within the
+         *      cumulative path energy pass. Pixel energies only keep seams off marked pixels then
+         * @param NumSeams: number of vertical seams to remove
+         * @param img: input image, 8 bits per channel for forward energy
+         * @param outImg: output paramter
+         * @param SeamCost: backward or forward energy
+         * @param computeEnergyFn: pointer to a user-defined energy function. If one is not provided,
+         *      internal one will be used
+         * @return bool: indicates whether seam removal was successful or not
+         */
+        virtual bool FindAndRemoveVerticalSeams(int32_t NumSeams,
+                                                const cv::Mat& img,
+                                                cv::Mat& outImg,
+                                                KSeamCost SeamCost,
+                                                KEnergyFunc computeEnergyFn = nullptr);
+
+        /**
+         * @brief find and remove vertical seams around the regions of a protection mask. Protected
+         *      pixels are marked for this call only by combining the protected plane of the mask
+         *      with the marked pixels 64 pixels at a time, and biases are only added within the
+         *      bias spans of the mask, so a mask kept between frames is applied without visiting
+         *      every pixel
+         * @param NumSeams: number of vertical seams to remove
+         * @param img: input image
+         * @param outImg: output paramter
+         * @param Protection: regions of img, with the dimensions of img
+         * @param computeEnergyFn: pointer to a user-defined energy function. If one is not provided,
+         *      internal one will be used
+         * @return bool: indicates whether seam removal was successful or not, false if the
+         *      protected pixels leave fewer than NumSeams paths
+         */
+        virtual bool FindAndRemoveVerticalSeams(int32_t NumSeams,
+                                                const cv::Mat& img,
+                                                cv::Mat& outImg,
+                                                const KProtectionMask& Protection,
+                                                KEnergyFunc computeEnergyFn = nullptr);
+
+        /**
+         * @brief enlarges the image by inserting a pixel next to every pixel of NumSeams vertical
+         *      seams. All seams are found by one seam search, the same one used for removal, and
+         *      the wider image is written in a single pass
+         * @param NumSeams: number of vertical seams to insert, at most the number of columns
+         * @param img: input image, 8 bits per channel
+         * @param outImg: output paramter, NumSeams columns wider than img
+         * @param computeEnergyFn: pointer to a user-defined energy function. If one is not provided,
+         *      internal one will be used
+         * @return bool: indicates whether seam insertion was successful or not
+         */
+        virtual bool FindAndInsertVerticalSeams(int32_t NumSeams,
+                                                const cv::Mat& img,
+                                                cv::Mat& outImg,
+                                                KEnergyFunc computeEnergyFn = nullptr);
+
+        /**
+         * @brief find and remove horizontal seams. Works on the image as is, without transposing it
+         * @param NumSeams: number of horizontal seams to remove
+         * @param img: input image
+         * @param outImg: output paramter
+         * @param computeEnergyFn: pointer to a user-defined energy function. If one is not provided,
+         *      internal one will be used
+         * @return bool: indicates whether seam removal was successful or not
+         */
+        virtual bool FindAndRemoveHorizontalSeams(int32_t NumSeams,
+                                                  const cv::Mat& img,
+                                                  cv::Mat& outImg,
+                                                  KEnergyFunc computeEnergyFn = nullptr);
+
+        /**
+         * @brief removes vertical seams one at a time. After every seam only the energy of the
+         *      pixels next to it is recomputed, so every seam is found on the exact energy of the
+         *      current image. Slower than FindAndRemoveVerticalSeams, but with higher quality
+         * @param NumSeams: number of vertical seams to remove
+         * @param img: input image
+         * @param outImg: output paramter
+         * @return bool: indicates whether seam removal was successful or not
+         */
+        virtual bool FindAndRemoveVerticalSeamsIteratively(int32_t NumSeams,
+                                                           const cv::Mat& img,
+                                                           cv::Mat& outImg);
+
+        /**
+         * @brief removes NumSeams vertical seams one at a time like
+         *      FindAndRemoveVerticalSeamsIteratively and records for every pixel the index of the
+         *      seam that removed it. The map then retargets img to any width between img.cols and
+         *      img.cols - NumSeams without searching seams again
+         * @param NumSeams: number of vertical seams to record, at most KSeamIndexMap::CMaxNumSeams
+         * @param img: input image
+         * @param OutSeamIndexMap: output parameter
+         * @return bool: indicates whether all seams were found
+         */
+        virtual bool ComputeSeamIndexMap(int32_t NumSeams, const cv::Mat& img, KSeamIndexMap& OutSeamIndexMap);
+
+        /**
+         * @brief shrinks img to Size by removing vertical and horizontal seams one at a time. Every
+         *      step finds the cheapest seam of each direction that still needs seams and removes
+         *      the one with the lower mean pixel energy, a greedy estimate of the optimal order of
+         *      vertical and horizontal seams. Both directions share one pixel energy buffer that
+         *      is only recomputed next to every removed seam, as in
+         *      FindAndRemoveVerticalSeamsIteratively
+         * @param Size: size of outImg, no larger than img in either dimension
+         * @param img: input image
+         * @param outImg: output paramter
+         * @return bool: indicates whether seam removal was successful or not
+         */
+        virtual bool RetargetTo(const cv::Size& Size, const cv::Mat& img, cv::Mat& outImg);
+
+        /**
+         * @brief find and remove vertical seams on an image pyramid. The seams are found on an
+         *      image halved NumLevels times, then refined level by level within a band around the
+         *      upsampled seams of the coarser level. Every level has half as many seams as the
+         *      one above it. Energies are only calculated within the bands, so large images are
+         *      carved many times faster than by FindAndRemoveVerticalSeams. The seams are only
+         *      optimal within their bands: more levels are faster, wider bands find better seams
+         * @param NumSeams: number of vertical seams to remove
+         * @param img: input image, 8 bits per channel
+         * @param outImg: output paramter
+         * @param NumLevels: number of times the image is halved. Levels are skipped once the image
+         *      gets too small for the seams
+         * @param BandHalfWidth: number of columns searched on each side of an upsampled seam
+         * @return bool: indicates whether seam removal was successful or not
+         */
+        virtual bool FindAndRemoveVerticalSeamsCoarseToFine(int32_t NumSeams,
+                                                            const cv::Mat& img,
+                                                            cv::Mat& outImg,
+                                                            int32_t NumLevels = 3,
+                                                            int32_t BandHalfWidth = 4);
+
+        /**
+         * @brief sets the number of threads used for the pixel energy and the cumulative path
+         *      energy. Both share one thread pool
+         * @param NumThreads: 1 computes serially, 0 uses every hardware thread
+         */
+        virtual void SetNumThreads(int32_t NumThreads);
+
+        /**
+         * @brief calculates the pixel energy of every following call with EnergyPolicy instead of
+         *      the dual-gradient energy, see EnergyPolicies.h. The policy is a template parameter,
+         *      so its energy is inlined into the row loop, and the energy function pointer of the
+         *      calls is only needed for energies that are chosen at run time
+         * @param Policy: energy policy, may carry state
+         */
+        template<typename EnergyPolicy>
+        void SetEnergyPolicy(const EnergyPolicy& Policy = EnergyPolicy())
+        {
+            PixelEnergyCalculator_.reset(new KPolicyPixelEnergy2DT<EnergyType, EnergyPolicy>(CMarginEnergy, Policy));
+            PixelEnergyCalculator_->SetThreadPool(ThreadPool_);
+
+            // the coarser pyramid levels are searched with a copy of the old policy
+            Workspace_.CoarseCarver.reset();
+        }
+
+        /**
+         * @brief returns the number of threads used to find seams
+         */
+        virtual int32_t GetNumThreads() const;
+
+        /**
+         * @brief frees the buffers kept between calls. They are allocated again by the next call
+         */
+        virtual void ReleaseWorkspace();
+
+        /**
+         * @brief returns the timings and counters of the last call that carved an image
+         */
+        const KSeamCarverStats& GetStats() const { return Stats_; }
 
     protected:
+        /**
+         * @brief calculates the energy of every pixel of img with the energy policy, or with
+         *      computeEnergyFn if one is given
+         * @param img: input image
+         * @param OutPixelEnergy: output parameter, energy of every pixel of img
+         * @param computeEnergyFn: pointer to a user-defined energy function, may be nullptr
+         * @return bool: indicates whether the energy could be calculated
+         */
+        bool CalculateImageEnergy(const cv::Mat& img, KMatrix2D<EnergyType>& OutPixelEnergy,
+                                  KEnergyFunc computeEnergyFn);
+
+        /**
+         * @brief buffers of the seam searches. They are kept between calls and only grow, so after
+         *      the first frame carving frames of the same size allocates nothing
+         */
+        struct KWorkspace
+        {
+            typedef std::pair<int32_t, int32_t> KColumnSpan;
+
+            KMatrix2D<EnergyType> PixelEnergy;
+
+            // cumulative path energies, with one padding column on each side for vertical paths
+            KMatrix2D<EnergyType> TotalEnergyTo;
+
+            // back-pointer offsets, ColumnTo of vertical and RowTo of horizontal paths
+            KMatrix2D<int8_t> ParentOffsets;
+
+            KSeamMatrix Seams;
+
+            // upsampled seams of the coarser pyramid level, searched around at full resolution
+            KSeamMatrix GuideSeams;
+
+            // pixels of the seams found by the current search
+            KBitMask2D SeamPixels;
+
+            // copy of the input that seams are removed from one at a time
+            cv::Mat Image;
+
+            // cumulative path energies and back-pointers of horizontal paths, searched next to the
+            //      vertical ones by RetargetTo
+            KMatrix2D<EnergyType> HorizontalTotalEnergyTo;
+            KMatrix2D<int8_t> HorizontalParentOffsets;
+
+            vector<int32_t> CurrentSeam;
+            vector<int32_t> CurrentHorizontalSeam;
+            vector<int32_t> SeamsSinceRecalculation;
+            vector<int32_t> InvalidatedColumns;
+
+            // per column counters of the horizontal seams
+            vector<int32_t> ColumnCounts;
+
+            // state of RecalculateCumulativeVerticalPathEnergy
+            vector<KColumnSpan> DirtySpans;
+            vector<KColumnSpan> ChangedSpans;
+            vector<EnergyType> PreviousTotalEnergyTo;
+
+            // forward energy transition costs of the row being calculated: up, up/left and up/right
+            KMatrix2D<EnergyType> ForwardCosts;
+
+            // protected pixels that were not marked before the current call
+            KBitMask2D ProtectionMarks;
+
+            // MarkedPixels before the current call, restored once the seams removed one at a time
+            //      have shifted it together with the image
+            KBitMask2D SavedMarkedPixels;
+
+            // next coarser pyramid level: its image, its seams and the carver searching it, which
+            //      keeps the buffers of that level and of the levels below it in its own workspace.
+            //      Created by the first coarse-to-fine search, see FindVerticalSeamsCoarseToFine
+            cv::Mat CoarseImage;
+            KSeamMatrix CoarseSeams;
+            std::unique_ptr<KSeamCarverT<EnergyType>> CoarseCarver;
+
+            static const int32_t CNumBuffers = 23;
+            typedef std::array<size_t, CNumBuffers> KBufferSizes;
+
+            /**
+             * @brief writes the bytes allocated by every buffer to OutSizes
+             */
+            void GetBufferSizes(KBufferSizes& OutSizes) const
+            {
+                OutSizes = {{
+                    PixelEnergy.GetAllocatedBytes(),
+                    TotalEnergyTo.GetAllocatedBytes(),
+                    ParentOffsets.GetAllocatedBytes(),
+                    Seams.GetAllocatedBytes(),
+                    GuideSeams.GetAllocatedBytes(),
+                    SeamPixels.GetAllocatedBytes(),
+                    Image.step[0] * Image.rows,
+                    HorizontalTotalEnergyTo.GetAllocatedBytes(),
+                    HorizontalParentOffsets.GetAllocatedBytes(),
+                    CurrentSeam.capacity() * sizeof(int32_t),
+                    CurrentHorizontalSeam.capacity() * sizeof(int32_t),
+                    SeamsSinceRecalculation.capacity() * sizeof(int32_t),
+                    InvalidatedColumns.capacity() * sizeof(int32_t),
+                    ColumnCounts.capacity() * sizeof(int32_t),
+                    DirtySpans.capacity() * sizeof(KColumnSpan),
+                    ChangedSpans.capacity() * sizeof(KColumnSpan),
+                    PreviousTotalEnergyTo.capacity() * sizeof(EnergyType),
+                    ForwardCosts.GetAllocatedBytes(),
+                    ProtectionMarks.GetAllocatedBytes(),
+                    SavedMarkedPixels.GetAllocatedBytes(),
+                    CoarseImage.step[0] * CoarseImage.rows,
+                    CoarseSeams.GetAllocatedBytes(),
+                    CoarseCarver == nullptr ? 0 : CoarseCarver->Workspace_.GetTotalSize()
+                }};
+            }
+
+            /**
+             * @brief returns the bytes allocated by all buffers, including those of the coarser
+             *      pyramid levels
+             */
+            size_t GetTotalSize() const
+            {
+                KBufferSizes Sizes;
+                GetBufferSizes(Sizes);
+                size_t TotalSize = 0;
+                for (size_t Size : Sizes)
+                {
+                    TotalSize += Size;
+                }
+                return TotalSize;
+            }
+        };
+
+        /**
+         * @brief collects Stats_ over one public call. Constructing it resets the stats, destroying
+         *      it adds the total time and the workspace sizes. Scopes of nested calls, e.g. from
+         *      an overload, are part of the outermost one
+         */
+        class KStatsScope
+        {
+        public:
+            explicit KStatsScope(KSeamCarverT<EnergyType>& Carver);
+            ~KStatsScope();
+
+        private:
+            KSeamCarverT<EnergyType>& Carver_;
+            std::chrono::steady_clock::time_point Start_;
+            typename KWorkspace::KBufferSizes BufferSizes_;
+        };
+
         /**
          * @brief find vertical seams for later removal
-         * @param PixelEnergy: calculated pixel energy of image
-         * @param OutDiscoveredSeams: output parameter (vector of priority queues)
+         * @param PixelEnergy: calculated pixel energy of image. The energy of every marked pixel
+         *      is set to +INF, see ApplyMarkedPixelSentinel
+         * @param OutDiscoveredSeams: output parameter, NumRows_ x NumSeams (see KSeamMatrix)
+         * @return bool: indicates success, false if no unmarked seam was left before
+         *      NumSeams seams were found
+         */
+        virtual bool FindVerticalSeams(int32_t NumSeams, KMatrix2D<EnergyType>& PixelEnergy,
+                                       KSeamMatrix& OutDiscoveredSeams);
+
+        /**
+         * @brief removes NumSeams vertical seams from Image one at a time, each found on the exact
+         *      energy of the image left by the ones before, see FindAndRemoveVerticalSeamsIteratively
+         * @param Image: image with the dimensions set by the caller. Seams are removed in place by
+         *      shifting pixels to the left, the result is its left NumColumns_ columns
+         * @param OutSeamIndexMap: if not nullptr, CV_16UC1 map of the input size. The pixels
+         *      removed by seam n are set to n
+         * @return bool: indicates whether all seams were found
+         */
+        virtual bool RemoveVerticalSeamsIteratively(int32_t NumSeams, cv::Mat& Image, cv::Mat* OutSeamIndexMap);
+
+        /**
+         * @brief finds the vertical seam with the least energy in the current image, using the
+         *      cumulative energy buffers of the workspace
+         * @param PixelEnergy: energy of the current image, +INF for marked pixels
+         * @param OutSeam: output parameter, column of the seam in every row
+         * @param OutSeamEnergy: output parameter, total energy of the seam
+         * @return bool: false if every path runs into a marked pixel
+         */
+        bool FindCheapestVerticalSeam(const KMatrix2D<EnergyType>& PixelEnergy, vector<int32_t>& OutSeam,
+                                      EnergyType& OutSeamEnergy);
+
+        /**
+         * @brief finds the horizontal seam with the least energy in the current image, see
+         *      FindCheapestVerticalSeam
+         * @param OutSeam: output parameter, row of the seam in every column
+         */
+        bool FindCheapestHorizontalSeam(const KMatrix2D<EnergyType>& PixelEnergy, vector<int32_t>& OutSeam,
+                                        EnergyType& OutSeamEnergy);
+
+        /**
+         * @brief recomputes the energy of the pixels whose neighbors changed when Seam was removed
+         *      in place. Called with the dimensions of the image without the seam
+         * @param Image: image the seam was removed from, only its top left NumRows_ x NumColumns_
+         *      pixels are used
+         * @param PixelEnergyBuffer: energy of Image, with the stride of Image's full width
+         * @param Seam: column of the removed seam in every row
+         * @return bool: indicates if the operation was successful
+         */
+        bool UpdatePixelEnergyAroundVerticalSeam(const cv::Mat& Image, KMatrix2D<EnergyType>& PixelEnergyBuffer,
+                                                 const vector<int32_t>& Seam);
+
+        /**
+         * @brief recomputes the energy of the pixels whose neighbors changed when Seam was removed
+         *      in place, see UpdatePixelEnergyAroundVerticalSeam
+         * @param Seam: row of the removed seam in every column
+         */
+        bool UpdatePixelEnergyAroundHorizontalSeam(const cv::Mat& Image, KMatrix2D<EnergyType>& PixelEnergyBuffer,
+                                                   const vector<int32_t>& Seam);
+
+        /**
+         * @brief finds NumSeams vertical seams in img on an image pyramid, see
+         *      FindAndRemoveVerticalSeamsCoarseToFine. Sets the dimensions to those of img. The
+         *      coarsest level, and every level whose bands run out of unmarked paths, is searched
+         *      exactly by FindVerticalSeams
+         * @param img: input image of this level
+         * @param NumLevels: number of coarser levels below this one
+         * @param BandHalfWidth: number of columns searched on each side of an upsampled seam
+         * @param OutDiscoveredSeams: output parameter, img.rows x NumSeams (see KSeamMatrix)
          * @return bool: indicates success
          */
-        virtual bool FindVerticalSeams(int32_t NumSeams, vector<vector<double>>& PixelEnergy,
-                                       VectorOfMinPQ& OutDiscoveredSeams);
+        virtual bool FindVerticalSeamsCoarseToFine(int32_t NumSeams, const cv::Mat& img,
+                                                   int32_t NumLevels, int32_t BandHalfWidth,
+                                                   KSeamMatrix& OutDiscoveredSeams);
+
+        /**
+         * @brief finds NumSeams vertical seams, every one within HalfWidth columns of its guide
+         *      seam. Only the cumulative energies of these bands are calculated, so the search
+         *      costs NumSeams x NumRows_ x (2 x HalfWidth + 1) instead of a pass over the image per
+         *      recalculation. The k-th smallest seam columns of all rows form a connected seam, so
+         *      the columns of a seam matrix can be used as guides, and several seams may share one
+         * @param PixelEnergy: calculated pixel energy of image, only needed within the bands. The
+         *      energy of every marked pixel and of every pixel of the new seams is set to +INF
+         * @param GuideSeams: NumRows_ x NumSeams, column k holds the guide of seam k. Guides must
+         *      move by at most one column from row to row
+         * @param HalfWidth: number of columns searched on each side of the guide
+         * @param MaxHalfWidth: a band cut off by the seams found before it is searched again at
+         *      twice the width, up to this many columns on each side of the guide
+         * @param OutDiscoveredSeams: output parameter, NumRows_ x NumSeams (see KSeamMatrix)
+         * @return bool: false if a seam has no unmarked path within its widest band.
+         *      MarkedPixels is then left as it was
+         */
+        virtual bool FindVerticalSeamsInBands(int32_t NumSeams, KMatrix2D<EnergyType>& PixelEnergy,
+                                              const KSeamMatrix& GuideSeams, int32_t HalfWidth,
+                                              int32_t MaxHalfWidth, KSeamMatrix& OutDiscoveredSeams);
+
+        /**
+         * @brief writes the columns of the seam pixels in every row to OutDiscoveredSeams
+         * @param SeamPixels: pixels of NumSeams disjoint vertical seams
+         * @param OutDiscoveredSeams: output parameter, NumRows_ x NumSeams (see KSeamMatrix)
+         */
+        void CollectVerticalSeams(const KBitMask2D& SeamPixels, KSeamMatrix& OutDiscoveredSeams);
+
+        /**
+         * @brief walks a seam from the top row down, always to the unmarked neighbor of lowest
+         *      pixel energy in the row below. Used instead of recalculating the cumulative energies
+         *      once the search deadline has passed
+         * @param PixelEnergy: calculated pixel energy of image, +INF for marked pixels
+         * @param OutSeam: output parameter, column of the seam in every row
+         * @return bool: false if the walks from CMaxGreedyAttempts_ start columns all ran into a
+         *      row without an unmarked neighbor
+         */
+        bool FindGreedyVerticalSeam(const KMatrix2D<EnergyType>& PixelEnergy, vector<int32_t>& OutSeam);
 
         /**
         * @brief calculates the energy required to reach bottom row and saves the column of the
-        *       pixel in the row above to get to every pixel
-        * @param PixelEnergy: calculated pixel energy of image
-        * @param OutTotalEnergyTo: cumulative energy to reach pixel
-        * @param OutColumnTo: columnn of the pixel in the row above to get to every pixel
+        *       pixel in the row above to get to every pixel. Marked pixels are recognized by their
+        *       pixel energy of +INF, not by MarkedPixels
+        * @param PixelEnergy: calculated pixel energy of image, +INF for marked pixels
+        * @param OutTotalEnergyTo: cumulative energy to reach pixel. Columns -1 and NumColumns_ of
+        *       every row must be allocated, they are set to +INF so edge pixels need no bounds checks
+        * @param OutColumnTo: offset (-1, 0 or 1) to the columnn of the pixel in the row above to
+        *       get to every pixel, SeamCarverKernels::CNoParentOffset for unreachable pixels
         */
         virtual void CalculateCumulativeVerticalPathEnergy(
-            const vector<vector<double>>& PixelEnergy,
-            vector<vector<double>>& OutTotalEnergyTo,
-            vector<vector<int32_t>>& OutColumnTo);
+            const KMatrix2D<EnergyType>& PixelEnergy,
+            KMatrix2D<EnergyType>& OutTotalEnergyTo,
+            KMatrix2D<int8_t>& OutColumnTo);
 
         /**
-         * @brief remove vertical seam from img given by column locations stored in seam
-         * @param bgr image separate into 3 channels (BLUE GREEN RED)
-         * @param seams vector of priority queues that hold the columns for the pixels to remove
-         *              for each row, where the index into the vector is the row number
+         * @brief calculates the cumulative energy of the columns [StartColumn, EndColumn) of Row
+         *      (Row > 0) from the row above with the row kernel. With ForwardCostImage_ set, the
+         *      transition costs of those columns are computed first and the forward kernel is used
+         * @param PixelEnergy: calculated pixel energy of image, +INF for marked pixels
+         * @param Row: row to calculate
+         * @param StartColumn: first column to calculate (inclusive)
+         * @param EndColumn: last column to calculate (exclusive)
+         * @param OutTotalEnergyTo: cumulative energy to reach pixel
+         * @param OutColumnTo: offset to the columnn of the pixel in the row above to get to every pixel
          */
-        virtual void RemoveVerticalSeams(vector<cv::Mat>& bgr, VectorOfMinPQ& seams);
+        void CalculateCumulativeVerticalPathEnergyRow(const KMatrix2D<EnergyType>& PixelEnergy,
+                                                      int32_t Row,
+                                                      int32_t StartColumn,
+                                                      int32_t EndColumn,
+                                                      KMatrix2D<EnergyType>& OutTotalEnergyTo,
+                                                      KMatrix2D<int8_t>& OutColumnTo);
 
-        // vector to store pixels that have been previously MarkedPixels for removal
+        /**
+         * @brief brings the cumulative energies up to date after seams were marked. Only the cone
+         *      of pixels below the newly marked pixels is recalculated, row by row, and the cone
+         *      narrows to the pixels whose cumulative energy actually changed. The result is
+         *      identical to CalculateCumulativeVerticalPathEnergy
+         * @param PixelEnergy: calculated pixel energy of image
+         * @param ChangedSeams: columns of the seams marked since the last calculation, NumRows_
+         *      columns per seam
+         * @param InvalidatedColumns: bottom row columns whose cumulative energy was set to +INF
+         * @param OutTotalEnergyTo: cumulative energy to reach pixel
+         * @param OutColumnTo: offset to the columnn of the pixel in the row above to get to every pixel
+         */
+        virtual void RecalculateCumulativeVerticalPathEnergy(
+            const KMatrix2D<EnergyType>& PixelEnergy,
+            const vector<int32_t>& ChangedSeams,
+            const vector<int32_t>& InvalidatedColumns,
+            KMatrix2D<EnergyType>& OutTotalEnergyTo,
+            KMatrix2D<int8_t>& OutColumnTo);
+
+        /**
+         * @brief sets the energy of the marked pixels in columns [StartColumn, EndColumn) of Row
+         *      to +INF. The vertical path energy then needs no mask: a marked pixel can never be
+         *      reached and never be a parent, exactly like a pixel that is skipped for being marked
+         * @param PixelEnergy: calculated pixel energy of image
+         * @param Row: row of the pixels
+         * @param StartColumn: first column (inclusive)
+         * @param EndColumn: last column (exclusive)
+         */
+        void ApplyMarkedPixelSentinel(KMatrix2D<EnergyType>& PixelEnergy, int32_t Row,
+                                      int32_t StartColumn, int32_t EndColumn);
+
+        /**
+         * @brief adds the biases of SearchProtection_ to the pixel energies within its bias spans
+         * @param PixelEnergy: calculated pixel energy of image, before marked pixels are set to +INF
+         */
+        void ApplyProtectionBias(KMatrix2D<EnergyType>& PixelEnergy);
+
+        /**
+         * @brief writes img without the vertical seams to outImg. Works on the interleaved pixels
+         *      of any number of channels, and rows run in parallel if a thread pool is set
+         * @param img: input image
+         * @param seams: sorted columns of the pixels to remove for each row
+         * @param outImg: output parameter
+         */
+        virtual void RemoveVerticalSeams(const cv::Mat& img, const KSeamMatrix& seams, cv::Mat& outImg);
+
+        /**
+         * @brief writes img with a new pixel after every seam pixel to outImg. The new pixel is
+         *      the average of the seam pixel and its right neighbor (left neighbor in the right
+         *      column)
+         * @param img: input image
+         * @param seams: sorted columns of the seam pixels for each row
+         * @param outImg: output parameter
+         */
+        virtual void InsertVerticalSeams(const cv::Mat& img, const KSeamMatrix& seams, cv::Mat& outImg);
+
+        /**
+         * @brief find horizontal seams for later removal
+         * @param PixelEnergy: calculated pixel energy of image
+         * @param OutDiscoveredSeams: output parameter, NumColumns_ x NumSeams (see KSeamMatrix)
+         * @return bool: indicates success, false if no unmarked seam was left before
+         *      NumSeams seams were found
+         */
+        virtual bool FindHorizontalSeams(int32_t NumSeams, const KMatrix2D<EnergyType>& PixelEnergy,
+                                         KSeamMatrix& OutDiscoveredSeams);
+
+        /**
+         * @brief calculates the energy required to reach the right column and saves the row of the
+         *      pixel in the column to the left to get to every pixel
+         * @param PixelEnergy: calculated pixel energy of image
+         * @param OutTotalEnergyTo: cumulative energy to reach pixel
+         * @param OutRowTo: offset (-1, 0 or 1) to the row of the pixel in the column to the left to
+         *      get to every pixel, SeamCarverKernels::CNoParentOffset for unreachable pixels
+         */
+        virtual void CalculateCumulativeHorizontalPathEnergy(
+            const KMatrix2D<EnergyType>& PixelEnergy,
+            KMatrix2D<EnergyType>& OutTotalEnergyTo,
+            KMatrix2D<int8_t>& OutRowTo);
+
+        /**
+         * @brief writes img without the horizontal seams to outImg, shifting the pixels below
+         *      every removed pixel up within its column
+         * @param img: input image
+         * @param seams: sorted rows of the pixels to remove for each column
+         * @param outImg: output parameter
+         */
+        virtual void RemoveHorizontalSeams(const cv::Mat& img, const KSeamMatrix& seams, cv::Mat& outImg);
+
+        /**
+         * @brief removes one vertical seam by shifting the pixels to its right one column to the
+         *      left, in place. Image, PixelEnergy and MarkedPixels are shifted alike
+         * @param Image: interleaved image, only its left NumColumns_ columns are used
+         * @param PixelEnergy: energy of the image
+         * @param Seam: column of the seam in every row
+         */
+        virtual void RemoveVerticalSeamInPlace(cv::Mat& Image, KMatrix2D<EnergyType>& PixelEnergy,
+                                               const vector<int32_t>& Seam);
+
+        /**
+         * @brief removes one horizontal seam by shifting the pixels below it one row up, in place.
+         *      Image, PixelEnergy and MarkedPixels are shifted alike
+         * @param Image: interleaved image, only its top NumRows_ rows are used
+         * @param PixelEnergy: energy of the image
+         * @param Seam: row of the seam in every column
+         */
+        virtual void RemoveHorizontalSeamInPlace(cv::Mat& Image, KMatrix2D<EnergyType>& PixelEnergy,
+                                                 const vector<int32_t>& Seam);
+
+        // mask (one bit per pixel) of pixels that have been previously MarkedPixels for removal
         // will ignore these MarkedPixels pixels when searching for a new seam
-        vector<vector<bool>> MarkedPixels;
+        KBitMask2D MarkedPixels;
 
         // default energy at the borders of the image
-        const double CMarginEnergy;
+        const EnergyType CMarginEnergy;
 
         int32_t NumRows_;
         int32_t NumColumns_;
         int32_t BottomRow_;
         int32_t RightColumn_;
-        double PosInf_;
+        EnergyType PosInf_;
+
+        // calculates the pixel energy with the energy policy, see SetEnergyPolicy
+        std::unique_ptr<KPixelEnergy2DT<EnergyType>> PixelEnergyCalculator_;
+
+        KWorkspace Workspace_;
+
+        // computes one row of the cumulative path energy, picked for the CPU at construction
+        SeamCarverKernels::KCumulativeEnergyRowKernelT<EnergyType> CumulativeEnergyRowKernel_;
+        SeamCarverKernels::KForwardCumulativeEnergyRowKernelT<EnergyType> ForwardCumulativeEnergyRowKernel_;
+
+        // image the forward energy transition costs are computed from, nullptr for backward energy
+        const cv::Mat* ForwardCostImage_;
+
+        // biased regions of the current call, nullptr if the call has no protection mask
+        const KProtectionMask* SearchProtection_;
+
+        // threads computing bands of columns in parallel, nullptr when computing serially
+        std::shared_ptr<KThreadPool> ThreadPool_;
 
-        KPixelEnergy2D PixelEnergyCalculator_;
+        // rows depend on each other, so the threads synchronize after every row. Bands must be
+        //      wide enough for that synchronization to pay off
+        const int32_t CMinColumnsPerBand_ = 1024;
+
+        // smallest band of rows handed to one thread when rows are independent
+        const int32_t CMinRowsPerBand_ = 16;
+
+        // pyramid levels are no smaller than this many rows and columns
+        const int32_t CMinPyramidLevelSize_ = 32;
+
+        // bands around upsampled or tracked seams may widen to this multiple of their width
+        const int32_t CMaxBandWideningFactor_ = 4;
+
+        // start columns tried by FindGreedyVerticalSeam before it gives up
+        static const int32_t CMaxGreedyAttempts_ = 8;
+
+        // after this time FindVerticalSeams switches to cheaper strategies, time_point::max() for
+        //      searches without a deadline
+        std::chrono::steady_clock::time_point SearchDeadline_;
+
+        // strategy of every seam found by FindVerticalSeams, nullptr if not requested
+        KSeamSearchReport* SearchReport_;
+
+        // timings and counters of the last call, see KStatsScope
+        KSeamCarverStats Stats_;
+
+        // number of KStatsScope currently open
+        int32_t StatsScopeDepth_;
     };
 
+    typedef KSeamCarverT<double> KSeamCarver;
+
+    /**
+     * @brief seam carver with the energy policy as part of its type, e.g.
+     *      KPolicySeamCarverT<int32_t, KSobelEnergy>
+     */
+    template<typename EnergyType, typename EnergyPolicy>
+    class KPolicySeamCarverT : public KSeamCarverT<EnergyType>
+    {
+    public:
+        explicit KPolicySeamCarverT(const EnergyPolicy& Policy = EnergyPolicy(), EnergyType MarginEnergy = 390150) :
+            KSeamCarverT<EnergyType>(MarginEnergy)
+        {
+            this->SetEnergyPolicy(Policy);
+        }
+    };
 }
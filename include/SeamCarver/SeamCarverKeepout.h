@@ -2,6 +2,7 @@
 #include <opencv2/opencv.hpp>
 #include <stdint.h>
 #include "SeamCarver.h"
+#include "ProtectionMask.h"
 
 
 namespace ct {
@@ -21,13 +22,16 @@ namespace ct {
   class SeamCarverKeepout : public KSeamCarver {
   public:
     SeamCarverKeepout(int32_t row, int32_t col, int32_t height, int32_t width, double margin_energy = 390150.0) :
-      KSeamCarver(margin_energy), keepoutRegionExists_(true), keepoutRegion_(row, col, height, width) {}
+      KSeamCarver(margin_energy), keepoutRegionExists_(false), keepoutRegionId_(KProtectionMask::CInvalidRegionId) {
+      setKeepoutRegion(row, col, height, width);
+    }
 
     SeamCarverKeepout(double margin_energy = 390150.0) :
-      KSeamCarver(margin_energy), keepoutRegionExists_(false) {}
+      KSeamCarver(margin_energy), keepoutRegionExists_(false), keepoutRegionId_(KProtectionMask::CInvalidRegionId) {}
 
     /**
-     * @brief find and remove vertical seams
+     * @brief find and remove vertical seams around the keepout region and the regions of the
+     *      protection mask
      * @param numSeams number of vertical seams to remove
      * @param img input image
      * @param outImg output paramter
@@ -49,9 +53,19 @@ namespace ct {
      * @brief deletes the keepout region
      */
     void deleteKeepoutRegion();
+
+    /**
+     * @brief returns the protection mask holding the keepout region. Further protected and biased
+     *      regions may be added to it, they are kept when the image size changes
+     */
+    KProtectionMask& getProtectionMask() { return protectionMask_; }
   protected:
     KeepoutRegionStruct keepoutRegion_;
     bool keepoutRegionExists_;
+
+    // the keepout region is one region of the mask, rasterized only when it changes
+    KProtectionMask protectionMask_;
+    KProtectionMask::KRegionId keepoutRegionId_;
   };
  
 }
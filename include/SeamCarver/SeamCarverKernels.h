@@ -0,0 +1,208 @@
+#pragma once
+#include <stdint.h>
+#include "CpuFeatures.h"
+
+namespace ct
+{
+    namespace SeamCarverKernels
+    {
+        /**
+         * @brief back-pointers only ever point to one of three parents, so they are stored as one
+         *      byte offsets instead of columns. Pixels without a parent get this offset
+         */
+        const int8_t CNoParentOffset = -128;
+
+        /**
+         * @brief Computes one row of the cumulative vertical path energy for the columns in
+         *      [StartColumn, EndColumn). Every pixel picks the cheapest of the up, up/right and
+         *      up/left pixels of the previous row (ties are resolved in that order). Marked pixels
+         *      carry PosInf as their energy instead of being looked up in a mask, so the recurrence
+         *      is a branchless min of three. Pixels with an energy of PosInf or without a parent
+         *      below PosInf get PosInf and CNoParentOffset. Every kernel exists for double and
+         *      int32_t energies
+         * @param PrevTotalEnergyTo: cumulative energy of the previous row. Columns -1 and
+         *      NumColumns are padding and must hold PosInf
+         * @param PixelEnergy: energy of the current row, PosInf for marked pixels
+         * @param StartColumn: first column to compute (inclusive)
+         * @param EndColumn: last column to compute (exclusive)
+         * @param PosInf: value representing +INF
+         * @param OutTotalEnergyTo: cumulative energy of the current row
+         * @param OutColumnOffsetTo: offset (-1, 0 or 1) from the column of every pixel to the
+         *      column of the pixel in the previous row used to reach it, CNoParentOffset if the
+         *      pixel is unreachable
+         */
+        template<typename EnergyType>
+        using KCumulativeEnergyRowKernelT = void(*)(const EnergyType* PrevTotalEnergyTo,
+                                                    const EnergyType* PixelEnergy,
+                                                    int32_t StartColumn, int32_t EndColumn,
+                                                    EnergyType PosInf,
+                                                    EnergyType* OutTotalEnergyTo,
+                                                    int8_t* OutColumnOffsetTo);
+        typedef KCumulativeEnergyRowKernelT<double> KCumulativeEnergyRowKernel;
+
+        void CalculateCumulativeEnergyRowScalar(const double* PrevTotalEnergyTo,
+                                                const double* PixelEnergy,
+                                                int32_t StartColumn, int32_t EndColumn,
+                                                double PosInf,
+                                                double* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+
+        // sums saturate below PosInf, see KEnergyTraits<int32_t>
+        void CalculateCumulativeEnergyRowScalar(const int32_t* PrevTotalEnergyTo,
+                                                const int32_t* PixelEnergy,
+                                                int32_t StartColumn, int32_t EndColumn,
+                                                int32_t PosInf,
+                                                int32_t* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+
+#ifdef CT_X86_SIMD
+        // 2 pixels per iteration for double and 4 for int32_t, requires SSE4.1
+        void CalculateCumulativeEnergyRowSSE41(const double* PrevTotalEnergyTo,
+                                               const double* PixelEnergy,
+                                               int32_t StartColumn, int32_t EndColumn,
+                                               double PosInf,
+                                               double* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+        void CalculateCumulativeEnergyRowSSE41(const int32_t* PrevTotalEnergyTo,
+                                               const int32_t* PixelEnergy,
+                                               int32_t StartColumn, int32_t EndColumn,
+                                               int32_t PosInf,
+                                               int32_t* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+
+        // 4 pixels per iteration for double and 8 for int32_t, requires AVX2
+        void CalculateCumulativeEnergyRowAVX2(const double* PrevTotalEnergyTo,
+                                              const double* PixelEnergy,
+                                              int32_t StartColumn, int32_t EndColumn,
+                                              double PosInf,
+                                              double* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+        void CalculateCumulativeEnergyRowAVX2(const int32_t* PrevTotalEnergyTo,
+                                              const int32_t* PixelEnergy,
+                                              int32_t StartColumn, int32_t EndColumn,
+                                              int32_t PosInf,
+                                              int32_t* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+#endif
+
+        /**
+         * @brief Picks the fastest cumulative energy kernel supported by the CPU
+         */
+        template<typename EnergyType = double>
+        KCumulativeEnergyRowKernelT<EnergyType> SelectCumulativeEnergyRowKernel();
+
+        /**
+         * @brief Computes one row of the cumulative vertical path energy with forward energy
+         *      (Rubinstein et al.). Instead of adding the energy of the pixel, every pixel adds
+         *      the cost of the transition from its parent, the energy of the edges that removing
+         *      both pixels creates between their neighbors. Pixel energies only mark pixels: those
+         *      with PosInf are unreachable, all other values are ignored. Ties, unreachable pixels
+         *      and saturation are handled like KCumulativeEnergyRowKernelT
+         * @param PrevTotalEnergyTo: cumulative energy of the previous row. Columns -1 and
+         *      NumColumns are padding and must hold PosInf
+         * @param PixelEnergy: energy of the current row, PosInf for marked pixels
+         * @param UpCost: cost of reaching every pixel from the pixel above, see
+         *      CalculateForwardCostRow
+         * @param UpLeftCost: cost of reaching every pixel from the pixel above and to the left
+         * @param UpRightCost: cost of reaching every pixel from the pixel above and to the right
+         * @param StartColumn: first column to compute (inclusive)
+         * @param EndColumn: last column to compute (exclusive)
+         * @param PosInf: value representing +INF
+         * @param OutTotalEnergyTo: cumulative energy of the current row
+         * @param OutColumnOffsetTo: offset (-1, 0 or 1) from the column of every pixel to the
+         *      column of its parent, CNoParentOffset if the pixel is unreachable
+         */
+        template<typename EnergyType>
+        using KForwardCumulativeEnergyRowKernelT = void(*)(const EnergyType* PrevTotalEnergyTo,
+                                                           const EnergyType* PixelEnergy,
+                                                           const EnergyType* UpCost,
+                                                           const EnergyType* UpLeftCost,
+                                                           const EnergyType* UpRightCost,
+                                                           int32_t StartColumn, int32_t EndColumn,
+                                                           EnergyType PosInf,
+                                                           EnergyType* OutTotalEnergyTo,
+                                                           int8_t* OutColumnOffsetTo);
+
+        void CalculateForwardCumulativeEnergyRowScalar(const double* PrevTotalEnergyTo,
+                                                       const double* PixelEnergy,
+                                                       const double* UpCost,
+                                                       const double* UpLeftCost,
+                                                       const double* UpRightCost,
+                                                       int32_t StartColumn, int32_t EndColumn,
+                                                       double PosInf,
+                                                       double* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+        void CalculateForwardCumulativeEnergyRowScalar(const int32_t* PrevTotalEnergyTo,
+                                                       const int32_t* PixelEnergy,
+                                                       const int32_t* UpCost,
+                                                       const int32_t* UpLeftCost,
+                                                       const int32_t* UpRightCost,
+                                                       int32_t StartColumn, int32_t EndColumn,
+                                                       int32_t PosInf,
+                                                       int32_t* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+
+#ifdef CT_X86_SIMD
+        // 2 pixels per iteration for double and 4 for int32_t, requires SSE4.1
+        void CalculateForwardCumulativeEnergyRowSSE41(const double* PrevTotalEnergyTo,
+                                                      const double* PixelEnergy,
+                                                      const double* UpCost,
+                                                      const double* UpLeftCost,
+                                                      const double* UpRightCost,
+                                                      int32_t StartColumn, int32_t EndColumn,
+                                                      double PosInf,
+                                                      double* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+        void CalculateForwardCumulativeEnergyRowSSE41(const int32_t* PrevTotalEnergyTo,
+                                                      const int32_t* PixelEnergy,
+                                                      const int32_t* UpCost,
+                                                      const int32_t* UpLeftCost,
+                                                      const int32_t* UpRightCost,
+                                                      int32_t StartColumn, int32_t EndColumn,
+                                                      int32_t PosInf,
+                                                      int32_t* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+
+        // 4 pixels per iteration for double and 8 for int32_t, requires AVX2
+        void CalculateForwardCumulativeEnergyRowAVX2(const double* PrevTotalEnergyTo,
+                                                     const double* PixelEnergy,
+                                                     const double* UpCost,
+                                                     const double* UpLeftCost,
+                                                     const double* UpRightCost,
+                                                     int32_t StartColumn, int32_t EndColumn,
+                                                     double PosInf,
+                                                     double* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+        void CalculateForwardCumulativeEnergyRowAVX2(const int32_t* PrevTotalEnergyTo,
+                                                     const int32_t* PixelEnergy,
+                                                     const int32_t* UpCost,
+                                                     const int32_t* UpLeftCost,
+                                                     const int32_t* UpRightCost,
+                                                     int32_t StartColumn, int32_t EndColumn,
+                                                     int32_t PosInf,
+                                                     int32_t* OutTotalEnergyTo, int8_t* OutColumnOffsetTo);
+#endif
+
+        /**
+         * @brief Picks the fastest forward cumulative energy kernel supported by the CPU
+         */
+        template<typename EnergyType = double>
+        KForwardCumulativeEnergyRowKernelT<EnergyType> SelectForwardCumulativeEnergyRowKernel();
+
+        /**
+         * @brief Computes the forward energy transition costs of the columns [StartColumn,
+         *      EndColumn) of one row of an 8-bit interleaved image. Removing a pixel joins its left
+         *      and right neighbor, which costs UpCost = |right - left|. If the seam comes from the
+         *      upper left, the pixel above also becomes a neighbor of the left one, which adds
+         *      |above - left| to UpLeftCost, and likewise |above - right| to UpRightCost.
+         *      Differences are summed over all channels, pixels beyond the edges repeat the edge
+         *      pixel. At most 3 * 2 * 255 = 1530 for BGR images
+         * @param Above: first byte of the row above
+         * @param Current: first byte of the current row
+         * @param NumColumns: width of the image
+         * @param NumChannels: number of channels of the image
+         * @param StartColumn: first column to compute (inclusive)
+         * @param EndColumn: last column to compute (exclusive)
+         * @param OutUpCost: cost of reaching every pixel from the pixel above, indexed by column
+         * @param OutUpLeftCost: cost of reaching every pixel from the pixel above and to the left
+         * @param OutUpRightCost: cost of reaching every pixel from the pixel above and to the right
+         */
+        void CalculateForwardCostRow(const uint8_t* Above, const uint8_t* Current,
+                                     int32_t NumColumns, int32_t NumChannels,
+                                     int32_t StartColumn, int32_t EndColumn,
+                                     double* OutUpCost, double* OutUpLeftCost, double* OutUpRightCost);
+        void CalculateForwardCostRow(const uint8_t* Above, const uint8_t* Current,
+                                     int32_t NumColumns, int32_t NumChannels,
+                                     int32_t StartColumn, int32_t EndColumn,
+                                     int32_t* OutUpCost, int32_t* OutUpLeftCost, int32_t* OutUpRightCost);
+    }
+}
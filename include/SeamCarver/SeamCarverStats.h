@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace ct
+{
+    /**
+     * @brief counters and timings of the last call of a KSeamCarverT, see KSeamCarverT::GetStats
+     */
+    struct KSeamCarverStats
+    {
+        typedef std::chrono::steady_clock::duration KDuration;
+
+        // wall time of the whole call
+        KDuration TotalTime = KDuration::zero();
+
+        // wall time of every phase. Searches that compute pixel energies while they search, like
+        //      the coarse-to-fine search, count that time as seam search
+        KDuration EnergyTime = KDuration::zero();
+        KDuration SeamSearchTime = KDuration::zero();
+
+        // writing the output image without the removed (or with the inserted) seams
+        KDuration SeamRemovalTime = KDuration::zero();
+
+        // number of times the cumulative path energies were recalculated after seams marked
+        //      pixels that other paths went through
+        int32_t NumRecalculations = 0;
+
+        // seams discarded because their path ran into a marked pixel
+        int32_t NumRejectedSeams = 0;
+
+        // bytes the workspace allocated during the call, 0 once its buffers are large enough
+        size_t NumBytesAllocated = 0;
+
+        // bytes held by the workspace after the call
+        size_t WorkspaceSize = 0;
+
+        // most bytes held by the workspace after any call since the carver was created or its
+        //      workspace released
+        size_t PeakWorkspaceSize = 0;
+
+        // message of the exception that made the call return false, empty if nothing was thrown
+        std::string ErrorMessage;
+    };
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <stdint.h>
+#include <string>
+
+namespace ct
+{
+    /**
+     * @brief order in which vertical seams remove the pixels of an image, see
+     *      KSeamCarverT::ComputeSeamIndexMap. Every pixel holds the 16 bit index of the seam that
+     *      removes it, so the map is a CV_16UC1 image and can be saved losslessly as a 16 bit PNG.
+     *      Every row holds every seam index exactly once, so removing the first k seams keeps the
+     *      pixels with an index of at least k, and retargeting to any width between the width of
+     *      the image and GetMinWidth() is a single pass over the pixels
+     */
+    class KSeamIndexMap
+    {
+    public:
+        // index of the pixels no seam removes
+        static const uint16_t CKeptPixel = UINT16_MAX;
+
+        // every seam index is below CKeptPixel
+        static const int32_t CMaxNumSeams = UINT16_MAX;
+
+        KSeamIndexMap() : NumSeams_(0) {}
+
+        /**
+         * @brief copies a map computed before
+         * @param SeamIndexMap: CV_16UC1 seam index of every pixel, CKeptPixel for pixels no seam
+         *      removes
+         * @return bool: false if SeamIndexMap is not a CV_16UC1 map whose rows all hold every
+         *      seam index exactly once
+         */
+        bool Assign(const cv::Mat& SeamIndexMap);
+
+        /**
+         * @brief writes img without the first img.cols - Width seams to outImg
+         * @param img: the image the map was computed for
+         * @param Width: width of outImg, between GetMinWidth() and img.cols
+         * @param outImg: output parameter, may be img
+         * @return bool: false if img does not match the map or Width is out of range
+         */
+        bool Retarget(const cv::Mat& img, int32_t Width, cv::Mat& outImg) const;
+
+        /**
+         * @brief saves the map as an image file, it must be a format that keeps 16 bits per pixel
+         *      such as PNG
+         */
+        bool Save(const std::string& FileName) const;
+
+        /**
+         * @brief loads a map saved by Save
+         */
+        bool Load(const std::string& FileName);
+
+        /**
+         * @brief returns the number of seams recorded in the map
+         */
+        int32_t GetNumSeams() const { return NumSeams_; }
+
+        /**
+         * @brief returns the width of the image with every recorded seam removed
+         */
+        int32_t GetMinWidth() const { return Map_.cols - NumSeams_; }
+
+        const cv::Mat& GetMap() const { return Map_; }
+
+    protected:
+        cv::Mat Map_;
+        int32_t NumSeams_;
+    };
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+namespace ct
+{
+    /**
+     * @brief how a seam was found by a search with a deadline, from best to cheapest
+     */
+    enum class KSeamStrategy : uint8_t
+    {
+        // minimum of the cumulative energies, as found without a deadline
+        Exact,
+
+        // path of the outdated cumulative energies, detoured around the pixels of seams found
+        //      since they were calculated
+        StaleEnergy,
+
+        // walk from the top row to the lowest energy neighbor in every row below
+        GreedyDescent
+    };
+
+    /**
+     * @brief how the seams of one search were found, see KSeamCarverT::FindAndRemoveVerticalSeams
+     */
+    struct KSeamSearchReport
+    {
+        // strategy of every seam, in the order the seams were found
+        std::vector<KSeamStrategy> Strategies;
+
+        // number of times the cumulative energies were brought up to date
+        int32_t NumRecalculations = 0;
+
+        // true if the deadline passed before the last seam was found
+        bool bDeadlineReached = false;
+
+        void Clear()
+        {
+            Strategies.clear();
+            NumRecalculations = 0;
+            bDeadlineReached = false;
+        }
+
+        int32_t CountSeams(KSeamStrategy Strategy) const
+        {
+            return static_cast<int32_t>(std::count(Strategies.begin(), Strategies.end(), Strategy));
+        }
+    };
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <stdint.h>
+#include "SeamCarver.h"
+
+namespace ct
+{
+    /**
+     * @brief removes vertical seams from the frames of a video or camera stream. Consecutive
+     *      frames of a stream barely change, so instead of searching every frame from scratch the
+     *      seams of the previous frame are tracked: every seam is searched again only within a
+     *      window of columns around where it was in the previous frame. This is much cheaper than
+     *      a full search and keeps the seams, and with them the carved content, from jumping
+     *      between frames. A full search is run for the first frame, whenever the frame size or
+     *      the number of seams changes, when a seam cannot be tracked and when the frame differs
+     *      too much from the previous one (scene change)
+     */
+    template<typename EnergyType>
+    class KStreamingSeamCarverT : public KSeamCarverT<EnergyType>
+    {
+    public:
+        typedef typename KSeamCarverT<EnergyType>::KEnergyFunc KEnergyFunc;
+
+        KStreamingSeamCarverT(EnergyType MarginEnergy = 390150) : KSeamCarverT<EnergyType>(MarginEnergy),
+            SearchHalfWidth_(8),
+            SceneChangeThreshold_(24.0),
+            bLastFrameFullSearch_(false)
+        {}
+
+        virtual ~KStreamingSeamCarverT() {}
+
+        /**
+         * @brief removes NumSeams vertical seams from the next frame of the stream
+         * @param NumSeams: number of vertical seams to remove
+         * @param Frame: next frame of the stream
+         * @param OutFrame: output parameter, NumSeams columns narrower than Frame
+         * @param computeEnergyFn: pointer to a user-defined energy function. If one is not
+         *      provided, internal one will be used
+         * @return bool: indicates whether seam removal was successful or not
+         */
+        virtual bool CarveFrame(int32_t NumSeams, const cv::Mat& Frame, cv::Mat& OutFrame,
+                                KEnergyFunc computeEnergyFn = nullptr);
+
+        /**
+         * @brief forgets the previous frame, so the next frame gets a full search
+         */
+        virtual void Reset();
+
+        /**
+         * @brief sets the number of columns searched on each side of the previous position of a
+         *      seam. Wider windows follow faster motion but cost more. A window cut off by other
+         *      seams is widened up to CMaxBandWideningFactor_ times, then the frame gets a full
+         *      search
+         * @param HalfWidth: number of columns, at least 1
+         */
+        void SetSearchHalfWidth(int32_t HalfWidth);
+
+        /**
+         * @brief sets the mean absolute difference per channel between a frame and the previous
+         *      one above which a full search is run. Only 8 bit frames are compared, frames of
+         *      other depths always get a full search
+         * @param Threshold: difference in 0 - 255
+         */
+        void SetSceneChangeThreshold(double Threshold);
+
+        /**
+         * @brief returns true if the seams of the last frame came from a full search
+         */
+        bool WasLastFrameFullSearch() const { return bLastFrameFullSearch_; }
+
+    protected:
+        /**
+         * @brief returns true if Frame differs from PreviousFrame_ by more than
+         *      SceneChangeThreshold_, comparing a sparse grid of pixels
+         */
+        bool IsSceneChange(const cv::Mat& Frame) const;
+
+        /**
+         * @brief computes the pixel energy of Frame into the workspace
+         */
+        bool CalculateFrameEnergy(const cv::Mat& Frame, KEnergyFunc computeEnergyFn);
+
+        // columns searched on each side of the previous position of a seam
+        int32_t SearchHalfWidth_;
+
+        // mean absolute difference per channel (0 - 255) between frames that starts a full search
+        double SceneChangeThreshold_;
+
+        bool bLastFrameFullSearch_;
+
+        // previous frame and its seams, empty before the first frame and after Reset
+        cv::Mat PreviousFrame_;
+        KSeamMatrix PreviousSeams_;
+
+        // only every CSceneSampleStep-th row and column is compared to detect a scene change
+        const int32_t CSceneSampleStep_ = 4;
+    };
+
+    typedef KStreamingSeamCarverT<double> KStreamingSeamCarver;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ct
+{
+    class KThreadPool
+    {
+    public:
+        /**
+         * @brief Creates a pool with NumThreads participating threads. The thread calling
+         *      ParallelFor always participates, so NumThreads - 1 worker threads are created
+         * @param NumThreads: total number of threads, 0 selects the number of hardware threads
+         */
+        explicit KThreadPool(int32_t NumThreads = 0);
+
+        /**
+         * @brief Stops and joins all worker threads
+         */
+        ~KThreadPool();
+
+        KThreadPool(const KThreadPool& rhs) = delete;
+        KThreadPool& operator=(const KThreadPool& rhs) = delete;
+
+        /**
+         * @brief Returns the total number of threads participating in ParallelFor
+         */
+        int32_t GetNumThreads() const;
+
+        /**
+         * @brief Splits [Begin, End) into contiguous chunks and runs Function(ChunkBegin, ChunkEnd)
+         *      on every chunk, using all threads of the pool. Blocks until every chunk is done
+         * @param Begin: first index (inclusive)
+         * @param End: last index (exclusive)
+         * @param Function: work to run on one chunk
+         * @param MinChunkSize: smallest number of indices given to one chunk. Ranges smaller than
+         *      twice this value run on the calling thread only
+         */
+        void ParallelFor(int32_t Begin, int32_t End,
+                         const std::function<void(int32_t, int32_t)>& Function,
+                         int32_t MinChunkSize = 1);
+
+        /**
+         * @brief Runs Function(TaskIndex) for every TaskIndex in [0, NumTasks), every task on its
+         *      own thread and all of them at the same time, so tasks may wait on each other (e.g.
+         *      with a KSpinBarrier). Blocks until every task is done
+         * @param NumTasks: number of tasks, clamped to GetNumThreads()
+         * @param Function: work to run for one task
+         * @return int32_t: number of tasks that were run
+         */
+        int32_t RunConcurrently(int32_t NumTasks, const std::function<void(int32_t)>& Function);
+
+    protected:
+        /**
+         * @brief Main loop of every worker thread
+         */
+        void WorkerLoop();
+
+        /**
+         * @brief Claims and runs chunks of the current job until none are left
+         */
+        void RunChunks();
+
+        std::vector<std::thread> Workers_;
+
+        // serializes concurrent callers of ParallelFor
+        std::mutex JobMutex_;
+
+        // protects the job description below and the shutdown flag
+        std::mutex StateMutex_;
+        std::condition_variable JobAvailable_;
+        std::condition_variable JobFinished_;
+
+        // incremented for every job so workers can tell a new job from a spurious wakeup
+        uint64_t JobGeneration_;
+        bool bShutdown_;
+
+        // current job
+        const std::function<void(int32_t, int32_t)>* JobFunction_;
+        int32_t JobBegin_;
+        int32_t JobEnd_;
+        int32_t JobChunkSize_;
+        int32_t JobNumChunks_;
+
+        // number of worker threads currently running chunks of the job
+        int32_t NumActiveWorkers_;
+
+        std::atomic<int32_t> NextChunk_;
+        std::atomic<int32_t> RemainingChunks_;
+    };
+
+    /**
+     * @brief Reusable barrier for a fixed number of threads that are all running at the same
+     *      time, e.g. tasks of KThreadPool::RunConcurrently. Spins briefly, then yields
+     */
+    class KSpinBarrier
+    {
+    public:
+        explicit KSpinBarrier(int32_t NumThreads);
+
+        KSpinBarrier(const KSpinBarrier& rhs) = delete;
+        KSpinBarrier& operator=(const KSpinBarrier& rhs) = delete;
+
+        /**
+         * @brief Blocks until all NumThreads threads have called Wait
+         */
+        void Wait();
+
+    protected:
+        const int32_t NumThreads_;
+        std::atomic<int32_t> NumWaiting_;
+
+        // incremented every time the barrier opens
+        std::atomic<uint32_t> Generation_;
+    };
+}
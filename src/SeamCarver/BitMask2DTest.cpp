@@ -0,0 +1,110 @@
+#include "BitMask2D.h"
+#include "gtest/gtest.h"
+#include <vector>
+
+
+TEST(BitMask2D, MarkAndFindUnmarked)
+{
+    ct::KBitMask2D Mask(3, 130);
+    EXPECT_EQ(Mask.GetNumRows(), 3);
+    EXPECT_EQ(Mask.GetNumColumns(), 130);
+    EXPECT_EQ(Mask.GetNumWords(), 3);
+    EXPECT_EQ(Mask.CountUnmarked(), 3 * 130);
+
+    // mark everything but columns 70 and 129 of row 1
+    Mask.Fill(true);
+    EXPECT_EQ(Mask.CountUnmarked(), 0);
+    Mask.Unmark(1, 70);
+    Mask.Unmark(1, 129);
+
+    EXPECT_TRUE(Mask.IsMarked(1, 0));
+    EXPECT_FALSE(Mask.IsMarked(1, 70));
+    EXPECT_EQ(Mask.CountUnmarked(1), 2);
+    EXPECT_EQ(Mask.FindFirstUnmarked(1, 0), 70);
+    EXPECT_EQ(Mask.FindFirstUnmarked(1, 70), 70);
+    EXPECT_EQ(Mask.FindFirstUnmarked(1, 71), 129);
+    EXPECT_EQ(Mask.FindFirstUnmarked(1, 130), -1);
+
+    // bits past the last column never count as unmarked
+    EXPECT_EQ(Mask.FindFirstUnmarked(0, 0), -1);
+    EXPECT_EQ(Mask.CountUnmarked(0), 0);
+}
+
+TEST(BitMask2D, FindMarked)
+{
+    ct::KBitMask2D Mask(2, 130);
+    Mask.Mark(1, 3);
+    Mask.Mark(1, 128);
+
+    EXPECT_EQ(Mask.FindFirstMarked(1, 0), 3);
+    EXPECT_EQ(Mask.FindFirstMarked(1, 3), 3);
+    EXPECT_EQ(Mask.FindFirstMarked(1, 4), 128);
+    EXPECT_EQ(Mask.FindFirstMarked(1, 129), -1);
+    EXPECT_EQ(Mask.FindFirstMarked(0, 0), -1);
+}
+
+TEST(BitMask2D, Or)
+{
+    ct::KBitMask2D Mask(2, 100);
+    ct::KBitMask2D Other(2, 100);
+    Mask.Mark(0, 3);
+    Other.Mark(0, 99);
+    Other.Mark(1, 64);
+
+    EXPECT_TRUE(Mask.Or(Other));
+    EXPECT_TRUE(Mask.IsMarked(0, 3));
+    EXPECT_TRUE(Mask.IsMarked(0, 99));
+    EXPECT_TRUE(Mask.IsMarked(1, 64));
+    EXPECT_EQ(Mask.CountUnmarked(), 200 - 3);
+
+    ct::KBitMask2D WrongSize(2, 101);
+    EXPECT_FALSE(Mask.Or(WrongSize));
+}
+
+TEST(BitMask2D, AndNot)
+{
+    ct::KBitMask2D Mask(2, 100);
+    ct::KBitMask2D Other(2, 100);
+    Mask.Fill(true);
+    Other.Mark(0, 3);
+    Other.Mark(1, 64);
+    Other.Mark(1, 99);
+
+    EXPECT_TRUE(Mask.AndNot(Other));
+    EXPECT_FALSE(Mask.IsMarked(0, 3));
+    EXPECT_FALSE(Mask.IsMarked(1, 64));
+    EXPECT_FALSE(Mask.IsMarked(1, 99));
+    EXPECT_TRUE(Mask.IsMarked(1, 63));
+    EXPECT_EQ(Mask.CountUnmarked(), 3);
+
+    ct::KBitMask2D WrongSize(3, 100);
+    EXPECT_FALSE(Mask.AndNot(WrongSize));
+}
+
+TEST(BitMask2D, EraseColumnMatchesShiftingBools)
+{
+    const int32_t NumColumns = 200;
+    ct::KBitMask2D Mask(1, NumColumns);
+    std::vector<bool> Expected(NumColumns, false);
+    for (int32_t Column = 0; Column < NumColumns; Column++)
+    {
+        if ((Column * 7) % 3 == 0 || Column % 64 == 63)
+        {
+            Mask.Mark(0, Column);
+            Expected[Column] = true;
+        }
+    }
+
+    // erase columns on both sides of word boundaries
+    for (int32_t Column : { 0, 63, 64, 127, 5, 150 })
+    {
+        Mask.EraseColumn(0, Column);
+        Expected.erase(Expected.begin() + Column);
+        Expected.push_back(false);
+
+        for (int32_t Index = 0; Index < NumColumns; Index++)
+        {
+            ASSERT_EQ(Mask.IsMarked(0, Index), Expected[Index]);
+        }
+    }
+}
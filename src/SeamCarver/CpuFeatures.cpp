@@ -0,0 +1,70 @@
+#include "CpuFeatures.h"
+
+#if defined(CT_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+
+namespace
+{
+    struct KCpuidFeatures
+    {
+        bool bHasSSE41 = false;
+        bool bHasAVX2 = false;
+
+        KCpuidFeatures()
+        {
+            int Registers[4] = { 0 };
+            __cpuid(Registers, 0);
+            int MaxLeaf = Registers[0];
+
+            if (MaxLeaf >= 1)
+            {
+                __cpuid(Registers, 1);
+                bHasSSE41 = (Registers[2] & (1 << 19)) != 0;
+
+                // AVX registers are only usable if the OS saves them on context switches
+                bool bOSXSave = (Registers[2] & (1 << 27)) != 0;
+                bool bAVX = (Registers[2] & (1 << 28)) != 0;
+                bool bOSSavesYMM = bOSXSave && ((_xgetbv(0) & 0x6) == 0x6);
+
+                if (MaxLeaf >= 7 && bAVX && bOSSavesYMM)
+                {
+                    __cpuidex(Registers, 7, 0);
+                    bHasAVX2 = (Registers[1] & (1 << 5)) != 0;
+                }
+            }
+        }
+    };
+
+    const KCpuidFeatures& GetCpuidFeatures()
+    {
+        static const KCpuidFeatures Features;
+        return Features;
+    }
+}
+#endif
+
+bool ct::KCpuFeatures::HasSSE41()
+{
+#if !defined(CT_X86_SIMD)
+    return false;
+#elif defined(_MSC_VER)
+    return GetCpuidFeatures().bHasSSE41;
+#else
+    // __builtin_cpu_init is required if this is first called during static initialization
+    static const bool bHasSSE41 = []() { __builtin_cpu_init(); return __builtin_cpu_supports("sse4.1") != 0; }();
+    return bHasSSE41;
+#endif
+}
+
+bool ct::KCpuFeatures::HasAVX2()
+{
+#if !defined(CT_X86_SIMD)
+    return false;
+#elif defined(_MSC_VER)
+    return GetCpuidFeatures().bHasAVX2;
+#else
+    static const bool bHasAVX2 = []() { __builtin_cpu_init(); return __builtin_cpu_supports("avx2") != 0; }();
+    return bHasAVX2;
+#endif
+}
@@ -0,0 +1,186 @@
+#include "EnergyPolicies.h"
+#include "SeamCarver.h"
+#include "SeamCarverTestHelpers.h"
+#include "gtest/gtest.h"
+
+namespace
+{
+    using ct::test::IsEqual;
+    using ct::test::MakeRandomImage;
+
+    // straightforward |Gx| + |Gy| of a 3 x 3 kernel, used as the reference for the policies
+    int32_t ReferenceGradientEnergy(const cv::Mat& Image, int32_t Row, int32_t Column, const int32_t Kernel[3][3])
+    {
+        const int32_t NumChannels = Image.channels();
+        int32_t Energy = 0;
+        for (int32_t Channel = 0; Channel < NumChannels; Channel++)
+        {
+            int32_t GradientX = 0;
+            int32_t GradientY = 0;
+            for (int32_t DeltaRow = -1; DeltaRow <= 1; DeltaRow++)
+            {
+                for (int32_t DeltaColumn = -1; DeltaColumn <= 1; DeltaColumn++)
+                {
+                    const int32_t Value = Image.ptr<uint8_t>(Row + DeltaRow)[(Column + DeltaColumn) * NumChannels + Channel];
+                    GradientX += Kernel[DeltaRow + 1][DeltaColumn + 1] * Value;
+                    GradientY += Kernel[DeltaColumn + 1][DeltaRow + 1] * Value;
+                }
+            }
+            Energy += std::abs(GradientX) + std::abs(GradientY);
+        }
+        return Energy;
+    }
+
+    const int32_t CSobelKernel[3][3] = { { -1, 0, 1 }, { -2, 0, 2 }, { -1, 0, 1 } };
+    const int32_t CScharrKernel[3][3] = { { -3, 0, 3 }, { -10, 0, 10 }, { -3, 0, 3 } };
+
+    void CalculateSobelEnergy(const cv::Mat& img, ct::KMatrix2D<int32_t>& outPixelEnergy)
+    {
+        for (int32_t Row = 0; Row < img.rows; Row++)
+        {
+            for (int32_t Column = 0; Column < img.cols; Column++)
+            {
+                const bool bBorder = Row == 0 || Column == 0 || Row == img.rows - 1 || Column == img.cols - 1;
+                outPixelEnergy[Row][Column] = bBorder ? 390150 : ReferenceGradientEnergy(img, Row, Column, CSobelKernel);
+            }
+        }
+    }
+
+    // the dual-gradient energy as a policy of its own, so it is calculated by the generic row loop
+    struct KScalarDualGradientEnergy : public ct::KDualGradientEnergy
+    {
+    };
+
+    // stateful policy
+    struct KScaledForwardEnergy
+    {
+        int32_t Scale = 1;
+
+        template<int32_t NumChannels>
+        int32_t Calculate(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below) const
+        {
+            return Scale * ct::KForwardEnergy().Calculate<NumChannels>(Above, Current, Below);
+        }
+    };
+
+    template<typename EnergyType, typename EnergyPolicy>
+    ct::KMatrix2D<EnergyType> CalculatePolicyEnergy(const cv::Mat& Image,
+                                                    const EnergyPolicy& Policy = EnergyPolicy())
+    {
+        ct::KPolicyPixelEnergy2DT<EnergyType, EnergyPolicy> Calculator(390150, Policy);
+        Calculator.SetDimensions(Image.cols, Image.rows, Image.channels());
+        ct::KMatrix2D<EnergyType> PixelEnergy;
+        EXPECT_TRUE(Calculator.CalculatePixelEnergy(Image, PixelEnergy));
+        return PixelEnergy;
+    }
+}
+
+TEST(EnergyPolicies, ScalarDualGradientMatchesKernels)
+{
+    for (int32_t NumChannels = 1; NumChannels <= 3; NumChannels += 2)
+    {
+        cv::Mat Image = MakeRandomImage(29, 71, NumChannels, 3);
+
+        ct::KPixelEnergy2DT<int32_t> KernelCalculator(Image);
+        ct::KMatrix2D<int32_t> Expected;
+        ASSERT_TRUE(KernelCalculator.CalculatePixelEnergy(Image, Expected));
+
+        ct::KMatrix2D<int32_t> Int32Energy = CalculatePolicyEnergy<int32_t, KScalarDualGradientEnergy>(Image);
+        ct::KMatrix2D<double> DoubleEnergy = CalculatePolicyEnergy<double, KScalarDualGradientEnergy>(Image);
+        for (int32_t Row = 0; Row < Image.rows; Row++)
+        {
+            for (int32_t Column = 0; Column < Image.cols; Column++)
+            {
+                ASSERT_EQ(Int32Energy[Row][Column], Expected[Row][Column]);
+                ASSERT_EQ(DoubleEnergy[Row][Column], Expected[Row][Column]);
+            }
+        }
+    }
+}
+
+TEST(EnergyPolicies, MatchReferenceEnergies)
+{
+    for (int32_t NumChannels = 1; NumChannels <= 3; NumChannels += 2)
+    {
+        cv::Mat Image = MakeRandomImage(17, 33, NumChannels, 9);
+        ct::KMatrix2D<int32_t> Sobel = CalculatePolicyEnergy<int32_t, ct::KSobelEnergy>(Image);
+        ct::KMatrix2D<int32_t> Scharr = CalculatePolicyEnergy<int32_t, ct::KScharrEnergy>(Image);
+        ct::KMatrix2D<int32_t> Forward = CalculatePolicyEnergy<int32_t, ct::KForwardEnergy>(Image);
+        ct::KMatrix2D<int32_t> Luma = CalculatePolicyEnergy<int32_t, ct::KLumaEnergy>(Image);
+
+        for (int32_t Row = 1; Row < Image.rows - 1; Row++)
+        {
+            const uint8_t* Above = Image.ptr<uint8_t>(Row - 1);
+            const uint8_t* Current = Image.ptr<uint8_t>(Row);
+            const uint8_t* Below = Image.ptr<uint8_t>(Row + 1);
+            for (int32_t Column = 1; Column < Image.cols - 1; Column++)
+            {
+                ASSERT_EQ(Sobel[Row][Column], ReferenceGradientEnergy(Image, Row, Column, CSobelKernel));
+                ASSERT_EQ(Scharr[Row][Column], ReferenceGradientEnergy(Image, Row, Column, CScharrKernel));
+
+                int32_t ExpectedForward = 0;
+                for (int32_t Channel = 0; Channel < NumChannels; Channel++)
+                {
+                    ExpectedForward += std::abs(Current[(Column + 1) * NumChannels + Channel] -
+                                                Current[(Column - 1) * NumChannels + Channel]);
+                }
+                ASSERT_EQ(Forward[Row][Column], ExpectedForward);
+
+                // luma of a grayscale pixel is its value
+                auto GetLuma = [NumChannels](const uint8_t* Pixels, int32_t Column)
+                {
+                    const uint8_t* Pixel = Pixels + Column * NumChannels;
+                    return NumChannels == 1 ? Pixel[0] : (29 * Pixel[0] + 150 * Pixel[1] + 77 * Pixel[2] + 128) >> 8;
+                };
+                const int32_t DeltaX = GetLuma(Current, Column + 1) - GetLuma(Current, Column - 1);
+                const int32_t DeltaY = GetLuma(Below, Column) - GetLuma(Above, Column);
+                ASSERT_EQ(Luma[Row][Column], DeltaX * DeltaX + DeltaY * DeltaY);
+            }
+        }
+
+        // borders are left to the calculator
+        EXPECT_EQ(Sobel[0][5], 390150);
+        EXPECT_EQ(Luma[5][Image.cols - 1], 390150);
+    }
+}
+
+TEST(EnergyPolicies, CloneKeepsPolicyState)
+{
+    cv::Mat Image = MakeRandomImage(12, 20, 3, 4);
+    KScaledForwardEnergy Policy;
+    Policy.Scale = 3;
+    ct::KMatrix2D<int32_t> Scaled = CalculatePolicyEnergy<int32_t>(Image, Policy);
+    ct::KMatrix2D<int32_t> Unscaled = CalculatePolicyEnergy<int32_t, ct::KForwardEnergy>(Image);
+
+    ct::KPolicyPixelEnergy2DT<int32_t, KScaledForwardEnergy> Calculator(390150, Policy);
+    std::unique_ptr<ct::KPixelEnergy2DT<int32_t>> Clone = Calculator.Clone();
+    Clone->SetDimensions(Image.cols, Image.rows, Image.channels());
+    ct::KMatrix2D<int32_t> Cloned;
+    ASSERT_TRUE(Clone->CalculatePixelEnergy(Image, Cloned));
+
+    for (int32_t Row = 1; Row < Image.rows - 1; Row++)
+    {
+        for (int32_t Column = 1; Column < Image.cols - 1; Column++)
+        {
+            ASSERT_EQ(Scaled[Row][Column], 3 * Unscaled[Row][Column]);
+            ASSERT_EQ(Cloned[Row][Column], Scaled[Row][Column]);
+        }
+    }
+}
+
+TEST(EnergyPolicies, PolicyCarverMatchesEnergyFunction)
+{
+    const int32_t NumSeams = 9;
+    cv::Mat Image = MakeRandomImage(36, 50, 3, 12);
+
+    ct::KPolicySeamCarverT<int32_t, ct::KSobelEnergy> PolicyCarver;
+    cv::Mat PolicyResult;
+    ASSERT_TRUE(PolicyCarver.FindAndRemoveVerticalSeams(NumSeams, Image, PolicyResult));
+
+    ct::KSeamCarverT<int32_t> FunctionCarver;
+    cv::Mat FunctionResult;
+    ASSERT_TRUE(FunctionCarver.FindAndRemoveVerticalSeams(NumSeams, Image, FunctionResult, CalculateSobelEnergy));
+
+    ASSERT_EQ(PolicyResult.cols, Image.cols - NumSeams);
+    EXPECT_TRUE(IsEqual(PolicyResult, FunctionResult));
+}
@@ -0,0 +1,85 @@
+#include "Matrix2D.h"
+#include "gtest/gtest.h"
+
+
+TEST(Matrix2D, AllocationAndAlignment)
+{
+    ct::KMatrix2D<double> Matrix(7, 13, 1.5);
+
+    EXPECT_EQ(Matrix.GetNumRows(), 7);
+    EXPECT_EQ(Matrix.GetNumColumns(), 13);
+    EXPECT_GE(Matrix.GetStride(), Matrix.GetNumColumns());
+    EXPECT_FALSE(Matrix.IsView());
+
+    for (int32_t Row = 0; Row < Matrix.GetNumRows(); Row++)
+    {
+        // every row must start on an aligned boundary
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(Matrix[Row]) % ct::KMatrix2D<double>::CAlignment, 0u);
+        for (int32_t Column = 0; Column < Matrix.GetNumColumns(); Column++)
+        {
+            EXPECT_EQ(Matrix[Row][Column], 1.5);
+        }
+    }
+}
+
+TEST(Matrix2D, ResizeReusesMemory)
+{
+    ct::KMatrix2D<int32_t> Matrix(100, 100);
+    const int32_t* OriginalData = Matrix.GetData();
+
+    // shrinking must not reallocate
+    EXPECT_TRUE(Matrix.Resize(50, 60));
+    EXPECT_EQ(Matrix.GetData(), OriginalData);
+    EXPECT_EQ(Matrix.GetNumRows(), 50);
+    EXPECT_EQ(Matrix.GetNumColumns(), 60);
+
+    EXPECT_FALSE(Matrix.Resize(-1, 10));
+}
+
+TEST(Matrix2D, ResizeGrowsGeometrically)
+{
+    ct::KMatrix2D<int32_t> Matrix(100, 100);
+
+    // growing by one row reserves half the capacity again, so the next rows fit
+    EXPECT_TRUE(Matrix.Resize(101, 100));
+    const int32_t* GrownData = Matrix.GetData();
+    EXPECT_TRUE(Matrix.Resize(140, 100));
+    EXPECT_EQ(Matrix.GetData(), GrownData);
+    EXPECT_EQ(Matrix.GetNumRows(), 140);
+}
+
+TEST(Matrix2D, ViewOverMat)
+{
+    cv::Mat Image(10, 20, CV_64FC1);
+    ct::KMatrix2D<double> View(Image);
+
+    EXPECT_TRUE(View.IsView());
+    EXPECT_EQ(View.GetNumRows(), Image.rows);
+    EXPECT_EQ(View.GetNumColumns(), Image.cols);
+
+    View[3][4] = 42.0;
+    EXPECT_EQ(Image.at<double>(3, 4), 42.0);
+
+    // a view cannot change its dimensions
+    EXPECT_FALSE(View.Resize(5, 5));
+    EXPECT_TRUE(View.Resize(10, 20));
+
+    // copying a view produces an owning matrix
+    ct::KMatrix2D<double> Copy(View);
+    EXPECT_FALSE(Copy.IsView());
+    EXPECT_EQ(Copy[3][4], 42.0);
+
+    cv::Mat WrongType(10, 20, CV_8UC1);
+    EXPECT_THROW(ct::KMatrix2D<double> BadView(WrongType), std::invalid_argument);
+}
+
+TEST(Matrix2D, Move)
+{
+    ct::KMatrix2D<bool> Source(4, 4, true);
+    const bool* SourceData = Source.GetData();
+
+    ct::KMatrix2D<bool> Destination(std::move(Source));
+    EXPECT_EQ(Destination.GetData(), SourceData);
+    EXPECT_TRUE(Source.Empty());
+    EXPECT_TRUE(Destination[3][3]);
+}
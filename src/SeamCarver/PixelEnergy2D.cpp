@@ -1,39 +1,53 @@
 #include "PixelEnergy2D.h"
 
-ct::KPixelEnergy2D::KPixelEnergy2D(double MarginEnergy)
+template<typename EnergyType>
+ct::KPixelEnergy2DT<EnergyType>::KPixelEnergy2DT(EnergyType MarginEnergy)
 {
     MarginEnergy_ = MarginEnergy;
 }
 
-ct::KPixelEnergy2D::KPixelEnergy2D(int32_t NumColumns, int32_t NumRows, int32_t NumChannels, double MarginEnergy)
+template<typename EnergyType>
+ct::KPixelEnergy2DT<EnergyType>::KPixelEnergy2DT(int32_t NumColumns, int32_t NumRows, int32_t NumChannels, EnergyType MarginEnergy)
 {
     ImageDimensions.NumColumns_ = NumColumns;
     ImageDimensions.NumRows_ = NumRows;
     ImageDimensions.NumColorChannels_ = NumChannels;
     MarginEnergy_ = MarginEnergy;
     bDimensionsInitialized = true;
+    EnergyRowKernel_ = PixelEnergyKernels::SelectEnergyRowKernel<EnergyType>(NumChannels);
 }
 
-ct::KPixelEnergy2D::KPixelEnergy2D(const cv::Mat& Image, double MarginEnergy)
+template<typename EnergyType>
+ct::KPixelEnergy2DT<EnergyType>::KPixelEnergy2DT(const cv::Mat& Image, EnergyType MarginEnergy)
 {
     ImageDimensions.NumColumns_ = Image.cols;
     ImageDimensions.NumRows_ = Image.rows;
     ImageDimensions.NumColorChannels_ = Image.channels();
     MarginEnergy_ = MarginEnergy;
     bDimensionsInitialized = true;
+    EnergyRowKernel_ = PixelEnergyKernels::SelectEnergyRowKernel<EnergyType>(Image.channels());
 }
 
-double ct::KPixelEnergy2D::GetMarginEnergy() const
+template<typename EnergyType>
+std::unique_ptr<ct::KPixelEnergy2DT<EnergyType>> ct::KPixelEnergy2DT<EnergyType>::Clone() const
+{
+    return std::unique_ptr<KPixelEnergy2DT<EnergyType>>(new KPixelEnergy2DT<EnergyType>(*this));
+}
+
+template<typename EnergyType>
+EnergyType ct::KPixelEnergy2DT<EnergyType>::GetMarginEnergy() const
 {
     return MarginEnergy_;
 }
 
-void ct::KPixelEnergy2D::SetMarginEnergy(double MarginEnergy)
+template<typename EnergyType>
+void ct::KPixelEnergy2DT<EnergyType>::SetMarginEnergy(EnergyType MarginEnergy)
 {
     MarginEnergy_ = MarginEnergy;
 }
 
-bool ct::KPixelEnergy2D::GetDimensions(ImageDimensionStruct& OutImageDimensions) const
+template<typename EnergyType>
+bool ct::KPixelEnergy2DT<EnergyType>::GetDimensions(ImageDimensionStruct& OutImageDimensions) const
 {
     if (!bDimensionsInitialized)
     {
@@ -48,33 +62,42 @@ bool ct::KPixelEnergy2D::GetDimensions(ImageDimensionStruct& OutImageDimensions)
     }
 }
 
-void ct::KPixelEnergy2D::SetDimensions(int32_t NumColumns, int32_t NumRows, int32_t NumChannels)
+template<typename EnergyType>
+void ct::KPixelEnergy2DT<EnergyType>::SetDimensions(int32_t NumColumns, int32_t NumRows, int32_t NumChannels)
 {
     ImageDimensions.NumColumns_ = NumColumns;
     ImageDimensions.NumRows_ = NumRows;
     ImageDimensions.NumColorChannels_ = NumChannels;
+    EnergyRowKernel_ = PixelEnergyKernels::SelectEnergyRowKernel<EnergyType>(NumChannels);
 }
 
-bool ct::KPixelEnergy2D::CalculatePixelEnergy(const cv::Mat & Image, vector<vector<double>>& OutPixelEnergy)
+template<typename EnergyType>
+void ct::KPixelEnergy2DT<EnergyType>::SetNumThreads(int32_t NumThreads)
 {
-    // TODO add threads
-      // if more columns, split calculation into 2 threads to calculate for every row
-    if (ImageDimensions.NumColumns_ >= ImageDimensions.NumRows_)
+    if (NumThreads == 1)
     {
-        return CalculatePixelEnergyForEveryRow(Image, OutPixelEnergy, true) &&
-            CalculatePixelEnergyForEveryRow(Image, OutPixelEnergy, false);
+        ThreadPool_.reset();
     }
-    // otherwise, if more rows, split calculation into 2 threads to calculate for every column
     else
     {
-        return CalculatePixelEnergyForEveryColumn(Image, OutPixelEnergy, true) &&
-            CalculatePixelEnergyForEveryColumn(Image, OutPixelEnergy, false);
+        ThreadPool_ = std::make_shared<KThreadPool>(NumThreads);
     }
+}
+
+template<typename EnergyType>
+void ct::KPixelEnergy2DT<EnergyType>::SetThreadPool(std::shared_ptr<KThreadPool> ThreadPool)
+{
+    ThreadPool_ = ThreadPool;
+}
 
-    return false;
+template<typename EnergyType>
+int32_t ct::KPixelEnergy2DT<EnergyType>::GetNumThreads() const
+{
+    return ThreadPool_ ? ThreadPool_->GetNumThreads() : 1;
 }
 
-bool ct::KPixelEnergy2D::CalculatePixelEnergyForEveryRow(const cv::Mat& Image, vector<vector<double>>& OutPixelEnergy, bool bDoOddColumns)
+template<typename EnergyType>
+bool ct::KPixelEnergy2DT<EnergyType>::CalculatePixelEnergy(const cv::Mat& Image, KMatrix2D<EnergyType>& OutPixelEnergy)
 {
     // ensure Image is of the right size
     if (!(Image.cols == ImageDimensions.NumColumns_ &&
@@ -87,335 +110,124 @@ bool ct::KPixelEnergy2D::CalculatePixelEnergyForEveryRow(const cv::Mat& Image, v
     // ensure Image has non-zero dimensions
     if (Image.cols == 0 || Image.rows == 0 || Image.channels() == 0) { return false; }
 
+    // kernels read 8-bit interleaved data, only grayscale and BGR are supported
+    if (Image.depth() != CV_8U || EnergyRowKernel_ == nullptr) { return false; }
+
     // ensure OutPixelEnergy has the right dimensions
     // if not, then resize locally
-    if (!(OutPixelEnergy.size() == ImageDimensions.NumRows_) || !(OutPixelEnergy[0].size() == ImageDimensions.NumColumns_))
+    if (!OutPixelEnergy.Resize(ImageDimensions.NumRows_, ImageDimensions.NumColumns_))
     {
-        OutPixelEnergy.resize(ImageDimensions.NumRows_);
-        for (int32_t Row = 0; Row < ImageDimensions.NumRows_; Row++)
-        {
-            OutPixelEnergy[Row].resize(ImageDimensions.NumColumns_);
-        }
+        return false;
     }
 
-    // TODO can these local variables be moved higher into the private section of the class
-    int32_t BottomRow = ImageDimensions.NumRows_ - 1;
-    int32_t RightColumn = ImageDimensions.NumColumns_ - 1;
-
-    vector<cv::Mat> ImageByChannel;
-    ImageByChannel.resize(ImageDimensions.NumColorChannels_);
-
-    // if color channels use cv::split
-    // otherwise if grayscale use cv::extractChannel
-    // TODO compute depending on the number of channels
-    if (ImageDimensions.NumColorChannels_ == CNumChannelsInColorImage_)
-    {
-        cv::split(Image, ImageByChannel);
-    }
-    else if (ImageDimensions.NumColorChannels_ == 1)
+    if (ThreadPool_ == nullptr || ThreadPool_->GetNumThreads() == 1)
     {
-        cv::extractChannel(Image, ImageByChannel[0], 0);
+        return CalculatePixelEnergyForRows(Image, OutPixelEnergy, 0, ImageDimensions.NumRows_);
     }
-    else
-    {
-        return false;
-    }
-
-    // Establish vectors whose size is equal to the number of channels
-    // Two vectors used to compute X gradient
-      // Don't need them for Y since we are only caching the columns
-      // We can just access the pixel values above/below directly to compute the delta
-    // TODO replace vectors with a multidimensional vector
-    vector<double> XDirection2;
-    vector<double> XDirection1;
-
-    XDirection2.resize(ImageDimensions.NumColorChannels_);
-    XDirection1.resize(ImageDimensions.NumColorChannels_);
 
-    vector<double> DeltaXDirection;
-    vector<double> DeltaYDirection;
-
-    DeltaXDirection.resize(ImageDimensions.NumColorChannels_);
-    DeltaYDirection.resize(ImageDimensions.NumColorChannels_);
-
-    double DeltaSquareX = 0.0;
-    double DeltaSquareY = 0.0;
-
-    int32_t Column = 0;
-    // compute energy for every row
-    // do odd columns and even columns separately in order to leverage cached values to prevent multiple memory accesses
-    for (int32_t Row = 0; Row < ImageDimensions.NumRows_; Row++)
+    // split the image into horizontal bands
+    // every band reads one halo row above and below itself straight from the (read only) image,
+    //      but only writes its own rows, so bands are independent and the result is identical
+    //      to the serial computation
+    std::atomic<bool> bSuccess(true);
+    ThreadPool_->ParallelFor(0, ImageDimensions.NumRows_,
+                             [&](int32_t StartRow, int32_t EndRow)
     {
-        /***** ODD COLUMNS *****/
-        if (bDoOddColumns)
+        if (!CalculatePixelEnergyForRows(Image, OutPixelEnergy, StartRow, EndRow))
         {
-            // initialize starting column
-            Column = 1;
-
-            // initialize color values to the left of current pixel
-            for (int32_t Channel = 0; Channel < ImageDimensions.NumColorChannels_; Channel++)
-            {
-                XDirection1[Channel] = ImageByChannel[Channel].at<uchar>(Row, Column - 1);
-            }
-
-            // Compute energy of odd columns
-            for (/* Column was already initialized */; Column < ImageDimensions.NumColumns_; Column += 2)
-            {
-                if (Row == 0 || Column == 0 || Row == BottomRow || Column == RightColumn)
-                {
-                    OutPixelEnergy[Row][Column] = MarginEnergy_;
-                }
-                else
-                {
-                    // Reset gradients from previous calculation
-                    DeltaSquareX = 0.0;
-                    DeltaSquareY = 0.0;
-
-                    // For all channels:
-                      // Compute gradients
-                      // Compute overall energy by summing both X and Y gradient
-                    for (int32_t Channel = 0; Channel < ImageDimensions.NumColorChannels_; Channel++)
-                    {
-                        // get new values to the right
-                        XDirection2[Channel] = ImageByChannel[Channel].at<uchar>(Row, Column + 1);
-
-                        DeltaXDirection[Channel] = XDirection2[Channel] - XDirection1[Channel];
-
-                        DeltaSquareX += DeltaXDirection[Channel] * DeltaXDirection[Channel];
-
-                        DeltaYDirection[Channel] =
-                            ImageByChannel[Channel].at<uchar>(Row + 1, Column) -
-                            ImageByChannel[Channel].at<uchar>(Row - 1, Column);
-
-                        DeltaSquareY += DeltaYDirection[Channel] * DeltaYDirection[Channel];
-
-                        // shift color values to the left
-                        XDirection1[Channel] = XDirection2[Channel];
-                    }
-                    OutPixelEnergy[Row][Column] = DeltaSquareX + DeltaSquareY;
-                }
-            }
+            bSuccess = false;
         }
-        /***** EVEN COLUMNS *****/
-        else
-        {
-            // initialize starting column
-            Column = 0;
+    }, CMinRowsPerBand_);
 
-            // initialize color values to the right of current pixel
-            for (int32_t Channel = 0; Channel < ImageDimensions.NumColorChannels_; Channel++)
-            {
-                XDirection2[Channel] = ImageByChannel[Channel].at<uchar>(Row, Column + 1);
-            }
-
-            // Compute energy of odd columns
-            for (/* Column was already initialized */; Column < ImageDimensions.NumColumns_; Column += 2)
-            {
-                if (Row == 0 || Column == 0 || Row == BottomRow || Column == RightColumn)
-                {
-                    OutPixelEnergy[Row][Column] = MarginEnergy_;
-                }
-                else
-                {
-                    // Reset gradient from previous calculation
-                    DeltaSquareX = 0.0;
-                    DeltaSquareY = 0.0;
-
-                    // For all channels:
-                      // Compute gradients
-                      // Compute overall energy by summing both X and Y gradient
-                    for (int32_t Channel = 0; Channel < ImageDimensions.NumColorChannels_; Channel++)
-                    {
-                        // shift color values to the left
-                        XDirection1[Channel] = XDirection2[Channel];
-
-                        // get new values to the right
-                        XDirection2[Channel] = ImageByChannel[Channel].at<uchar>(Row, Column + 1);
-                        DeltaXDirection[Channel] = XDirection2[Channel] - XDirection1[Channel];
-
-                        DeltaSquareX += DeltaXDirection[Channel] * DeltaXDirection[Channel];
-
-                        DeltaYDirection[Channel] =
-                            ImageByChannel[Channel].at<uchar>(Row + 1, Column) -
-                            ImageByChannel[Channel].at<uchar>(Row - 1, Column);
-
-                        DeltaSquareY += DeltaYDirection[Channel] * DeltaYDirection[Channel];
-                    }
-                    OutPixelEnergy[Row][Column] = DeltaSquareX + DeltaSquareY;
-                }
-            }
-        }
-    }
-    return true;
+    return bSuccess;
 }
 
-bool ct::KPixelEnergy2D::CalculatePixelEnergyForEveryColumn(const cv::Mat& Image, vector< vector<double> >& OutPixelEnergy, bool bDoOddRows)
+template<typename EnergyType>
+bool ct::KPixelEnergy2DT<EnergyType>::CalculatePixelEnergyForPixels(const cv::Mat& Image,
+                                                                    KMatrix2D<EnergyType>& OutPixelEnergy,
+                                                                    int32_t Row,
+                                                                    int32_t StartColumn,
+                                                                    int32_t EndColumn)
 {
-    // ensure Image is of the right size
-    if (!(Image.cols == ImageDimensions.NumColumns_ &&
-          Image.rows == ImageDimensions.NumRows_ &&
-          Image.channels() == ImageDimensions.NumColorChannels_))
+    int32_t NumRows = ImageDimensions.NumRows_;
+    int32_t NumColumns = ImageDimensions.NumColumns_;
+
+    // image and energy must both match the dimensions the kernel was selected for
+    if (!(Image.cols == NumColumns && Image.rows == NumRows &&
+          Image.channels() == ImageDimensions.NumColorChannels_) ||
+        OutPixelEnergy.GetNumRows() != NumRows || OutPixelEnergy.GetNumColumns() != NumColumns)
     {
         return false;
     }
+    if (Image.depth() != CV_8U || EnergyRowKernel_ == nullptr) { return false; }
+    if (Row < 0 || Row >= NumRows) { return false; }
 
-    // ensure Image has non-zero dimensions
-    if (Image.cols == 0 || Image.rows == 0 || Image.channels() == 0) { return false; }
+    StartColumn = std::max(StartColumn, 0);
+    EndColumn = std::min(EndColumn, NumColumns);
+    EnergyType* OutRow = OutPixelEnergy[Row];
 
-    // ensure OutPixelEnergy has the right dimensions
-    // if not, then resize locally
-    if (!(OutPixelEnergy.size() == ImageDimensions.NumRows_) || !(OutPixelEnergy[0].size() == ImageDimensions.NumColumns_))
+    // top and bottom rows are entirely border pixels
+    if (Row == 0 || Row == NumRows - 1)
     {
-        OutPixelEnergy.resize(ImageDimensions.NumRows_);
-        for (int32_t Row = 0; Row < ImageDimensions.NumRows_; Row++)
-        {
-            OutPixelEnergy[Row].resize(ImageDimensions.NumColumns_);
-        }
+        std::fill(OutRow + StartColumn, OutRow + std::max(StartColumn, EndColumn), MarginEnergy_);
+        return true;
     }
 
-    // TODO can these local variables be moved higher into the private section of the class
-    int32_t BottomRow = ImageDimensions.NumRows_ - 1;
-    int32_t RightColumn = ImageDimensions.NumColumns_ - 1;
-
-    vector<cv::Mat> ImageByChannel;
-    ImageByChannel.resize(ImageDimensions.NumColorChannels_);
-
-    // if color channels use cv::split
-    // otherwise if grayscale use cv::extractChannel
-    // TODO compute depending on the number of channels
-    if (ImageDimensions.NumColorChannels_ == CNumChannelsInColorImage_)
+    if (StartColumn == 0 && EndColumn > 0)
     {
-        cv::split(Image, ImageByChannel);
+        OutRow[0] = MarginEnergy_;
     }
-    else
+    if (EndColumn == NumColumns && StartColumn < NumColumns)
     {
-        cv::extractChannel(Image, ImageByChannel[0], 0);
+        OutRow[NumColumns - 1] = MarginEnergy_;
     }
 
-    // Establish vectors whose size is equal to the number of channels
-    // Two vectors used to compute X gradient
-      // Don't need them for Y since we are only caching the columns
-      // We can just access the pixel values above/below directly to compute the delta
-    // TODO replace vectors with a multidimensional vector
-    vector<double> YDirection2;
-    vector<double> YDirection1;
-
-    YDirection2.resize(ImageDimensions.NumColorChannels_);
-    YDirection1.resize(ImageDimensions.NumColorChannels_);
-
-    vector<double> DeltaXDirection;
-    vector<double> DeltaYDirection;
-
-    DeltaXDirection.resize(ImageDimensions.NumColorChannels_);
-    DeltaYDirection.resize(ImageDimensions.NumColorChannels_);
-
-    double DeltaSquareX = 0.0;
-    double DeltaSquareY = 0.0;
-
-    int32_t Row = 0;
-    // compute energy for every column
-    // do odd rows and even rows separately in order to leverage cached values to prevent multiple memory accesses
-    for (int32_t Column = 0; Column < ImageDimensions.NumColumns_; Column++)
+    int32_t InteriorStart = std::max(StartColumn, 1);
+    int32_t InteriorEnd = std::min(EndColumn, NumColumns - 1);
+    if (InteriorStart < InteriorEnd)
     {
-        /***** ODD ROWS *****/
-        if (bDoOddRows)
-        {
-            // initialize starting row
-            Row = 1;
-
-            // initialize color values above the current pixel
-            for (int32_t Channel = 0; Channel < ImageDimensions.NumColorChannels_; Channel++)
-            {
-                YDirection1[Channel] = ImageByChannel[Channel].at<uchar>(Row - 1, Column);
-            }
-
-            // Compute energy of odd rows
-            for (/* Row was already initialized */; Row < ImageDimensions.NumRows_; Row += 2)
-            {
-                if (Row == 0 || Column == 0 || Row == BottomRow || Column == RightColumn)
-                {
-                    OutPixelEnergy[Row][Column] = MarginEnergy_;
-                }
-                else
-                {
-                    // Reset gradients from previous calculation
-                    DeltaSquareX = 0.0;
-                    DeltaSquareY = 0.0;
-
-                    // For all channels:
-                      // Compute gradients
-                      // Compute overall energy by summing both X and Y gradient
-                    for (int32_t Channel = 0; Channel < ImageDimensions.NumColorChannels_; Channel++)
-                    {
-                        // get new values below the current pixel
-                        YDirection2[Channel] = ImageByChannel[Channel].at<uchar>(Row + 1, Column);
-
-                        DeltaYDirection[Channel] = YDirection2[Channel] - YDirection1[Channel];
-
-                        DeltaSquareY = DeltaYDirection[Channel] * DeltaYDirection[Channel];
+        CalculateEnergyRow(Image, Row, InteriorStart, InteriorEnd, OutRow);
+    }
+    return true;
+}
 
-                        DeltaXDirection[Channel] =
-                            ImageByChannel[Channel].at<uchar>(Row, Column + 1) -
-                            ImageByChannel[Channel].at<uchar>(Row, Column - 1);
+template<typename EnergyType>
+bool ct::KPixelEnergy2DT<EnergyType>::CalculatePixelEnergyForRows(const cv::Mat& Image,
+                                                                  KMatrix2D<EnergyType>& OutPixelEnergy,
+                                                                  int32_t StartRow,
+                                                                  int32_t EndRow)
+{
+    int32_t BottomRow = ImageDimensions.NumRows_ - 1;
+    int32_t RightColumn = ImageDimensions.NumColumns_ - 1;
 
-                        DeltaSquareX += DeltaXDirection[Channel] * DeltaXDirection[Channel];
+    for (int32_t Row = StartRow; Row < EndRow; Row++)
+    {
+        EnergyType* OutRow = OutPixelEnergy[Row];
 
-                        // shift color values up
-                        YDirection1[Channel] = YDirection2[Channel];
-                    }
-                    OutPixelEnergy[Row][Column] = DeltaSquareX + DeltaSquareY;
-                }
-            }
-        }
-        /***** EVEN ROWS *****/
-        else
+        // top and bottom rows are entirely border pixels
+        if (Row == 0 || Row == BottomRow)
         {
-            // initialize starting row
-            Row = 0;
-
-            // initialize color values below the current pixel
-            for (int32_t Channel = 0; Channel < ImageDimensions.NumColorChannels_; Channel++)
-            {
-                YDirection2[Channel] = ImageByChannel[Channel].at<uchar>(Row + 1, Column);
-            }
-
-            // Compute energy of odd rows
-            for (/* Row was already initialized */; Row < ImageDimensions.NumRows_; Row += 2)
-            {
-                if (Row == 0 || Column == 0 || Row == BottomRow || Column == RightColumn)
-                {
-                    OutPixelEnergy[Row][Column] = MarginEnergy_;
-                }
-                else
-                {
-                    // Reset gradient from previous calculation
-                    DeltaSquareX = 0.0;
-                    DeltaSquareY = 0.0;
-
-                    // For all channels:
-                      // Compute gradients
-                      // Compute overall energy by summing both X and Y gradient
-                    for (int32_t Channel = 0; Channel < ImageDimensions.NumColorChannels_; Channel++)
-                    {
-                        // shift color values up
-                        YDirection1[Channel] = YDirection2[Channel];
-
-                        // get new values below the current pixel
-                        YDirection2[Channel] = ImageByChannel[Channel].at<uchar>(Row + 1, Column);
-                        DeltaYDirection[Channel] = YDirection2[Channel] - YDirection1[Channel];
-
-                        DeltaSquareY += DeltaYDirection[Channel] * DeltaYDirection[Channel];
+            std::fill(OutRow, OutRow + ImageDimensions.NumColumns_, MarginEnergy_);
+            continue;
+        }
 
-                        DeltaXDirection[Channel] =
-                            ImageByChannel[Channel].at<uchar>(Row, Column + 1) -
-                            ImageByChannel[Channel].at<uchar>(Row, Column - 1);
+        OutRow[0] = MarginEnergy_;
+        OutRow[RightColumn] = MarginEnergy_;
 
-                        DeltaSquareX += DeltaXDirection[Channel] * DeltaXDirection[Channel];
-                    }
-                    OutPixelEnergy[Row][Column] = DeltaSquareX + DeltaSquareY;
-                }
-            }
-        }
+        // compute every interior column directly from the interleaved image data
+        CalculateEnergyRow(Image, Row, 1, RightColumn, OutRow);
     }
     return true;
-}
\ No newline at end of file
+}
+
+template<typename EnergyType>
+void ct::KPixelEnergy2DT<EnergyType>::CalculateEnergyRow(const cv::Mat& Image, int32_t Row,
+                                                         int32_t StartColumn, int32_t EndColumn,
+                                                         EnergyType* OutEnergy)
+{
+    EnergyRowKernel_(Image.ptr<uint8_t>(Row - 1), Image.ptr<uint8_t>(Row), Image.ptr<uint8_t>(Row + 1),
+                     StartColumn, EndColumn, OutEnergy);
+}
+
+template class ct::KPixelEnergy2DT<double>;
+template class ct::KPixelEnergy2DT<int32_t>;
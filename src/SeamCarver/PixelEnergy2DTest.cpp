@@ -1,4 +1,6 @@
 #include "PixelEnergy2D.h"
+#include "PixelEnergyKernels.h"
+#include "SeamCarverTestHelpers.h"
 #include "gtest/gtest.h"
 
 #ifdef USEDEBUGDISPLAY
@@ -36,7 +38,7 @@ TEST(PixelEnergy2D, CTORGettersAndSetters)
     EXPECT_EQ(ImageDimensions.NumColumns_, NewNumColumns);
     EXPECT_EQ(ImageDimensions.NumRows_, NewNumRows);
 
-    vector<vector<double>> ComputedPixelEnergy;
+    ct::KMatrix2D<double> ComputedPixelEnergy;
     EXPECT_EQ(PixelEnergyCalculator.CalculatePixelEnergy(img, ComputedPixelEnergy), false);
 
     PixelEnergyCalculator.SetDimensions(img.cols, img.rows, img.channels());
@@ -51,12 +53,7 @@ TEST(PixelEnergy2D, CTORGettersAndSetters)
 #ifdef USEDEBUGDISPLAY
     KDebugDisplay d;
     d.Display2DVector<double>(ComputedPixelEnergy, PixelEnergyCalculator.GetMarginEnergy());
-    vector<vector<bool>> Marked;
-    Marked.resize(img.rows);
-    for (int32_t Row = 0; Row < img.rows; Row++)
-    {
-        Marked[Row].resize(img.cols);
-    }
+    ct::KMatrix2D<bool> Marked(img.rows, img.cols, false);
     for (int32_t Row = 0; Row < img.rows; Row++)
     {
         Marked[Row][img.cols / 2] = true;
@@ -65,6 +62,162 @@ TEST(PixelEnergy2D, CTORGettersAndSetters)
 #endif
 }
 
+namespace
+{
+    using ct::test::MakeRandomImage;
+
+    // straightforward dual-gradient energy used as the reference for the optimized kernels
+    double ReferenceEnergy(const cv::Mat& Image, int32_t Row, int32_t Column, double MarginEnergy)
+    {
+        if (Row == 0 || Column == 0 || Row == Image.rows - 1 || Column == Image.cols - 1)
+        {
+            return MarginEnergy;
+        }
+
+        int32_t NumChannels = Image.channels();
+        double DeltaSquareX = 0.0;
+        double DeltaSquareY = 0.0;
+        for (int32_t Channel = 0; Channel < NumChannels; Channel++)
+        {
+            double DeltaX = Image.ptr<uchar>(Row)[(Column + 1) * NumChannels + Channel] -
+                Image.ptr<uchar>(Row)[(Column - 1) * NumChannels + Channel];
+            double DeltaY = Image.ptr<uchar>(Row + 1)[Column * NumChannels + Channel] -
+                Image.ptr<uchar>(Row - 1)[Column * NumChannels + Channel];
+            DeltaSquareX += DeltaX * DeltaX;
+            DeltaSquareY += DeltaY * DeltaY;
+        }
+        return DeltaSquareX + DeltaSquareY;
+    }
+}
+
+TEST(PixelEnergy2D, MatchesReferenceEnergy)
+{
+    // landscape and portrait images, in color and grayscale, with widths that exercise the
+    //      scalar tail of the SIMD kernels
+    const int32_t Dimensions[][2] = { { 37, 83 }, { 83, 37 }, { 3, 3 }, { 2, 50 }, { 50, 1 } };
+    const int32_t Channels[] = { 1, 3 };
+
+    for (const auto& Dimension : Dimensions)
+    {
+        for (int32_t NumChannels : Channels)
+        {
+            cv::Mat Image = MakeRandomImage(Dimension[0], Dimension[1], NumChannels, 7);
+            ct::KPixelEnergy2D PixelEnergyCalculator(Image);
+            ct::KMatrix2D<double> ComputedPixelEnergy;
+            ASSERT_TRUE(PixelEnergyCalculator.CalculatePixelEnergy(Image, ComputedPixelEnergy));
+
+            for (int32_t Row = 0; Row < Image.rows; Row++)
+            {
+                for (int32_t Column = 0; Column < Image.cols; Column++)
+                {
+                    ASSERT_EQ(ComputedPixelEnergy[Row][Column],
+                              ReferenceEnergy(Image, Row, Column,
+                                              PixelEnergyCalculator.GetMarginEnergy()));
+                }
+            }
+        }
+    }
+}
+
+TEST(PixelEnergy2D, SimdKernelsMatchScalar)
+{
+    typedef ct::PixelEnergyKernels::KEnergyRowKernel KEnergyRowKernel;
+    std::vector<KEnergyRowKernel> KernelsC1;
+    std::vector<KEnergyRowKernel> KernelsC3;
+#ifdef CT_X86_SIMD
+    if (ct::KCpuFeatures::HasSSE41())
+    {
+        KernelsC1.push_back(ct::PixelEnergyKernels::CalculateEnergyRowC1SSE41);
+        KernelsC3.push_back(ct::PixelEnergyKernels::CalculateEnergyRowC3SSE41);
+    }
+    if (ct::KCpuFeatures::HasAVX2())
+    {
+        KernelsC1.push_back(ct::PixelEnergyKernels::CalculateEnergyRowC1AVX2);
+        KernelsC3.push_back(ct::PixelEnergyKernels::CalculateEnergyRowC3AVX2);
+    }
+#endif
+
+    for (int32_t NumColumns = 3; NumColumns < 150; NumColumns++)
+    {
+        for (int32_t NumChannels = 1; NumChannels <= 3; NumChannels += 2)
+        {
+            cv::Mat Image = MakeRandomImage(3, NumColumns, NumChannels, NumColumns);
+            const std::vector<KEnergyRowKernel>& Kernels = NumChannels == 1 ? KernelsC1 : KernelsC3;
+            // kernels are overloaded for every energy type, so the target type has to pick one
+            KEnergyRowKernel ScalarKernel = ct::PixelEnergyKernels::CalculateEnergyRowC3Scalar;
+            if (NumChannels == 1)
+            {
+                ScalarKernel = ct::PixelEnergyKernels::CalculateEnergyRowC1Scalar;
+            }
+
+            std::vector<double> Expected(NumColumns, -1.0);
+            ScalarKernel(Image.ptr<uint8_t>(0), Image.ptr<uint8_t>(1), Image.ptr<uint8_t>(2),
+                         1, NumColumns - 1, Expected.data());
+
+            for (KEnergyRowKernel Kernel : Kernels)
+            {
+                std::vector<double> Actual(NumColumns, -1.0);
+                Kernel(Image.ptr<uint8_t>(0), Image.ptr<uint8_t>(1), Image.ptr<uint8_t>(2),
+                       1, NumColumns - 1, Actual.data());
+                // columns outside of the requested range must be left untouched
+                ASSERT_EQ(Actual, Expected);
+            }
+        }
+    }
+}
+
+TEST(PixelEnergy2D, Int32MatchesDouble)
+{
+    for (int32_t NumChannels = 1; NumChannels <= 3; NumChannels += 2)
+    {
+        cv::Mat Image = MakeRandomImage(23, 131, NumChannels, 5);
+
+        ct::KPixelEnergy2D DoubleCalculator(Image);
+        ct::KMatrix2D<double> DoublePixelEnergy;
+        ASSERT_TRUE(DoubleCalculator.CalculatePixelEnergy(Image, DoublePixelEnergy));
+
+        ct::KPixelEnergy2DT<int32_t> Int32Calculator(Image);
+        ct::KMatrix2D<int32_t> Int32PixelEnergy;
+        ASSERT_TRUE(Int32Calculator.CalculatePixelEnergy(Image, Int32PixelEnergy));
+
+        for (int32_t Row = 0; Row < Image.rows; Row++)
+        {
+            for (int32_t Column = 0; Column < Image.cols; Column++)
+            {
+                ASSERT_EQ(Int32PixelEnergy[Row][Column], DoublePixelEnergy[Row][Column]);
+            }
+        }
+    }
+}
+
+TEST(PixelEnergy2D, ParallelMatchesSerial)
+{
+    const int32_t Dimensions[][2] = { { 257, 301 }, { 301, 257 }, { 17, 40 } };
+
+    for (const auto& Dimension : Dimensions)
+    {
+        cv::Mat Image = MakeRandomImage(Dimension[0], Dimension[1], 3, 11);
+
+        ct::KPixelEnergy2D SerialCalculator(Image);
+        ct::KMatrix2D<double> SerialPixelEnergy;
+        ASSERT_TRUE(SerialCalculator.CalculatePixelEnergy(Image, SerialPixelEnergy));
+
+        ct::KPixelEnergy2D ParallelCalculator(Image);
+        ParallelCalculator.SetNumThreads(4);
+        EXPECT_EQ(ParallelCalculator.GetNumThreads(), 4);
+        ct::KMatrix2D<double> ParallelPixelEnergy;
+        ASSERT_TRUE(ParallelCalculator.CalculatePixelEnergy(Image, ParallelPixelEnergy));
+
+        for (int32_t Row = 0; Row < Image.rows; Row++)
+        {
+            for (int32_t Column = 0; Column < Image.cols; Column++)
+            {
+                ASSERT_EQ(ParallelPixelEnergy[Row][Column], SerialPixelEnergy[Row][Column]);
+            }
+        }
+    }
+}
+
 int main(int argc, char* argv[])
 {
     testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,105 @@
+#include "PixelEnergyKernels.h"
+
+namespace
+{
+    template<typename EnergyType>
+    void CalculateEnergyRowC1(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below,
+                              int32_t StartColumn, int32_t EndColumn, EnergyType* OutEnergy)
+    {
+        for (int32_t Column = StartColumn; Column < EndColumn; Column++)
+        {
+            int32_t DeltaX = Current[Column + 1] - Current[Column - 1];
+            int32_t DeltaY = Below[Column] - Above[Column];
+            OutEnergy[Column] = DeltaX * DeltaX + DeltaY * DeltaY;
+        }
+    }
+
+    template<typename EnergyType>
+    void CalculateEnergyRowC3(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below,
+                              int32_t StartColumn, int32_t EndColumn, EnergyType* OutEnergy)
+    {
+        for (int32_t Column = StartColumn; Column < EndColumn; Column++)
+        {
+            // byte offset of the pixel's first channel and its left/right neighbors
+            const int32_t Center = 3 * Column;
+            const int32_t Left = Center - 3;
+            const int32_t Right = Center + 3;
+
+            // all terms are integers, so summing them as int32_t gives the exact same result as
+            //      accumulating them as double
+            int32_t DeltaSquareX = 0;
+            int32_t DeltaSquareY = 0;
+            for (int32_t Channel = 0; Channel < 3; Channel++)
+            {
+                int32_t DeltaX = Current[Right + Channel] - Current[Left + Channel];
+                int32_t DeltaY = Below[Center + Channel] - Above[Center + Channel];
+                DeltaSquareX += DeltaX * DeltaX;
+                DeltaSquareY += DeltaY * DeltaY;
+            }
+            OutEnergy[Column] = DeltaSquareX + DeltaSquareY;
+        }
+    }
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC1Scalar(const uint8_t* Above,
+                                                        const uint8_t* Current,
+                                                        const uint8_t* Below,
+                                                        int32_t StartColumn, int32_t EndColumn,
+                                                        double* OutEnergy)
+{
+    CalculateEnergyRowC1(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC1Scalar(const uint8_t* Above,
+                                                        const uint8_t* Current,
+                                                        const uint8_t* Below,
+                                                        int32_t StartColumn, int32_t EndColumn,
+                                                        int32_t* OutEnergy)
+{
+    CalculateEnergyRowC1(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC3Scalar(const uint8_t* Above,
+                                                        const uint8_t* Current,
+                                                        const uint8_t* Below,
+                                                        int32_t StartColumn, int32_t EndColumn,
+                                                        double* OutEnergy)
+{
+    CalculateEnergyRowC3(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC3Scalar(const uint8_t* Above,
+                                                        const uint8_t* Current,
+                                                        const uint8_t* Below,
+                                                        int32_t StartColumn, int32_t EndColumn,
+                                                        int32_t* OutEnergy)
+{
+    CalculateEnergyRowC3(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+
+template<typename EnergyType>
+ct::PixelEnergyKernels::KEnergyRowKernelT<EnergyType>
+ct::PixelEnergyKernels::SelectEnergyRowKernel(int32_t NumChannels)
+{
+    // the overload matching EnergyType is picked by the return type
+#ifdef CT_X86_SIMD
+    if (KCpuFeatures::HasAVX2())
+    {
+        if (NumChannels == 1) { return CalculateEnergyRowC1AVX2; }
+        if (NumChannels == 3) { return CalculateEnergyRowC3AVX2; }
+    }
+    if (KCpuFeatures::HasSSE41())
+    {
+        if (NumChannels == 1) { return CalculateEnergyRowC1SSE41; }
+        if (NumChannels == 3) { return CalculateEnergyRowC3SSE41; }
+    }
+#endif
+    if (NumChannels == 1) { return CalculateEnergyRowC1Scalar; }
+    if (NumChannels == 3) { return CalculateEnergyRowC3Scalar; }
+    return nullptr;
+}
+
+template ct::PixelEnergyKernels::KEnergyRowKernelT<double>
+ct::PixelEnergyKernels::SelectEnergyRowKernel<double>(int32_t NumChannels);
+template ct::PixelEnergyKernels::KEnergyRowKernelT<int32_t>
+ct::PixelEnergyKernels::SelectEnergyRowKernel<int32_t>(int32_t NumChannels);
@@ -0,0 +1,205 @@
+#include "PixelEnergyKernels.h"
+
+#ifdef CT_X86_SIMD
+#include <immintrin.h>
+
+namespace
+{
+    /**
+     * @brief Splits 16 interleaved BGR pixels (48 bytes) into one register per channel
+     */
+    inline void DeinterleaveBGR(const uint8_t* Pixels, __m128i& OutB, __m128i& OutG, __m128i& OutR)
+    {
+        const __m128i Chunk0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pixels));
+        const __m128i Chunk1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pixels + 16));
+        const __m128i Chunk2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pixels + 32));
+
+        // every channel takes 5 or 6 bytes out of each 16 byte chunk
+        // indices of -1 zero the byte so the three partial results can be OR'ed together
+        const __m128i B0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i B1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+        const __m128i B2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+
+        const __m128i G0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i G1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+        const __m128i G2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+
+        const __m128i R0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i R1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+        const __m128i R2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+        OutB = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(Chunk0, B0), _mm_shuffle_epi8(Chunk1, B1)),
+                            _mm_shuffle_epi8(Chunk2, B2));
+        OutG = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(Chunk0, G0), _mm_shuffle_epi8(Chunk1, G1)),
+                            _mm_shuffle_epi8(Chunk2, G2));
+        OutR = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(Chunk0, R0), _mm_shuffle_epi8(Chunk1, R1)),
+                            _mm_shuffle_epi8(Chunk2, R2));
+    }
+
+    /**
+     * @brief Adds DeltaX^2 + DeltaY^2 of 16 pixels of one channel to two int32 accumulators.
+     *      Because AVX2 unpacks within 128 bit lanes, AccumulatorLow holds pixels 0-3 and 8-11
+     *      and AccumulatorHigh holds pixels 4-7 and 12-15
+     */
+    inline void AccumulateSquaredGradients(__m128i Left, __m128i Right, __m128i Up, __m128i Down,
+                                           __m256i& AccumulatorLow, __m256i& AccumulatorHigh)
+    {
+        // widen to int16 so the differences cannot overflow
+        const __m256i DeltaX = _mm256_sub_epi16(_mm256_cvtepu8_epi16(Right), _mm256_cvtepu8_epi16(Left));
+        const __m256i DeltaY = _mm256_sub_epi16(_mm256_cvtepu8_epi16(Down), _mm256_cvtepu8_epi16(Up));
+
+        // pair X and Y gradients of the same pixel so madd produces DeltaX^2 + DeltaY^2 per pixel
+        __m256i Pairs = _mm256_unpacklo_epi16(DeltaX, DeltaY);
+        AccumulatorLow = _mm256_add_epi32(AccumulatorLow, _mm256_madd_epi16(Pairs, Pairs));
+        Pairs = _mm256_unpackhi_epi16(DeltaX, DeltaY);
+        AccumulatorHigh = _mm256_add_epi32(AccumulatorHigh, _mm256_madd_epi16(Pairs, Pairs));
+    }
+
+    /**
+     * @brief Restores pixel order of the two accumulators of 16 pixels, converts to double and
+     *      stores them
+     */
+    inline void StoreEnergy(__m256i AccumulatorLow, __m256i AccumulatorHigh, double* OutEnergy)
+    {
+        const __m256i Pixels0To7 = _mm256_permute2x128_si256(AccumulatorLow, AccumulatorHigh, 0x20);
+        const __m256i Pixels8To15 = _mm256_permute2x128_si256(AccumulatorLow, AccumulatorHigh, 0x31);
+
+        _mm256_storeu_pd(OutEnergy, _mm256_cvtepi32_pd(_mm256_castsi256_si128(Pixels0To7)));
+        _mm256_storeu_pd(OutEnergy + 4, _mm256_cvtepi32_pd(_mm256_extracti128_si256(Pixels0To7, 1)));
+        _mm256_storeu_pd(OutEnergy + 8, _mm256_cvtepi32_pd(_mm256_castsi256_si128(Pixels8To15)));
+        _mm256_storeu_pd(OutEnergy + 12, _mm256_cvtepi32_pd(_mm256_extracti128_si256(Pixels8To15, 1)));
+    }
+
+    /**
+     * @brief Restores pixel order of the two accumulators of 16 pixels and stores them as they are
+     */
+    inline void StoreEnergy(__m256i AccumulatorLow, __m256i AccumulatorHigh, int32_t* OutEnergy)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(OutEnergy),
+                            _mm256_permute2x128_si256(AccumulatorLow, AccumulatorHigh, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(OutEnergy + 8),
+                            _mm256_permute2x128_si256(AccumulatorLow, AccumulatorHigh, 0x31));
+    }
+
+    template<typename EnergyType>
+    inline void CalculateEnergy16PixelsC1(const uint8_t* Above, const uint8_t* Current,
+                                          const uint8_t* Below, int32_t Column, EnergyType* OutEnergy)
+    {
+        __m256i AccumulatorLow = _mm256_setzero_si256();
+        __m256i AccumulatorHigh = _mm256_setzero_si256();
+        AccumulateSquaredGradients(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(Current + Column - 1)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(Current + Column + 1)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(Above + Column)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(Below + Column)),
+            AccumulatorLow, AccumulatorHigh);
+        StoreEnergy(AccumulatorLow, AccumulatorHigh, OutEnergy + Column);
+    }
+
+    template<typename EnergyType>
+    inline void CalculateEnergy16PixelsC3(const uint8_t* Above, const uint8_t* Current,
+                                          const uint8_t* Below, int32_t Column, EnergyType* OutEnergy)
+    {
+        __m128i LeftB, LeftG, LeftR;
+        __m128i RightB, RightG, RightR;
+        __m128i UpB, UpG, UpR;
+        __m128i DownB, DownG, DownR;
+
+        DeinterleaveBGR(Current + 3 * (Column - 1), LeftB, LeftG, LeftR);
+        DeinterleaveBGR(Current + 3 * (Column + 1), RightB, RightG, RightR);
+        DeinterleaveBGR(Above + 3 * Column, UpB, UpG, UpR);
+        DeinterleaveBGR(Below + 3 * Column, DownB, DownG, DownR);
+
+        __m256i AccumulatorLow = _mm256_setzero_si256();
+        __m256i AccumulatorHigh = _mm256_setzero_si256();
+        AccumulateSquaredGradients(LeftB, RightB, UpB, DownB, AccumulatorLow, AccumulatorHigh);
+        AccumulateSquaredGradients(LeftG, RightG, UpG, DownG, AccumulatorLow, AccumulatorHigh);
+        AccumulateSquaredGradients(LeftR, RightR, UpR, DownR, AccumulatorLow, AccumulatorHigh);
+        StoreEnergy(AccumulatorLow, AccumulatorHigh, OutEnergy + Column);
+    }
+
+    template<typename EnergyType>
+    void CalculateEnergyRowC1(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below,
+                              int32_t StartColumn, int32_t EndColumn, EnergyType* OutEnergy)
+    {
+        const int32_t CPixelsPerIteration = 32;
+        int32_t Column = StartColumn;
+
+        for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+        {
+            CalculateEnergy16PixelsC1(Above, Current, Below, Column, OutEnergy);
+            CalculateEnergy16PixelsC1(Above, Current, Below, Column + 16, OutEnergy);
+        }
+
+        // half an iteration may still fit before falling back to scalar code
+        if (Column + CPixelsPerIteration / 2 <= EndColumn)
+        {
+            CalculateEnergy16PixelsC1(Above, Current, Below, Column, OutEnergy);
+            Column += CPixelsPerIteration / 2;
+        }
+
+        ct::PixelEnergyKernels::CalculateEnergyRowC1Scalar(Above, Current, Below, Column, EndColumn,
+                                                           OutEnergy);
+    }
+
+    template<typename EnergyType>
+    void CalculateEnergyRowC3(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below,
+                              int32_t StartColumn, int32_t EndColumn, EnergyType* OutEnergy)
+    {
+        const int32_t CPixelsPerIteration = 32;
+        int32_t Column = StartColumn;
+
+        for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+        {
+            CalculateEnergy16PixelsC3(Above, Current, Below, Column, OutEnergy);
+            CalculateEnergy16PixelsC3(Above, Current, Below, Column + 16, OutEnergy);
+        }
+
+        // half an iteration may still fit before falling back to scalar code
+        if (Column + CPixelsPerIteration / 2 <= EndColumn)
+        {
+            CalculateEnergy16PixelsC3(Above, Current, Below, Column, OutEnergy);
+            Column += CPixelsPerIteration / 2;
+        }
+
+        ct::PixelEnergyKernels::CalculateEnergyRowC3Scalar(Above, Current, Below, Column, EndColumn,
+                                                           OutEnergy);
+    }
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC1AVX2(const uint8_t* Above,
+                                                      const uint8_t* Current,
+                                                      const uint8_t* Below,
+                                                      int32_t StartColumn, int32_t EndColumn,
+                                                      double* OutEnergy)
+{
+    CalculateEnergyRowC1(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC1AVX2(const uint8_t* Above,
+                                                      const uint8_t* Current,
+                                                      const uint8_t* Below,
+                                                      int32_t StartColumn, int32_t EndColumn,
+                                                      int32_t* OutEnergy)
+{
+    CalculateEnergyRowC1(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC3AVX2(const uint8_t* Above,
+                                                      const uint8_t* Current,
+                                                      const uint8_t* Below,
+                                                      int32_t StartColumn, int32_t EndColumn,
+                                                      double* OutEnergy)
+{
+    CalculateEnergyRowC3(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC3AVX2(const uint8_t* Above,
+                                                      const uint8_t* Current,
+                                                      const uint8_t* Below,
+                                                      int32_t StartColumn, int32_t EndColumn,
+                                                      int32_t* OutEnergy)
+{
+    CalculateEnergyRowC3(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+#endif
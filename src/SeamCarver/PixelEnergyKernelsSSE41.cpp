@@ -0,0 +1,183 @@
+#include "PixelEnergyKernels.h"
+
+#ifdef CT_X86_SIMD
+#include <smmintrin.h>
+
+namespace
+{
+    /**
+     * @brief Splits 16 interleaved BGR pixels (48 bytes) into one register per channel
+     */
+    inline void DeinterleaveBGR(const uint8_t* Pixels, __m128i& OutB, __m128i& OutG, __m128i& OutR)
+    {
+        const __m128i Chunk0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pixels));
+        const __m128i Chunk1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pixels + 16));
+        const __m128i Chunk2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pixels + 32));
+
+        // every channel takes 5 or 6 bytes out of each 16 byte chunk
+        // indices of -1 zero the byte so the three partial results can be OR'ed together
+        const __m128i B0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i B1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+        const __m128i B2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+
+        const __m128i G0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i G1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+        const __m128i G2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+
+        const __m128i R0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i R1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+        const __m128i R2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+        OutB = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(Chunk0, B0), _mm_shuffle_epi8(Chunk1, B1)),
+                            _mm_shuffle_epi8(Chunk2, B2));
+        OutG = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(Chunk0, G0), _mm_shuffle_epi8(Chunk1, G1)),
+                            _mm_shuffle_epi8(Chunk2, G2));
+        OutR = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(Chunk0, R0), _mm_shuffle_epi8(Chunk1, R1)),
+                            _mm_shuffle_epi8(Chunk2, R2));
+    }
+
+    /**
+     * @brief Adds DeltaX^2 + DeltaY^2 of 16 pixels of one channel to four int32 accumulators
+     *      holding pixels 0-3, 4-7, 8-11 and 12-15
+     */
+    inline void AccumulateSquaredGradients(__m128i Left, __m128i Right, __m128i Up, __m128i Down,
+                                           __m128i* Accumulators)
+    {
+        const __m128i Zero = _mm_setzero_si128();
+
+        // widen to int16 so the differences cannot overflow
+        const __m128i DeltaXLow = _mm_sub_epi16(_mm_cvtepu8_epi16(Right), _mm_cvtepu8_epi16(Left));
+        const __m128i DeltaXHigh = _mm_sub_epi16(_mm_unpackhi_epi8(Right, Zero),
+                                                 _mm_unpackhi_epi8(Left, Zero));
+        const __m128i DeltaYLow = _mm_sub_epi16(_mm_cvtepu8_epi16(Down), _mm_cvtepu8_epi16(Up));
+        const __m128i DeltaYHigh = _mm_sub_epi16(_mm_unpackhi_epi8(Down, Zero),
+                                                 _mm_unpackhi_epi8(Up, Zero));
+
+        // pair X and Y gradients of the same pixel so madd produces DeltaX^2 + DeltaY^2 per pixel
+        __m128i Pairs = _mm_unpacklo_epi16(DeltaXLow, DeltaYLow);
+        Accumulators[0] = _mm_add_epi32(Accumulators[0], _mm_madd_epi16(Pairs, Pairs));
+        Pairs = _mm_unpackhi_epi16(DeltaXLow, DeltaYLow);
+        Accumulators[1] = _mm_add_epi32(Accumulators[1], _mm_madd_epi16(Pairs, Pairs));
+        Pairs = _mm_unpacklo_epi16(DeltaXHigh, DeltaYHigh);
+        Accumulators[2] = _mm_add_epi32(Accumulators[2], _mm_madd_epi16(Pairs, Pairs));
+        Pairs = _mm_unpackhi_epi16(DeltaXHigh, DeltaYHigh);
+        Accumulators[3] = _mm_add_epi32(Accumulators[3], _mm_madd_epi16(Pairs, Pairs));
+    }
+
+    /**
+     * @brief Converts the four int32 accumulators of 16 pixels to double and stores them
+     */
+    inline void StoreEnergy(const __m128i* Accumulators, double* OutEnergy)
+    {
+        for (int32_t Group = 0; Group < 4; Group++)
+        {
+            _mm_storeu_pd(OutEnergy + 4 * Group, _mm_cvtepi32_pd(Accumulators[Group]));
+            _mm_storeu_pd(OutEnergy + 4 * Group + 2,
+                          _mm_cvtepi32_pd(_mm_srli_si128(Accumulators[Group], 8)));
+        }
+    }
+
+    /**
+     * @brief Stores the four int32 accumulators of 16 pixels as they are
+     */
+    inline void StoreEnergy(const __m128i* Accumulators, int32_t* OutEnergy)
+    {
+        for (int32_t Group = 0; Group < 4; Group++)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(OutEnergy + 4 * Group), Accumulators[Group]);
+        }
+    }
+
+    template<typename EnergyType>
+    void CalculateEnergyRowC1(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below,
+                              int32_t StartColumn, int32_t EndColumn, EnergyType* OutEnergy)
+    {
+        const int32_t CPixelsPerIteration = 16;
+        int32_t Column = StartColumn;
+
+        // the right neighbor of the last pixel is at most column EndColumn, which is always in the image
+        for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+        {
+            __m128i Accumulators[4] = { _mm_setzero_si128(), _mm_setzero_si128(),
+                                        _mm_setzero_si128(), _mm_setzero_si128() };
+            AccumulateSquaredGradients(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(Current + Column - 1)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(Current + Column + 1)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(Above + Column)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(Below + Column)),
+                Accumulators);
+            StoreEnergy(Accumulators, OutEnergy + Column);
+        }
+
+        ct::PixelEnergyKernels::CalculateEnergyRowC1Scalar(Above, Current, Below, Column, EndColumn,
+                                                           OutEnergy);
+    }
+
+    template<typename EnergyType>
+    void CalculateEnergyRowC3(const uint8_t* Above, const uint8_t* Current, const uint8_t* Below,
+                              int32_t StartColumn, int32_t EndColumn, EnergyType* OutEnergy)
+    {
+        const int32_t CPixelsPerIteration = 16;
+        int32_t Column = StartColumn;
+
+        __m128i LeftB, LeftG, LeftR;
+        __m128i RightB, RightG, RightR;
+        __m128i UpB, UpG, UpR;
+        __m128i DownB, DownG, DownR;
+
+        for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+        {
+            DeinterleaveBGR(Current + 3 * (Column - 1), LeftB, LeftG, LeftR);
+            DeinterleaveBGR(Current + 3 * (Column + 1), RightB, RightG, RightR);
+            DeinterleaveBGR(Above + 3 * Column, UpB, UpG, UpR);
+            DeinterleaveBGR(Below + 3 * Column, DownB, DownG, DownR);
+
+            __m128i Accumulators[4] = { _mm_setzero_si128(), _mm_setzero_si128(),
+                                        _mm_setzero_si128(), _mm_setzero_si128() };
+            AccumulateSquaredGradients(LeftB, RightB, UpB, DownB, Accumulators);
+            AccumulateSquaredGradients(LeftG, RightG, UpG, DownG, Accumulators);
+            AccumulateSquaredGradients(LeftR, RightR, UpR, DownR, Accumulators);
+            StoreEnergy(Accumulators, OutEnergy + Column);
+        }
+
+        ct::PixelEnergyKernels::CalculateEnergyRowC3Scalar(Above, Current, Below, Column, EndColumn,
+                                                           OutEnergy);
+    }
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC1SSE41(const uint8_t* Above,
+                                                       const uint8_t* Current,
+                                                       const uint8_t* Below,
+                                                       int32_t StartColumn, int32_t EndColumn,
+                                                       double* OutEnergy)
+{
+    CalculateEnergyRowC1(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC1SSE41(const uint8_t* Above,
+                                                       const uint8_t* Current,
+                                                       const uint8_t* Below,
+                                                       int32_t StartColumn, int32_t EndColumn,
+                                                       int32_t* OutEnergy)
+{
+    CalculateEnergyRowC1(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC3SSE41(const uint8_t* Above,
+                                                       const uint8_t* Current,
+                                                       const uint8_t* Below,
+                                                       int32_t StartColumn, int32_t EndColumn,
+                                                       double* OutEnergy)
+{
+    CalculateEnergyRowC3(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+
+void ct::PixelEnergyKernels::CalculateEnergyRowC3SSE41(const uint8_t* Above,
+                                                       const uint8_t* Current,
+                                                       const uint8_t* Below,
+                                                       int32_t StartColumn, int32_t EndColumn,
+                                                       int32_t* OutEnergy)
+{
+    CalculateEnergyRowC3(Above, Current, Below, StartColumn, EndColumn, OutEnergy);
+}
+#endif
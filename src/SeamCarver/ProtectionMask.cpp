@@ -0,0 +1,286 @@
+#include "ProtectionMask.h"
+#include <algorithm>
+
+// defined for callers that bind it to a reference
+const ct::KProtectionMask::KRegionId ct::KProtectionMask::CInvalidRegionId;
+
+ct::KProtectionMask::KProtectionMask(int32_t NumRows, int32_t NumColumns) : KProtectionMask()
+{
+    Resize(NumRows, NumColumns);
+}
+
+void ct::KProtectionMask::Resize(int32_t NumRows, int32_t NumColumns)
+{
+    NumRows_ = NumRows;
+    NumColumns_ = NumColumns;
+
+    ProtectionCounts_.Resize(NumRows_, NumColumns_);
+    ProtectionCounts_.Fill(0);
+    ProtectedPixels_.Resize(NumRows_, NumColumns_);
+    ProtectedPixels_.Fill(false);
+
+    // the bias plane is only allocated once a biased region needs it
+    if (!Biases_.Empty())
+    {
+        Biases_.Resize(NumRows_, NumColumns_);
+        Biases_.Fill(0);
+    }
+
+    for (const auto& Region : Regions_)
+    {
+        Rasterize(Region.second, 1);
+    }
+    UpdateBiasSpans();
+}
+
+ct::KProtectionMask::KRegionId ct::KProtectionMask::AddProtectedRegion(const cv::Rect& Region)
+{
+    KRegion NewRegion;
+    NewRegion.Bounds = Region;
+    NewRegion.Bias = 0;
+    NewRegion.bProtected = true;
+    return AddRegion(NewRegion);
+}
+
+ct::KProtectionMask::KRegionId ct::KProtectionMask::AddProtectedRegion(const cv::Mat& Mask, const cv::Point& Offset)
+{
+    if (Mask.type() != CV_8UC1)
+    {
+        return CInvalidRegionId;
+    }
+
+    // a copy, so the caller may reuse its buffer for the next frame
+    KRegion NewRegion;
+    NewRegion.Bounds = cv::Rect(Offset, Mask.size());
+    Mask.copyTo(NewRegion.Mask);
+    NewRegion.Bias = 0;
+    NewRegion.bProtected = true;
+    return AddRegion(NewRegion);
+}
+
+ct::KProtectionMask::KRegionId ct::KProtectionMask::AddBiasedRegion(const cv::Rect& Region, int32_t Bias)
+{
+    KRegion NewRegion;
+    NewRegion.Bounds = Region;
+    NewRegion.Bias = Bias;
+    NewRegion.bProtected = false;
+    return AddRegion(NewRegion);
+}
+
+ct::KProtectionMask::KRegionId ct::KProtectionMask::AddBiasedRegion(const cv::Mat& Mask, const cv::Point& Offset,
+                                                                    int32_t Bias)
+{
+    if (Mask.type() != CV_8UC1)
+    {
+        return CInvalidRegionId;
+    }
+
+    KRegion NewRegion;
+    NewRegion.Bounds = cv::Rect(Offset, Mask.size());
+    Mask.copyTo(NewRegion.Mask);
+    NewRegion.Bias = Bias;
+    NewRegion.bProtected = false;
+    return AddRegion(NewRegion);
+}
+
+bool ct::KProtectionMask::UpdateRegion(KRegionId Id, const cv::Rect& Region)
+{
+    auto Found = Regions_.find(Id);
+    if (Found == Regions_.end())
+    {
+        return false;
+    }
+
+    // trackers report the same box for objects that did not move
+    KRegion& ExistingRegion = Found->second;
+    if (ExistingRegion.Mask.empty() && ExistingRegion.Bounds == Region)
+    {
+        return true;
+    }
+
+    Rasterize(ExistingRegion, -1);
+    ExistingRegion.Bounds = Region;
+    ExistingRegion.Mask.release();
+    Rasterize(ExistingRegion, 1);
+
+    if (!ExistingRegion.bProtected)
+    {
+        UpdateBiasSpans();
+    }
+    return true;
+}
+
+bool ct::KProtectionMask::UpdateRegion(KRegionId Id, const cv::Mat& Mask, const cv::Point& Offset)
+{
+    auto Found = Regions_.find(Id);
+    if (Found == Regions_.end() || Mask.type() != CV_8UC1)
+    {
+        return false;
+    }
+
+    KRegion& ExistingRegion = Found->second;
+    Rasterize(ExistingRegion, -1);
+    ExistingRegion.Bounds = cv::Rect(Offset, Mask.size());
+    Mask.copyTo(ExistingRegion.Mask);
+    Rasterize(ExistingRegion, 1);
+
+    if (!ExistingRegion.bProtected)
+    {
+        UpdateBiasSpans();
+    }
+    return true;
+}
+
+bool ct::KProtectionMask::MoveRegion(KRegionId Id, const cv::Point& Offset)
+{
+    auto Found = Regions_.find(Id);
+    if (Found == Regions_.end())
+    {
+        return false;
+    }
+
+    KRegion& ExistingRegion = Found->second;
+    if (ExistingRegion.Bounds.tl() == Offset)
+    {
+        return true;
+    }
+
+    Rasterize(ExistingRegion, -1);
+    ExistingRegion.Bounds = cv::Rect(Offset, ExistingRegion.Bounds.size());
+    Rasterize(ExistingRegion, 1);
+
+    if (!ExistingRegion.bProtected)
+    {
+        UpdateBiasSpans();
+    }
+    return true;
+}
+
+bool ct::KProtectionMask::RemoveRegion(KRegionId Id)
+{
+    auto Found = Regions_.find(Id);
+    if (Found == Regions_.end())
+    {
+        return false;
+    }
+
+    Rasterize(Found->second, -1);
+    const bool bProtected = Found->second.bProtected;
+    Regions_.erase(Found);
+
+    if (!bProtected)
+    {
+        NumBiasedRegions_--;
+        UpdateBiasSpans();
+    }
+    return true;
+}
+
+void ct::KProtectionMask::Clear()
+{
+    Regions_.clear();
+    NumBiasedRegions_ = 0;
+    ProtectionCounts_.Fill(0);
+    ProtectedPixels_.Fill(false);
+    Biases_.Fill(0);
+    BiasSpans_.clear();
+}
+
+ct::KProtectionMask::KRegionId ct::KProtectionMask::AddRegion(const KRegion& Region)
+{
+    const KRegionId Id = NextRegionId_++;
+    Regions_[Id] = Region;
+    Rasterize(Region, 1);
+
+    if (!Region.bProtected)
+    {
+        NumBiasedRegions_++;
+        UpdateBiasSpans();
+    }
+    return Id;
+}
+
+void ct::KProtectionMask::Rasterize(const KRegion& Region, int32_t Sign)
+{
+    const cv::Rect Clipped = Region.Bounds & cv::Rect(0, 0, NumColumns_, NumRows_);
+    if (Clipped.width <= 0 || Clipped.height <= 0)
+    {
+        return;
+    }
+
+    if (!Region.bProtected && (Biases_.GetNumRows() != NumRows_ || Biases_.GetNumColumns() != NumColumns_))
+    {
+        Biases_.Resize(NumRows_, NumColumns_);
+        Biases_.Fill(0);
+    }
+
+    for (int32_t Row = Clipped.y; Row < Clipped.y + Clipped.height; Row++)
+    {
+        // mask pixels are indexed by their column in the image minus the left column of the region
+        const uint8_t* MaskPixels = Region.Mask.empty() ? nullptr : Region.Mask.ptr<uint8_t>(Row - Region.Bounds.y);
+        uint16_t* Counts = ProtectionCounts_[Row];
+        int32_t* Biases = Region.bProtected ? nullptr : Biases_[Row];
+
+        for (int32_t Column = Clipped.x; Column < Clipped.x + Clipped.width; Column++)
+        {
+            if (MaskPixels != nullptr && MaskPixels[Column - Region.Bounds.x] == 0)
+            {
+                continue;
+            }
+
+            if (!Region.bProtected)
+            {
+                Biases[Column] += Sign * Region.Bias;
+            }
+            else if (Sign > 0)
+            {
+                if (Counts[Column]++ == 0)
+                {
+                    ProtectedPixels_.Mark(Row, Column);
+                }
+            }
+            else if (--Counts[Column] == 0)
+            {
+                ProtectedPixels_.Unmark(Row, Column);
+            }
+        }
+    }
+}
+
+void ct::KProtectionMask::UpdateBiasSpans()
+{
+    if (NumBiasedRegions_ == 0)
+    {
+        BiasSpans_.clear();
+        return;
+    }
+
+    BiasSpans_.assign(NumRows_, KColumnSpan(0, 0));
+    for (const auto& Region : Regions_)
+    {
+        if (Region.second.bProtected)
+        {
+            continue;
+        }
+
+        const cv::Rect Clipped = Region.second.Bounds & cv::Rect(0, 0, NumColumns_, NumRows_);
+        if (Clipped.width <= 0 || Clipped.height <= 0)
+        {
+            continue;
+        }
+
+        for (int32_t Row = Clipped.y; Row < Clipped.y + Clipped.height; Row++)
+        {
+            KColumnSpan& Span = BiasSpans_[Row];
+            if (Span.first == Span.second)
+            {
+                Span = KColumnSpan(Clipped.x, Clipped.x + Clipped.width);
+            }
+            else
+            {
+                Span.first = std::min(Span.first, Clipped.x);
+                Span.second = std::max(Span.second, Clipped.x + Clipped.width);
+            }
+        }
+    }
+}
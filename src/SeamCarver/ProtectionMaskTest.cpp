@@ -0,0 +1,257 @@
+#include "ProtectionMask.h"
+#include "SeamCarver.h"
+#include "SeamCarverKeepout.h"
+#include "SeamCarverTestHelpers.h"
+#include "gtest/gtest.h"
+#include <random>
+
+namespace
+{
+    using ct::test::IsEqual;
+
+    // channel 0 holds the column of every pixel, so the columns left by the seams can be read back
+    cv::Mat MakeColumnImage(int32_t NumRows, int32_t NumColumns, uint32_t Seed)
+    {
+        std::mt19937 Generator(Seed);
+        cv::Mat Image(NumRows, NumColumns, CV_8UC3);
+        for (int32_t Row = 0; Row < NumRows; Row++)
+        {
+            uint8_t* Pixels = Image.ptr<uint8_t>(Row);
+            for (int32_t Column = 0; Column < NumColumns; Column++)
+            {
+                Pixels[Column * 3] = static_cast<uint8_t>(Column);
+                Pixels[Column * 3 + 1] = static_cast<uint8_t>(Generator() & 0xFF);
+                Pixels[Column * 3 + 2] = static_cast<uint8_t>(Generator() & 0xFF);
+            }
+        }
+        return Image;
+    }
+
+    bool IsColumnKept(const cv::Mat& Image, int32_t Row, int32_t Column)
+    {
+        const uint8_t* Pixels = Image.ptr<uint8_t>(Row);
+        for (int32_t Index = 0; Index < Image.cols; Index++)
+        {
+            if (Pixels[Index * 3] == Column)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ExpectSamePlanes(const ct::KProtectionMask& Mask, const ct::KProtectionMask& Expected)
+    {
+        ASSERT_EQ(Mask.GetNumRows(), Expected.GetNumRows());
+        ASSERT_EQ(Mask.GetNumColumns(), Expected.GetNumColumns());
+        for (int32_t Row = 0; Row < Mask.GetNumRows(); Row++)
+        {
+            for (int32_t Column = 0; Column < Mask.GetNumColumns(); Column++)
+            {
+                ASSERT_EQ(Mask.GetProtectedPixels().IsMarked(Row, Column),
+                          Expected.GetProtectedPixels().IsMarked(Row, Column)) << Row << ", " << Column;
+                const int32_t Bias = Mask.GetBiases().Empty() ? 0 : Mask.GetBiases()[Row][Column];
+                const int32_t ExpectedBias = Expected.GetBiases().Empty() ? 0 : Expected.GetBiases()[Row][Column];
+                ASSERT_EQ(Bias, ExpectedBias) << Row << ", " << Column;
+            }
+        }
+    }
+
+    /**
+     * @brief exposes the marked pixels
+     */
+    class KTestSeamCarver : public ct::KSeamCarverT<int32_t>
+    {
+    public:
+        using ct::KSeamCarverT<int32_t>::MarkedPixels;
+    };
+}
+
+TEST(ProtectionMask, IncrementalUpdatesMatchRasterizingOnce)
+{
+    cv::Mat Circle(9, 9, CV_8UC1, cv::Scalar(0));
+    for (int32_t Row = 0; Row < 9; Row++)
+    {
+        for (int32_t Column = 0; Column < 9; Column++)
+        {
+            Circle.at<uint8_t>(Row, Column) = (Row - 4) * (Row - 4) + (Column - 4) * (Column - 4) <= 16 ? 255 : 0;
+        }
+    }
+
+    ct::KProtectionMask Mask(40, 70);
+    const ct::KProtectionMask::KRegionId Box = Mask.AddProtectedRegion(cv::Rect(5, 5, 10, 10));
+    const ct::KProtectionMask::KRegionId Overlap = Mask.AddProtectedRegion(cv::Rect(10, 8, 10, 10));
+    const ct::KProtectionMask::KRegionId Object = Mask.AddProtectedRegion(Circle, cv::Point(30, 2));
+    const ct::KProtectionMask::KRegionId Prefer = Mask.AddBiasedRegion(cv::Rect(40, 20, 20, 10), -100);
+    const ct::KProtectionMask::KRegionId Soft = Mask.AddBiasedRegion(Circle, cv::Point(45, 22), 30);
+    EXPECT_EQ(Mask.GetNumRegions(), 5);
+    EXPECT_TRUE(Mask.HasBiasedRegions());
+
+    // objects move between frames, the overlapping box leaves, one moves partly out of the image
+    EXPECT_TRUE(Mask.UpdateRegion(Box, cv::Rect(-3, 30, 12, 15)));
+    EXPECT_TRUE(Mask.RemoveRegion(Overlap));
+    EXPECT_TRUE(Mask.MoveRegion(Object, cv::Point(32, 3)));
+    EXPECT_TRUE(Mask.UpdateRegion(Prefer, cv::Rect(50, 18, 25, 10)));
+    EXPECT_TRUE(Mask.MoveRegion(Soft, cv::Point(55, 20)));
+    EXPECT_FALSE(Mask.RemoveRegion(Overlap));
+    EXPECT_EQ(Mask.GetNumRegions(), 4);
+
+    ct::KProtectionMask Expected(40, 70);
+    Expected.AddProtectedRegion(cv::Rect(-3, 30, 12, 15));
+    Expected.AddProtectedRegion(Circle, cv::Point(32, 3));
+    Expected.AddBiasedRegion(cv::Rect(50, 18, 25, 10), -100);
+    Expected.AddBiasedRegion(Circle, cv::Point(55, 20), 30);
+    ExpectSamePlanes(Mask, Expected);
+
+    // biases only exist within the spans
+    EXPECT_EQ(Mask.GetBiasSpan(0), ct::KProtectionMask::KColumnSpan(0, 0));
+    EXPECT_EQ(Mask.GetBiasSpan(19), ct::KProtectionMask::KColumnSpan(50, 70));
+    EXPECT_EQ(Mask.GetBiases()[25][59], 30 - 100);
+
+    // regions keep their image coordinates when the frame size changes
+    Mask.Resize(30, 60);
+    Expected = ct::KProtectionMask(30, 60);
+    Expected.AddProtectedRegion(cv::Rect(-3, 30, 12, 15));
+    Expected.AddProtectedRegion(Circle, cv::Point(32, 3));
+    Expected.AddBiasedRegion(cv::Rect(50, 18, 25, 10), -100);
+    Expected.AddBiasedRegion(Circle, cv::Point(55, 20), 30);
+    ExpectSamePlanes(Mask, Expected);
+
+    Mask.Clear();
+    EXPECT_EQ(Mask.GetNumRegions(), 0);
+    EXPECT_FALSE(Mask.HasBiasedRegions());
+    EXPECT_EQ(Mask.GetProtectedPixels().CountUnmarked(), 30 * 60);
+    EXPECT_EQ(Mask.AddProtectedRegion(cv::Mat(3, 3, CV_8UC3), cv::Point(0, 0)), ct::KProtectionMask::CInvalidRegionId);
+}
+
+TEST(ProtectionMask, SeamsAvoidProtectedRegions)
+{
+    const int32_t NumSeams = 16;
+    cv::Mat Image = MakeColumnImage(48, 64, 5);
+
+    // a box and a thin diagonal line
+    ct::KProtectionMask Mask(Image.rows, Image.cols);
+    Mask.AddProtectedRegion(cv::Rect(6, 4, 20, 30));
+    cv::Mat Diagonal(20, 20, CV_8UC1, cv::Scalar(0));
+    for (int32_t Row = 0; Row < 20; Row++)
+    {
+        Diagonal.at<uint8_t>(Row, Row) = 1;
+    }
+    Mask.AddProtectedRegion(Diagonal, cv::Point(30, 20));
+
+    KTestSeamCarver Carver;
+    cv::Mat Result;
+    ASSERT_TRUE(Carver.FindAndRemoveVerticalSeams(NumSeams, Image, Result, Mask));
+    ASSERT_EQ(Result.cols, Image.cols - NumSeams);
+
+    for (int32_t Row = 0; Row < Image.rows; Row++)
+    {
+        for (int32_t Column = 0; Column < Image.cols; Column++)
+        {
+            if (Mask.GetProtectedPixels().IsMarked(Row, Column))
+            {
+                ASSERT_TRUE(IsColumnKept(Result, Row, Column)) << Row << ", " << Column;
+
+                // protected pixels are only marked during the call
+                ASSERT_FALSE(Carver.MarkedPixels.IsMarked(Row, Column));
+            }
+        }
+    }
+
+    // the same seams as with the region marked by hand
+    KTestSeamCarver MarkedCarver;
+    MarkedCarver.MarkedPixels.Resize(Image.rows, Image.cols);
+    MarkedCarver.MarkedPixels.Fill(false);
+    MarkedCarver.MarkedPixels.Or(Mask.GetProtectedPixels());
+    cv::Mat Expected;
+    ASSERT_TRUE(MarkedCarver.FindAndRemoveVerticalSeams(NumSeams, Image, Expected));
+    EXPECT_TRUE(IsEqual(Result, Expected));
+
+    // a mask of another size is rejected
+    EXPECT_FALSE(Carver.FindAndRemoveVerticalSeams(1, Image, Result, ct::KProtectionMask(Image.rows, Image.cols + 1)));
+}
+
+TEST(ProtectionMask, SeamsPreferNegativeBias)
+{
+    const int32_t NumSeams = 10;
+    const int32_t FirstColumn = 20;
+    cv::Mat Image = MakeColumnImage(32, 60, 8);
+
+    // every pixel of the band drops to energy 0, so all seams run straight down through it
+    ct::KProtectionMask Mask(Image.rows, Image.cols);
+    Mask.AddBiasedRegion(cv::Rect(FirstColumn, 0, NumSeams, Image.rows), -1000000);
+
+    ct::KSeamCarverT<int32_t> Int32Carver;
+    ct::KSeamCarverT<double> DoubleCarver;
+    cv::Mat Int32Result;
+    cv::Mat DoubleResult;
+    ASSERT_TRUE(Int32Carver.FindAndRemoveVerticalSeams(NumSeams, Image, Int32Result, Mask));
+    ASSERT_TRUE(DoubleCarver.FindAndRemoveVerticalSeams(NumSeams, Image, DoubleResult, Mask));
+
+    for (int32_t Row = 0; Row < Image.rows; Row++)
+    {
+        for (int32_t Column = 0; Column < Image.cols; Column++)
+        {
+            const bool bInBand = Column >= FirstColumn && Column < FirstColumn + NumSeams;
+            ASSERT_EQ(IsColumnKept(Int32Result, Row, Column), !bInBand) << Row << ", " << Column;
+            ASSERT_EQ(IsColumnKept(DoubleResult, Row, Column), !bInBand) << Row << ", " << Column;
+        }
+    }
+}
+
+TEST(ProtectionMask, KeepoutRegionIsARegionOfTheMask)
+{
+    const int32_t NumSeams = 12;
+    cv::Mat Image = MakeColumnImage(40, 50, 3);
+
+    ct::SeamCarverKeepout KeepoutCarver(2, 4, 30, 10);
+    EXPECT_EQ(KeepoutCarver.getProtectionMask().GetNumRegions(), 1);
+
+    // moving the keepout region updates the region instead of adding one
+    KeepoutCarver.setKeepoutRegion(5, 10, 20, 15);
+    EXPECT_EQ(KeepoutCarver.getProtectionMask().GetNumRegions(), 1);
+    KeepoutCarver.getProtectionMask().AddProtectedRegion(cv::Rect(35, 30, 5, 5));
+
+    cv::Mat Result;
+    ASSERT_TRUE(KeepoutCarver.findAndRemoveVerticalSeams(NumSeams, Image, Result));
+
+    ct::KProtectionMask Mask(Image.rows, Image.cols);
+    Mask.AddProtectedRegion(cv::Rect(10, 5, 15, 20));
+    Mask.AddProtectedRegion(cv::Rect(35, 30, 5, 5));
+    ct::KSeamCarver Carver;
+    cv::Mat Expected;
+    ASSERT_TRUE(Carver.FindAndRemoveVerticalSeams(NumSeams, Image, Expected, Mask));
+    EXPECT_TRUE(IsEqual(Result, Expected));
+
+    KeepoutCarver.deleteKeepoutRegion();
+    EXPECT_EQ(KeepoutCarver.getProtectionMask().GetNumRegions(), 1);
+}
+
+TEST(ProtectionMask, SameSizeFramesMatchFreshCarver)
+{
+    const int32_t NumSeams = 12;
+    ct::SeamCarverKeepout KeepoutCarver(5, 10, 20, 15);
+    KTestSeamCarver Carver;
+    ct::KProtectionMask Mask(40, 60);
+    const ct::KProtectionMask::KRegionId Object = Mask.AddProtectedRegion(cv::Rect(30, 8, 8, 20));
+
+    // the regions follow objects from frame to frame, the seams of a frame are not kept
+    for (int32_t Frame = 0; Frame < 6; Frame++)
+    {
+        cv::Mat Image = MakeColumnImage(40, 60, Frame);
+        KeepoutCarver.setKeepoutRegion(5 + Frame, 10 + Frame, 20, 15);
+        Mask.MoveRegion(Object, cv::Point(30 + Frame * 2, 8));
+
+        cv::Mat Result;
+        cv::Mat Expected;
+        ASSERT_TRUE(KeepoutCarver.findAndRemoveVerticalSeams(NumSeams, Image, Result)) << "frame " << Frame;
+        ASSERT_TRUE(ct::SeamCarverKeepout(5 + Frame, 10 + Frame, 20, 15).findAndRemoveVerticalSeams(NumSeams, Image,
+                                                                                                   Expected));
+        ASSERT_TRUE(IsEqual(Result, Expected)) << "frame " << Frame;
+
+        ASSERT_TRUE(Carver.FindAndRemoveVerticalSeams(NumSeams, Image, Result, Mask)) << "frame " << Frame;
+        ASSERT_TRUE(ct::KSeamCarverT<int32_t>().FindAndRemoveVerticalSeams(NumSeams, Image, Expected, Mask));
+        ASSERT_TRUE(IsEqual(Result, Expected)) << "frame " << Frame;
+        EXPECT_EQ(Carver.MarkedPixels.CountUnmarked(), Image.rows * Image.cols);
+    }
+}
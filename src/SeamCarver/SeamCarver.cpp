@@ -1,421 +1,2107 @@
 #include "SeamCarver.h"
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 using namespace std::chrono;
 #ifdef USEDEBUGDISPLAY
 #include "DebugDisplay.h"
 #endif
 
-bool ct::KSeamCarver::FindAndRemoveVerticalSeams(int32_t NumSeams, const cv::Mat& img,
-                                                 cv::Mat& outImg, ct::energyFunc computeEnergyFn)
+namespace
+{
+    /**
+     * @brief returns the image a carved image of NumRows x NumColumns is written to. That is
+     *      outImg itself, so its buffer is reused from frame to frame, unless it shares memory
+     *      with img. Then a new image is returned and img and outImg may still be the same
+     */
+    cv::Mat PrepareOutputImage(const cv::Mat& img, cv::Mat& outImg, int32_t NumRows, int32_t NumColumns)
+    {
+        if (outImg.datastart != nullptr && outImg.datastart == img.datastart)
+        {
+            return cv::Mat(NumRows, NumColumns, img.type());
+        }
+        outImg.create(NumRows, NumColumns, img.type());
+        return outImg;
+    }
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindAndRemoveVerticalSeams(int32_t NumSeams, const cv::Mat& img,
+                                                              cv::Mat& outImg, KEnergyFunc computeEnergyFn)
+{
+    KStatsScope StatsScope(*this);
+
+    this->NumRows_ = img.rows;
+    this->NumColumns_ = img.cols;
+    this->BottomRow_ = NumRows_ - 1;
+    this->RightColumn_ = NumColumns_ - 1;
+    this->PosInf_ = KEnergyTraits<EnergyType>::PosInf();
+
+    // check if removing more seams than columns available
+    if (NumSeams > NumColumns_)
+    {
+        return false;
+    }
+
+    /*** DECLARE VECTORS THAT WILL BE USED THROUGHOUT THE SEAM REMOVAL PROCESS ***/
+    // both are kept in the workspace and only reallocated if the image grew
+    // output of the function to compute energy
+    // input to the CurrentSeam finding function
+    KMatrix2D<EnergyType>& PixelEnergy = Workspace_.PixelEnergy;
+    PixelEnergy.Resize(NumRows_, NumColumns_);
+
+    // output of the CurrentSeam finding function
+    // input to the CurrentSeam removal function
+    // one row of NumSeams seam columns per image row, in a single allocation
+    KSeamMatrix& seams = Workspace_.Seams;
+    seams.Resize(NumRows_, NumSeams);
+
+    // make sure MarkedPixels hasn't been set before
+    // resize MarkedPixels matrix to the same size as img;
+    if (MarkedPixels.GetNumRows() != NumRows_ || MarkedPixels.GetNumColumns() != NumColumns_)
+    {
+        MarkedPixels.Resize(NumRows_, NumColumns_);
+        MarkedPixels.Fill(false);
+    }
+
+    try
+    {
+        // Compute pixel energy
+        auto Start = steady_clock::now();
+        if (false == this->CalculateImageEnergy(img, PixelEnergy, computeEnergyFn))
+        {
+            return false;
+        }
+        if (SearchProtection_ != nullptr && SearchProtection_->HasBiasedRegions())
+        {
+            this->ApplyProtectionBias(PixelEnergy);
+        }
+        Stats_.EnergyTime += steady_clock::now() - Start;
+
+        // find all vertical seams
+        Start = steady_clock::now();
+        const bool bFound = this->FindVerticalSeams(NumSeams, PixelEnergy, seams);
+        Stats_.SeamSearchTime += steady_clock::now() - Start;
+
+        // the seams only keep each other apart within this call, so the next frame of the same
+        //      size starts from the pixels marked before it
+        MarkedPixels.AndNot(Workspace_.SeamPixels);
+        if (!bFound)
+        {
+            return false;
+        }
+
+        // remove all found seams straight from the interleaved image
+        Start = steady_clock::now();
+        this->RemoveVerticalSeams(img, seams, outImg);
+        Stats_.SeamRemovalTime += steady_clock::now() - Start;
+    }
+    catch (const std::exception& e)
+    {
+        Stats_.ErrorMessage = e.what();
+        return false;
+    }
+
+    return true;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindAndRemoveVerticalSeams(int32_t NumSeams, const cv::Mat& img,
+                                                              cv::Mat& outImg,
+                                                              const steady_clock::time_point& Deadline,
+                                                              KSeamSearchReport* OutReport,
+                                                              KEnergyFunc computeEnergyFn)
+{
+    KStatsScope StatsScope(*this);
+
+    if (OutReport != nullptr)
+    {
+        OutReport->Clear();
+        OutReport->Strategies.reserve(NumSeams);
+    }
+
+    // FindVerticalSeams picks up the deadline and the report from the members, so every other
+    //      search keeps running without a deadline
+    SearchDeadline_ = Deadline;
+    SearchReport_ = OutReport;
+    const bool bSuccess = this->FindAndRemoveVerticalSeams(NumSeams, img, outImg, computeEnergyFn);
+    SearchDeadline_ = steady_clock::time_point::max();
+    SearchReport_ = nullptr;
+    return bSuccess;
+}
+
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindAndRemoveVerticalSeams(int32_t NumSeams, const cv::Mat& img,
+                                                              cv::Mat& outImg, KSeamCost SeamCost,
+                                                              KEnergyFunc computeEnergyFn)
+{
+    if (SeamCost == KSeamCost::Backward)
+    {
+        return this->FindAndRemoveVerticalSeams(NumSeams, img, outImg, computeEnergyFn);
+    }
+
+    // transition costs are differences of 8 bit pixels
+    if (img.depth() != CV_8U || img.empty())
+    {
+        return false;
+    }
+
+    KStatsScope StatsScope(*this);
+
+    // the cumulative path energy picks the image up from the member, so every other search keeps
+    //      using backward energy
+    Workspace_.ForwardCosts.Resize(3, img.cols);
+    ForwardCostImage_ = &img;
+    const bool bSuccess = this->FindAndRemoveVerticalSeams(NumSeams, img, outImg, computeEnergyFn);
+    ForwardCostImage_ = nullptr;
+    return bSuccess;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindAndRemoveVerticalSeams(int32_t NumSeams, const cv::Mat& img,
+                                                              cv::Mat& outImg, const KProtectionMask& Protection,
+                                                              KEnergyFunc computeEnergyFn)
+{
+    if (Protection.GetNumRows() != img.rows || Protection.GetNumColumns() != img.cols)
+    {
+        return false;
+    }
+
+    KStatsScope StatsScope(*this);
+
+    if (MarkedPixels.GetNumRows() != img.rows || MarkedPixels.GetNumColumns() != img.cols)
+    {
+        MarkedPixels.Resize(img.rows, img.cols);
+        MarkedPixels.Fill(false);
+    }
+
+    // pixels marked before this call stay marked after it, so only the protected pixels that
+    //      were not marked yet are marked now and unmarked again afterwards. The call below
+    //      unmarks the pixels of its own seams, so MarkedPixels is left as it was and the next
+    //      frame of the same size starts from the same state
+    KBitMask2D& ProtectionMarks = Workspace_.ProtectionMarks;
+    ProtectionMarks = Protection.GetProtectedPixels();
+    ProtectionMarks.AndNot(MarkedPixels);
+    MarkedPixels.Or(ProtectionMarks);
+
+    // the biases are picked up from the member after the pixel energy is calculated
+    SearchProtection_ = &Protection;
+    const bool bSuccess = this->FindAndRemoveVerticalSeams(NumSeams, img, outImg, computeEnergyFn);
+    SearchProtection_ = nullptr;
+
+    MarkedPixels.AndNot(ProtectionMarks);
+    return bSuccess;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindAndInsertVerticalSeams(int32_t NumSeams, const cv::Mat& img,
+                                                              cv::Mat& outImg, KEnergyFunc computeEnergyFn)
+{
+    KStatsScope StatsScope(*this);
+
+    this->NumRows_ = img.rows;
+    this->NumColumns_ = img.cols;
+    this->BottomRow_ = NumRows_ - 1;
+    this->RightColumn_ = NumColumns_ - 1;
+    this->PosInf_ = KEnergyTraits<EnergyType>::PosInf();
+
+    // seams of one search are disjoint, so there are at most as many seams as columns
+    if (NumSeams > NumColumns_ || img.depth() != CV_8U)
+    {
+        return false;
+    }
+
+    KMatrix2D<EnergyType>& PixelEnergy = Workspace_.PixelEnergy;
+    PixelEnergy.Resize(NumRows_, NumColumns_);
+
+    KSeamMatrix& seams = Workspace_.Seams;
+    seams.Resize(NumRows_, NumSeams);
+
+    if (MarkedPixels.GetNumRows() != NumRows_ || MarkedPixels.GetNumColumns() != NumColumns_)
+    {
+        MarkedPixels.Resize(NumRows_, NumColumns_);
+        MarkedPixels.Fill(false);
+    }
+
+    try
+    {
+        auto Start = steady_clock::now();
+        if (false == this->CalculateImageEnergy(img, PixelEnergy, computeEnergyFn))
+        {
+            return false;
+        }
+        Stats_.EnergyTime += steady_clock::now() - Start;
+
+        Start = steady_clock::now();
+        const bool bFound = this->FindVerticalSeams(NumSeams, PixelEnergy, seams);
+        Stats_.SeamSearchTime += steady_clock::now() - Start;
+
+        // the seams only keep each other apart within this call, so the next frame of the same
+        //      size starts from the pixels marked before it
+        MarkedPixels.AndNot(Workspace_.SeamPixels);
+        if (!bFound)
+        {
+            return false;
+        }
+
+        Start = steady_clock::now();
+        this->InsertVerticalSeams(img, seams, outImg);
+        Stats_.SeamRemovalTime += steady_clock::now() - Start;
+    }
+    catch (const std::exception& e)
+    {
+        Stats_.ErrorMessage = e.what();
+        return false;
+    }
+
+    return true;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindAndRemoveHorizontalSeams(int32_t NumSeams, const cv::Mat& img,
+                                                                cv::Mat& outImg, KEnergyFunc computeEnergyFn)
+{
+    KStatsScope StatsScope(*this);
+
+    this->NumRows_ = img.rows;
+    this->NumColumns_ = img.cols;
+    this->BottomRow_ = NumRows_ - 1;
+    this->RightColumn_ = NumColumns_ - 1;
+    this->PosInf_ = KEnergyTraits<EnergyType>::PosInf();
+
+    // check if removing more seams than rows available
+    if (NumSeams > NumRows_)
+    {
+        return false;
+    }
+
+    KMatrix2D<EnergyType>& PixelEnergy = Workspace_.PixelEnergy;
+    PixelEnergy.Resize(NumRows_, NumColumns_);
+
+    // one row of NumSeams seam rows per image column
+    KSeamMatrix& seams = Workspace_.Seams;
+    seams.Resize(NumColumns_, NumSeams);
+
+    if (MarkedPixels.GetNumRows() != NumRows_ || MarkedPixels.GetNumColumns() != NumColumns_)
+    {
+        MarkedPixels.Resize(NumRows_, NumColumns_);
+        MarkedPixels.Fill(false);
+    }
+
+    try
+    {
+        auto Start = steady_clock::now();
+        if (false == this->CalculateImageEnergy(img, PixelEnergy, computeEnergyFn))
+        {
+            return false;
+        }
+        Stats_.EnergyTime += steady_clock::now() - Start;
+
+        Start = steady_clock::now();
+        const bool bFound = this->FindHorizontalSeams(NumSeams, PixelEnergy, seams);
+        Stats_.SeamSearchTime += steady_clock::now() - Start;
+
+        // see FindAndRemoveVerticalSeams
+        MarkedPixels.AndNot(Workspace_.SeamPixels);
+        if (!bFound)
+        {
+            return false;
+        }
+
+        Start = steady_clock::now();
+        this->RemoveHorizontalSeams(img, seams, outImg);
+        Stats_.SeamRemovalTime += steady_clock::now() - Start;
+    }
+    catch (const std::exception& e)
+    {
+        Stats_.ErrorMessage = e.what();
+        return false;
+    }
+
+    return true;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindAndRemoveVerticalSeamsIteratively(int32_t NumSeams,
+                                                                         const cv::Mat& img,
+                                                                         cv::Mat& outImg)
+{
+    KStatsScope StatsScope(*this);
+
+    this->NumRows_ = img.rows;
+    this->NumColumns_ = img.cols;
+    this->BottomRow_ = NumRows_ - 1;
+    this->RightColumn_ = NumColumns_ - 1;
+    this->PosInf_ = KEnergyTraits<EnergyType>::PosInf();
+
+    // check if removing more seams than columns available
+    if (NumSeams > NumColumns_ || NumRows_ == 0)
+    {
+        return false;
+    }
+
+    if (MarkedPixels.GetNumRows() != NumRows_ || MarkedPixels.GetNumColumns() != NumColumns_)
+    {
+        MarkedPixels.Resize(NumRows_, NumColumns_);
+        MarkedPixels.Fill(false);
+    }
+
+    // the seams shift MarkedPixels together with the image, the marks of the input are restored
+    //      afterwards
+    KBitMask2D& SavedMarkedPixels = Workspace_.SavedMarkedPixels;
+    SavedMarkedPixels.Resize(NumRows_, NumColumns_);
+    SavedMarkedPixels.Fill(false);
+    SavedMarkedPixels.Or(MarkedPixels);
+
+    cv::Mat& Image = Workspace_.Image;
+    img.copyTo(Image);
+    const bool bSuccess = this->RemoveVerticalSeamsIteratively(NumSeams, Image, nullptr);
+    if (bSuccess)
+    {
+        Image(cv::Rect(0, 0, NumColumns_, NumRows_)).copyTo(outImg);
+    }
+
+    // marked pixels were shifted together with the image and no longer match it, the input
+    //      keeps the marks it had before the call
+    MarkedPixels.Fill(false);
+    MarkedPixels.Or(SavedMarkedPixels);
+    return bSuccess;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::ComputeSeamIndexMap(int32_t NumSeams, const cv::Mat& img,
+                                                       KSeamIndexMap& OutSeamIndexMap)
+{
+    KStatsScope StatsScope(*this);
+
+    this->NumRows_ = img.rows;
+    this->NumColumns_ = img.cols;
+    this->BottomRow_ = NumRows_ - 1;
+    this->RightColumn_ = NumColumns_ - 1;
+    this->PosInf_ = KEnergyTraits<EnergyType>::PosInf();
+
+    // every seam index must fit below KSeamIndexMap::CKeptPixel
+    if (NumSeams > NumColumns_ || NumSeams > KSeamIndexMap::CMaxNumSeams || NumRows_ == 0)
+    {
+        return false;
+    }
+
+    if (MarkedPixels.GetNumRows() != NumRows_ || MarkedPixels.GetNumColumns() != NumColumns_)
+    {
+        MarkedPixels.Resize(NumRows_, NumColumns_);
+        MarkedPixels.Fill(false);
+    }
+
+    // the seams shift MarkedPixels together with the image, the marks of the input are restored
+    //      afterwards
+    KBitMask2D& SavedMarkedPixels = Workspace_.SavedMarkedPixels;
+    SavedMarkedPixels.Resize(NumRows_, NumColumns_);
+    SavedMarkedPixels.Fill(false);
+    SavedMarkedPixels.Or(MarkedPixels);
+
+    cv::Mat SeamIndexMap(NumRows_, NumColumns_, CV_16UC1, cv::Scalar(KSeamIndexMap::CKeptPixel));
+    cv::Mat& Image = Workspace_.Image;
+    img.copyTo(Image);
+    const bool bSuccess = this->RemoveVerticalSeamsIteratively(NumSeams, Image, &SeamIndexMap) &&
+                          OutSeamIndexMap.Assign(SeamIndexMap);
+
+    // marked pixels were shifted together with the image and no longer match it, the input
+    //      keeps the marks it had before the call
+    MarkedPixels.Fill(false);
+    MarkedPixels.Or(SavedMarkedPixels);
+    return bSuccess;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::RemoveVerticalSeamsIteratively(int32_t NumSeams, cv::Mat& Image,
+                                                                  cv::Mat* OutSeamIndexMap)
+{
+    // seams are removed by shifting pixels to the left, so the buffers keep their size and the
+    //      current image is always their left NumColumns_ columns
+    KMatrix2D<EnergyType>& PixelEnergyBuffer = Workspace_.PixelEnergy;
+    PixelEnergyBuffer.Resize(NumRows_, NumColumns_);
+    // one padding column on each side of the cumulative energies, see
+    //      CalculateCumulativeVerticalPathEnergy
+    Workspace_.TotalEnergyTo.Resize(NumRows_, NumColumns_ + 2);
+    Workspace_.ParentOffsets.Resize(NumRows_, NumColumns_);
+    vector<int32_t>& Seam = Workspace_.CurrentSeam;
+    Seam.resize(NumRows_);
+
+    // column of every pixel of the current image in the input, shifted along with the image
+    KMatrix2D<int32_t> OriginalColumns;
+    if (OutSeamIndexMap != nullptr)
+    {
+        OriginalColumns.Resize(NumRows_, NumColumns_);
+        for (int32_t Row = 0; Row < NumRows_; Row++)
+        {
+            for (int32_t Column = 0; Column < NumColumns_; Column++)
+            {
+                OriginalColumns[Row][Column] = Column;
+            }
+        }
+    }
+
+    auto Start = steady_clock::now();
+    PixelEnergyCalculator_->SetDimensions(NumColumns_, NumRows_, Image.channels());
+    if (false == PixelEnergyCalculator_->CalculatePixelEnergy(Image, PixelEnergyBuffer))
+    {
+        return false;
+    }
+    for (int32_t Row = 0; Row < NumRows_; Row++)
+    {
+        this->ApplyMarkedPixelSentinel(PixelEnergyBuffer, Row, 0, NumColumns_);
+    }
+    Stats_.EnergyTime += steady_clock::now() - Start;
+
+    bool bSuccess = true;
+    for (int32_t n = 0; n < NumSeams; n++)
+    {
+        KMatrix2D<EnergyType> PixelEnergy(PixelEnergyBuffer.GetData(), NumRows_, NumColumns_,
+                                          PixelEnergyBuffer.GetStride());
+        EnergyType SeamEnergy;
+        Start = steady_clock::now();
+        const bool bFound = this->FindCheapestVerticalSeam(PixelEnergy, Seam, SeamEnergy);
+        Stats_.SeamSearchTime += steady_clock::now() - Start;
+        if (!bFound)
+        {
+            bSuccess = false;
+            break;
+        }
+
+        Start = steady_clock::now();
+        if (OutSeamIndexMap != nullptr)
+        {
+            for (int32_t Row = 0; Row < NumRows_; Row++)
+            {
+                int32_t* Columns = OriginalColumns[Row];
+                OutSeamIndexMap->at<uint16_t>(Row, Columns[Seam[Row]]) = static_cast<uint16_t>(n);
+                std::memmove(Columns + Seam[Row], Columns + Seam[Row] + 1,
+                             (NumColumns_ - Seam[Row] - 1) * sizeof(int32_t));
+            }
+        }
+
+        this->RemoveVerticalSeamInPlace(Image, PixelEnergy, Seam);
+        NumColumns_--;
+        RightColumn_--;
+        Stats_.SeamRemovalTime += steady_clock::now() - Start;
+
+        Start = steady_clock::now();
+        bSuccess = NumColumns_ == 0 || this->UpdatePixelEnergyAroundVerticalSeam(Image, PixelEnergyBuffer, Seam);
+        Stats_.EnergyTime += steady_clock::now() - Start;
+        if (!bSuccess)
+        {
+            break;
+        }
+    }
+
+    return bSuccess;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::RetargetTo(const cv::Size& Size, const cv::Mat& img, cv::Mat& outImg)
+{
+    KStatsScope StatsScope(*this);
+
+    this->NumRows_ = img.rows;
+    this->NumColumns_ = img.cols;
+    this->BottomRow_ = NumRows_ - 1;
+    this->RightColumn_ = NumColumns_ - 1;
+    this->PosInf_ = KEnergyTraits<EnergyType>::PosInf();
+
+    // seams can only shrink the image
+    if (Size.width < 1 || Size.height < 1 || Size.width > NumColumns_ || Size.height > NumRows_)
+    {
+        return false;
+    }
+
+    if (MarkedPixels.GetNumRows() != NumRows_ || MarkedPixels.GetNumColumns() != NumColumns_)
+    {
+        MarkedPixels.Resize(NumRows_, NumColumns_);
+        MarkedPixels.Fill(false);
+    }
+
+    // the seams shift MarkedPixels together with the image, the marks of the input are restored
+    //      afterwards
+    KBitMask2D& SavedMarkedPixels = Workspace_.SavedMarkedPixels;
+    SavedMarkedPixels.Resize(NumRows_, NumColumns_);
+    SavedMarkedPixels.Fill(false);
+    SavedMarkedPixels.Or(MarkedPixels);
+
+    // seams are removed from a copy of the image in place, so the buffers keep the size of the
+    //      input and the current image is always their top left NumRows_ x NumColumns_ pixels
+    cv::Mat& Image = Workspace_.Image;
+    img.copyTo(Image);
+    KMatrix2D<EnergyType>& PixelEnergyBuffer = Workspace_.PixelEnergy;
+    PixelEnergyBuffer.Resize(NumRows_, NumColumns_);
+    Workspace_.TotalEnergyTo.Resize(NumRows_, NumColumns_ + 2);
+    Workspace_.ParentOffsets.Resize(NumRows_, NumColumns_);
+    Workspace_.HorizontalTotalEnergyTo.Resize(NumRows_, NumColumns_);
+    Workspace_.HorizontalParentOffsets.Resize(NumRows_, NumColumns_);
+    vector<int32_t>& VerticalSeam = Workspace_.CurrentSeam;
+    VerticalSeam.resize(NumRows_);
+    vector<int32_t>& HorizontalSeam = Workspace_.CurrentHorizontalSeam;
+    HorizontalSeam.resize(NumColumns_);
+
+    auto Start = steady_clock::now();
+    PixelEnergyCalculator_->SetDimensions(NumColumns_, NumRows_, Image.channels());
+    if (false == PixelEnergyCalculator_->CalculatePixelEnergy(Image, PixelEnergyBuffer))
+    {
+        return false;
+    }
+    for (int32_t Row = 0; Row < NumRows_; Row++)
+    {
+        this->ApplyMarkedPixelSentinel(PixelEnergyBuffer, Row, 0, NumColumns_);
+    }
+    Stats_.EnergyTime += steady_clock::now() - Start;
+
+    bool bSuccess = true;
+    while (bSuccess && (NumColumns_ > Size.width || NumRows_ > Size.height))
+    {
+        KMatrix2D<EnergyType> PixelEnergy(PixelEnergyBuffer.GetData(), NumRows_, NumColumns_,
+                                          PixelEnergyBuffer.GetStride());
+
+        EnergyType VerticalSeamEnergy = PosInf_;
+        EnergyType HorizontalSeamEnergy = PosInf_;
+        Start = steady_clock::now();
+        bool bVertical = NumColumns_ > Size.width &&
+                         this->FindCheapestVerticalSeam(PixelEnergy, VerticalSeam, VerticalSeamEnergy);
+        const bool bHorizontal = NumRows_ > Size.height &&
+                                 this->FindCheapestHorizontalSeam(PixelEnergy, HorizontalSeam, HorizontalSeamEnergy);
+        Stats_.SeamSearchTime += steady_clock::now() - Start;
+        if (!bVertical && !bHorizontal)
+        {
+            bSuccess = false;
+            break;
+        }
+
+        // a vertical seam has NumRows_ pixels and a horizontal one NumColumns_, so seams are
+        //      compared by the mean energy of their pixels
+        if (bVertical && bHorizontal)
+        {
+            bVertical = static_cast<double>(VerticalSeamEnergy) / NumRows_ <=
+                        static_cast<double>(HorizontalSeamEnergy) / NumColumns_;
+        }
+
+        if (bVertical)
+        {
+            Start = steady_clock::now();
+            this->RemoveVerticalSeamInPlace(Image, PixelEnergy, VerticalSeam);
+            NumColumns_--;
+            RightColumn_--;
+            Stats_.SeamRemovalTime += steady_clock::now() - Start;
+
+            Start = steady_clock::now();
+            bSuccess = this->UpdatePixelEnergyAroundVerticalSeam(Image, PixelEnergyBuffer, VerticalSeam);
+            Stats_.EnergyTime += steady_clock::now() - Start;
+        }
+        else
+        {
+            Start = steady_clock::now();
+            this->RemoveHorizontalSeamInPlace(Image, PixelEnergy, HorizontalSeam);
+            NumRows_--;
+            BottomRow_--;
+            Stats_.SeamRemovalTime += steady_clock::now() - Start;
+
+            Start = steady_clock::now();
+            bSuccess = this->UpdatePixelEnergyAroundHorizontalSeam(Image, PixelEnergyBuffer, HorizontalSeam);
+            Stats_.EnergyTime += steady_clock::now() - Start;
+        }
+    }
+
+    if (bSuccess)
+    {
+        Image(cv::Rect(0, 0, NumColumns_, NumRows_)).copyTo(outImg);
+    }
+
+    // marked pixels were shifted together with the image and no longer match it, the input
+    //      keeps the marks it had before the call
+    MarkedPixels.Fill(false);
+    MarkedPixels.Or(SavedMarkedPixels);
+    return bSuccess;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindCheapestVerticalSeam(const KMatrix2D<EnergyType>& PixelEnergy,
+                                                            vector<int32_t>& OutSeam,
+                                                            EnergyType& OutSeamEnergy)
+{
+    // one padding column on each side of the cumulative energies, see
+    //      CalculateCumulativeVerticalPathEnergy
+    KMatrix2D<EnergyType> TotalEnergyTo(Workspace_.TotalEnergyTo.GetData() + 1, NumRows_, NumColumns_,
+                                        Workspace_.TotalEnergyTo.GetStride());
+    KMatrix2D<int8_t> ColumnTo(Workspace_.ParentOffsets.GetData(), NumRows_, NumColumns_,
+                               Workspace_.ParentOffsets.GetStride());
+
+    this->CalculateCumulativeVerticalPathEnergy(PixelEnergy, TotalEnergyTo, ColumnTo);
+
+    // find least cumulative energy column in bottom row
+    // the mask keeps the width of the input, the columns freed by removed seams are unmarked
+    //      but no longer part of the image
+    EnergyType MinTotalEnergy = PosInf_;
+    int32_t MinTotalEnergyColumn = -1;
+    for (int32_t Column = MarkedPixels.FindFirstUnmarked(BottomRow_, 0);
+         Column != -1 && Column < NumColumns_;
+         Column = MarkedPixels.FindFirstUnmarked(BottomRow_, Column + 1))
+    {
+        if (TotalEnergyTo[BottomRow_][Column] < MinTotalEnergy)
+        {
+            MinTotalEnergy = TotalEnergyTo[BottomRow_][Column];
+            MinTotalEnergyColumn = Column;
+        }
+    }
+
+    // every path runs into a marked pixel
+    if (MinTotalEnergyColumn == -1)
+    {
+        return false;
+    }
+
+    // energies are exact, so the path never runs into a marked pixel
+    OutSeam[BottomRow_] = MinTotalEnergyColumn;
+    for (int32_t Row = BottomRow_ - 1; Row >= 0; Row--)
+    {
+        OutSeam[Row] = OutSeam[Row + 1] + ColumnTo[Row + 1][OutSeam[Row + 1]];
+    }
+    OutSeamEnergy = MinTotalEnergy;
+    return true;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindCheapestHorizontalSeam(const KMatrix2D<EnergyType>& PixelEnergy,
+                                                              vector<int32_t>& OutSeam,
+                                                              EnergyType& OutSeamEnergy)
+{
+    KMatrix2D<EnergyType> TotalEnergyTo(Workspace_.HorizontalTotalEnergyTo.GetData(), NumRows_, NumColumns_,
+                                        Workspace_.HorizontalTotalEnergyTo.GetStride());
+    KMatrix2D<int8_t> RowTo(Workspace_.HorizontalParentOffsets.GetData(), NumRows_, NumColumns_,
+                            Workspace_.HorizontalParentOffsets.GetStride());
+
+    this->CalculateCumulativeHorizontalPathEnergy(PixelEnergy, TotalEnergyTo, RowTo);
+
+    // find least cumulative energy row in the right column
+    EnergyType MinTotalEnergy = PosInf_;
+    int32_t MinTotalEnergyRow = -1;
+    for (int32_t Row = 0; Row < NumRows_; Row++)
+    {
+        if (!MarkedPixels.IsMarked(Row, RightColumn_) && TotalEnergyTo[Row][RightColumn_] < MinTotalEnergy)
+        {
+            MinTotalEnergy = TotalEnergyTo[Row][RightColumn_];
+            MinTotalEnergyRow = Row;
+        }
+    }
+
+    // every path runs into a marked pixel
+    if (MinTotalEnergyRow == -1)
+    {
+        return false;
+    }
+
+    // the cumulative energies avoid marked pixels, so the path never runs into one
+    OutSeam[RightColumn_] = MinTotalEnergyRow;
+    for (int32_t Column = RightColumn_ - 1; Column >= 0; Column--)
+    {
+        OutSeam[Column] = OutSeam[Column + 1] + RowTo[OutSeam[Column + 1]][Column + 1];
+    }
+    OutSeamEnergy = MinTotalEnergy;
+    return true;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::UpdatePixelEnergyAroundVerticalSeam(const cv::Mat& Image,
+                                                                       KMatrix2D<EnergyType>& PixelEnergyBuffer,
+                                                                       const vector<int32_t>& Seam)
+{
+    // only the energy of pixels whose neighbors changed needs to be recomputed. Those are the
+    //      pixels left and right of the seam, plus the pixels between the seam's columns in
+    //      the rows above and below, since their vertical neighbors moved
+    cv::Mat CurrentImage = Image(cv::Rect(0, 0, NumColumns_, NumRows_));
+    KMatrix2D<EnergyType> CurrentPixelEnergy(PixelEnergyBuffer.GetData(), NumRows_, NumColumns_,
+                                             PixelEnergyBuffer.GetStride());
+    PixelEnergyCalculator_->SetDimensions(NumColumns_, NumRows_, Image.channels());
+    for (int32_t Row = 0; Row < NumRows_; Row++)
+    {
+        int32_t MinColumn = Seam[Row];
+        int32_t MaxColumn = Seam[Row];
+        if (Row > 0)
+        {
+            MinColumn = std::min(MinColumn, Seam[Row - 1]);
+            MaxColumn = std::max(MaxColumn, Seam[Row - 1]);
+        }
+        if (Row < BottomRow_)
+        {
+            MinColumn = std::min(MinColumn, Seam[Row + 1]);
+            MaxColumn = std::max(MaxColumn, Seam[Row + 1]);
+        }
+
+        if (!PixelEnergyCalculator_->CalculatePixelEnergyForPixels(CurrentImage, CurrentPixelEnergy,
+                                                                  Row, MinColumn - 1, MaxColumn + 1))
+        {
+            return false;
+        }
+        this->ApplyMarkedPixelSentinel(CurrentPixelEnergy, Row, std::max(MinColumn - 1, 0),
+                                       std::min(MaxColumn + 1, NumColumns_));
+    }
+    return true;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::UpdatePixelEnergyAroundHorizontalSeam(const cv::Mat& Image,
+                                                                         KMatrix2D<EnergyType>& PixelEnergyBuffer,
+                                                                         const vector<int32_t>& Seam)
+{
+    // the pixels above and below the seam and the pixels between the seam's rows in the columns
+    //      to the left and right, since their horizontal neighbors moved
+    cv::Mat CurrentImage = Image(cv::Rect(0, 0, NumColumns_, NumRows_));
+    KMatrix2D<EnergyType> CurrentPixelEnergy(PixelEnergyBuffer.GetData(), NumRows_, NumColumns_,
+                                             PixelEnergyBuffer.GetStride());
+    PixelEnergyCalculator_->SetDimensions(NumColumns_, NumRows_, Image.channels());
+    for (int32_t Column = 0; Column < NumColumns_; Column++)
+    {
+        int32_t MinRow = Seam[Column];
+        int32_t MaxRow = Seam[Column];
+        if (Column > 0)
+        {
+            MinRow = std::min(MinRow, Seam[Column - 1]);
+            MaxRow = std::max(MaxRow, Seam[Column - 1]);
+        }
+        if (Column < RightColumn_)
+        {
+            MinRow = std::min(MinRow, Seam[Column + 1]);
+            MaxRow = std::max(MaxRow, Seam[Column + 1]);
+        }
+
+        // the energy is computed row by row, so the few pixels of a column are computed one by one
+        for (int32_t Row = std::max(MinRow - 1, 0); Row <= std::min(MaxRow, BottomRow_); Row++)
+        {
+            if (!PixelEnergyCalculator_->CalculatePixelEnergyForPixels(CurrentImage, CurrentPixelEnergy,
+                                                                      Row, Column, Column + 1))
+            {
+                return false;
+            }
+            if (MarkedPixels.IsMarked(Row, Column))
+            {
+                CurrentPixelEnergy[Row][Column] = PosInf_;
+            }
+        }
+    }
+    return true;
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindAndRemoveVerticalSeamsCoarseToFine(int32_t NumSeams,
+                                                                          const cv::Mat& img,
+                                                                          cv::Mat& outImg,
+                                                                          int32_t NumLevels,
+                                                                          int32_t BandHalfWidth)
+{
+    KStatsScope StatsScope(*this);
+
+    this->NumRows_ = img.rows;
+    this->NumColumns_ = img.cols;
+    this->BottomRow_ = NumRows_ - 1;
+    this->RightColumn_ = NumColumns_ - 1;
+    this->PosInf_ = KEnergyTraits<EnergyType>::PosInf();
+
+    // check if removing more seams than columns available
+    if (NumSeams > NumColumns_ || NumRows_ == 0)
+    {
+        return false;
+    }
+
+    if (MarkedPixels.GetNumRows() != NumRows_ || MarkedPixels.GetNumColumns() != NumColumns_)
+    {
+        MarkedPixels.Resize(NumRows_, NumColumns_);
+        MarkedPixels.Fill(false);
+    }
+
+    KSeamMatrix& seams = Workspace_.Seams;
+    seams.Resize(NumRows_, NumSeams);
+
+    try
+    {
+        // the pixel energies are calculated within the bands while searching
+        auto Start = steady_clock::now();
+        const bool bFound = this->FindVerticalSeamsCoarseToFine(NumSeams, img, std::max(NumLevels, 0),
+                                                                std::max(BandHalfWidth, 1), seams);
+        Stats_.SeamSearchTime += steady_clock::now() - Start;
+
+        // see FindAndRemoveVerticalSeams
+        MarkedPixels.AndNot(Workspace_.SeamPixels);
+        if (!bFound)
+        {
+            return false;
+        }
+
+        Start = steady_clock::now();
+        this->RemoveVerticalSeams(img, seams, outImg);
+        Stats_.SeamRemovalTime += steady_clock::now() - Start;
+    }
+    catch (const std::exception& e)
+    {
+        Stats_.ErrorMessage = e.what();
+        return false;
+    }
+
+    return true;
+}
+
+template<typename EnergyType>
+ct::KSeamCarverT<EnergyType>::KStatsScope::KStatsScope(KSeamCarverT<EnergyType>& Carver) : Carver_(Carver)
+{
+    if (Carver_.StatsScopeDepth_++ > 0)
+    {
+        return;
+    }
+
+    // only the peak is kept over calls, everything else describes this call
+    const size_t PeakWorkspaceSize = Carver_.Stats_.PeakWorkspaceSize;
+    Carver_.Stats_ = KSeamCarverStats();
+    Carver_.Stats_.PeakWorkspaceSize = PeakWorkspaceSize;
+    Carver_.Workspace_.GetBufferSizes(BufferSizes_);
+    Start_ = steady_clock::now();
+}
+
+template<typename EnergyType>
+ct::KSeamCarverT<EnergyType>::KStatsScope::~KStatsScope()
+{
+    if (--Carver_.StatsScopeDepth_ > 0)
+    {
+        return;
+    }
+
+    KSeamCarverStats& Stats = Carver_.Stats_;
+    Stats.TotalTime = steady_clock::now() - Start_;
+
+    // buffers only change size by being reallocated as a whole
+    typename KWorkspace::KBufferSizes BufferSizes;
+    Carver_.Workspace_.GetBufferSizes(BufferSizes);
+    for (int32_t Buffer = 0; Buffer < KWorkspace::CNumBuffers; Buffer++)
+    {
+        if (BufferSizes[Buffer] != BufferSizes_[Buffer])
+        {
+            Stats.NumBytesAllocated += BufferSizes[Buffer];
+        }
+        Stats.WorkspaceSize += BufferSizes[Buffer];
+    }
+    Stats.PeakWorkspaceSize = std::max(Stats.PeakWorkspaceSize, Stats.WorkspaceSize);
+}
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::CalculateImageEnergy(const cv::Mat& img, KMatrix2D<EnergyType>& OutPixelEnergy,
+                                                        KEnergyFunc computeEnergyFn)
+{
+    if (computeEnergyFn == nullptr)
+    {
+        PixelEnergyCalculator_->SetDimensions(NumColumns_, NumRows_, img.channels());
+        if (false == PixelEnergyCalculator_->CalculatePixelEnergy(img, OutPixelEnergy))
+        {
+            return false;
+        }
+
+#ifdef USEDEBUGDISPLAY
+        KDebugDisplay d;
+        d.Display2DVector<EnergyType>(OutPixelEnergy, PixelEnergyCalculator_->GetMarginEnergy());
+#endif
+        return true;
+    }
+
+    // energy functions chosen at run time write straight into the energy matrix, at the cost of
+    //      one indirect call per image
+    OutPixelEnergy.Resize(NumRows_, NumColumns_);
+    computeEnergyFn(img, OutPixelEnergy);
+    return true;
+}
+
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::SetNumThreads(int32_t NumThreads)
+{
+    if (NumThreads == 1)
+    {
+        ThreadPool_.reset();
+    }
+    else
+    {
+        ThreadPool_ = std::make_shared<KThreadPool>(NumThreads);
+    }
+    PixelEnergyCalculator_->SetThreadPool(ThreadPool_);
+
+    // the coarser pyramid levels share the thread pool, they are created again with the new one
+    Workspace_.CoarseCarver.reset();
+}
+
+template<typename EnergyType>
+int32_t ct::KSeamCarverT<EnergyType>::GetNumThreads() const
+{
+    return ThreadPool_ ? ThreadPool_->GetNumThreads() : 1;
+}
+
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::ReleaseWorkspace()
+{
+    Workspace_ = KWorkspace();
+    Stats_.PeakWorkspaceSize = 0;
+}
+
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindVerticalSeams(int32_t NumSeams,
+                                                     KMatrix2D<EnergyType>& PixelEnergy,
+                                                     KSeamMatrix& OutDiscoveredSeams)
+{
+    // pixels of the seams found by this search, kept apart from pixels marked before it. Cleared
+    //      before anything can fail, so the caller can always unmark them afterwards
+    KBitMask2D& SeamPixels = Workspace_.SeamPixels;
+    SeamPixels.Resize(NumRows_, NumColumns_);
+    SeamPixels.Fill(false);
+
+    if (PixelEnergy.Empty())
+    {
+        throw std::out_of_range("Pixel energy matrix is empty\n");
+    }
+
+    if (OutDiscoveredSeams.GetNumRows() != PixelEnergy.GetNumRows() ||
+        OutDiscoveredSeams.GetNumColumns() != NumSeams)
+    {
+        throw std::out_of_range("OutDiscoveredSeams does not have one row of NumSeams columns per image row\n");
+    }
+
+    // every seam takes one unmarked pixel of the bottom row
+    if (MarkedPixels.CountUnmarked(BottomRow_) < NumSeams)
+    {
+        return false;
+    }
+
+    // pixels marked before the search, e.g. a keepout region, get +INF energy like every pixel
+    //      marked by a seam below
+    for (int32_t Row = 0; Row < NumRows_; Row++)
+    {
+        this->ApplyMarkedPixelSentinel(PixelEnergy, Row, 0, NumColumns_);
+    }
+
+    // TotalEnergyTo will store cumulative energy to each pixel, with one padding column on each
+    //      side (see CalculateCumulativeVerticalPathEnergy)
+    // ColumnTo will store the offset to the columnn of the pixel in the row above to get to
+    //      current pixel
+    Workspace_.TotalEnergyTo.Resize(NumRows_, NumColumns_ + 2);
+    KMatrix2D<EnergyType> TotalEnergyTo(Workspace_.TotalEnergyTo.GetData() + 1, NumRows_, NumColumns_,
+                                        Workspace_.TotalEnergyTo.GetStride());
+    KMatrix2D<int8_t>& ColumnTo = Workspace_.ParentOffsets;
+    ColumnTo.Resize(NumRows_, NumColumns_);
+
+    // initial path calculation
+    this->CalculateCumulativeVerticalPathEnergy(PixelEnergy, TotalEnergyTo, ColumnTo);
+
+    // seams marked since the cumulative energies were last brought up to date, stored one after
+    //      the other with one column per row, and the bottom row columns that were invalidated
+    //      because their path ran into a marked pixel
+    // only the cone below these pixels needs to be recalculated
+    vector<int32_t>& SeamsSinceRecalculation = Workspace_.SeamsSinceRecalculation;
+    vector<int32_t>& InvalidatedColumns = Workspace_.InvalidatedColumns;
+    SeamsSinceRecalculation.clear();
+    InvalidatedColumns.clear();
+
+    // temporary CurrentSeam to verify that there are no previously MarkedPixels 
+    //      in this CurrentSeam
+    // otherwise the cumulative energies need to be recalculated
+    vector<int32_t>& CurrentSeam = Workspace_.CurrentSeam;
+    CurrentSeam.resize(NumRows_);
+
+    // declare/initialize variables used in CurrentSeam discovery when looking for the least
+    //      cumulative energy column in the bottom row
+    EnergyType minTotalEnergy = PosInf_;
+    int32_t minTotalEnergyCol = -1;
+    int32_t col = 0;
+    int32_t currentCol = 0;
+
+    // once the deadline has passed, seams are detoured or walked greedily instead of
+    //      recalculating the cumulative energies
+    const bool bHasDeadline = SearchDeadline_ != steady_clock::time_point::max();
+    bool bPastDeadline = false;
+
+    /*** RUN SEAM DISCOVERY ***/
+    for (int32_t n = 0; n < NumSeams; n++)
+    {
+        if (bHasDeadline && !bPastDeadline && steady_clock::now() >= SearchDeadline_)
+        {
+            bPastDeadline = true;
+            if (SearchReport_ != nullptr)
+            {
+                SearchReport_->bDeadlineReached = true;
+            }
+        }
+        KSeamStrategy Strategy = KSeamStrategy::Exact;
+
+        // find least cumulative energy column in bottom row
+        // initialize total energy to +INF and run linear search for a pixel of least cumulative
+        //      energy (if one exists)
+        minTotalEnergy = PosInf_;
+        minTotalEnergyCol = -1;
+        // only unmarked columns are visited, fully marked spans of 64 columns are skipped at once
+        for (int32_t Column = MarkedPixels.FindFirstUnmarked(BottomRow_, 0); Column != -1;
+             Column = MarkedPixels.FindFirstUnmarked(BottomRow_, Column + 1))
+        {
+            if (TotalEnergyTo[BottomRow_][Column] < minTotalEnergy)
+            {
+                minTotalEnergy = TotalEnergyTo[BottomRow_][Column];
+                minTotalEnergyCol = Column;
+            }
+        }
+
+        // all pixels in bottom row are unreachable due to +INF cumulative energy to all of them
+        // therefore need to recalculate cumulative energies, unless past the deadline a greedy
+        //      seam is found instead
+        if (minTotalEnergyCol == -1)
+        {
+            if (bPastDeadline && this->FindGreedyVerticalSeam(PixelEnergy, CurrentSeam))
+            {
+                Strategy = KSeamStrategy::GreedyDescent;
+            }
+            else
+            {
+                // decrement CurrentSeam number iterator since this CurrentSeam was invalid
+                // need to recalculate the cumulative energy
+                n--;
+
+                // the cumulative energies are up to date, so there is no unmarked path left
+                if (SeamsSinceRecalculation.empty())
+                {
+                    return false;
+                }
+
+                Stats_.NumRecalculations++;
+                if (SearchReport_ != nullptr)
+                {
+                    SearchReport_->NumRecalculations++;
+                }
+                this->RecalculateCumulativeVerticalPathEnergy(PixelEnergy, SeamsSinceRecalculation,
+                                                              InvalidatedColumns, TotalEnergyTo, ColumnTo);
+                SeamsSinceRecalculation.clear();
+                InvalidatedColumns.clear();
+                goto ContinueSeamFindingLoop;
+            }
+        }
+        else
+        {
+            // save last column as part of CurrentSeam
+            CurrentSeam[BottomRow_] = minTotalEnergyCol;
+
+            col = minTotalEnergyCol;
+            currentCol = col;
+            for (int32_t Row = BottomRow_ - 1; Row >= 0; Row--)
+            {
+                // using the below pixel's row and column, extract the column of the pixel in the
+                //      current row
+                currentCol = col + ColumnTo[Row + 1][col];
+
+                // check if the current seam we're swimming up has a pixel that has been used part
+                //      of another seam
+                if (MarkedPixels.IsMarked(Row, currentCol))
+                {
+                    // past the deadline the path continues from the unmarked pixel above of least
+                    //      outdated cumulative energy
+                    int32_t DetourCol = -1;
+                    if (bPastDeadline)
+                    {
+                        EnergyType DetourEnergy = PosInf_;
+                        for (int32_t Column = std::max(col - 1, 0); Column <= std::min(col + 1, RightColumn_); Column++)
+                        {
+                            if (!MarkedPixels.IsMarked(Row, Column) && TotalEnergyTo[Row][Column] < DetourEnergy)
+                            {
+                                DetourEnergy = TotalEnergyTo[Row][Column];
+                                DetourCol = Column;
+                            }
+                        }
+                    }
+
+                    if (DetourCol == -1)
+                    {
+                        // mark the starting pixel in bottom row as having +INF cumulative energy
+                        //      so it will not be chosen again
+                        TotalEnergyTo[BottomRow_][minTotalEnergyCol] = PosInf_;
+                        InvalidatedColumns.push_back(minTotalEnergyCol);
+                        Stats_.NumRejectedSeams++;
+                        // decrement CurrentSeam number iterator since this CurrentSeam was invalid
+                        n--;
+                        // restart CurrentSeam finding loop
+                        goto ContinueSeamFindingLoop;
+                    }
+                    currentCol = DetourCol;
+                    Strategy = KSeamStrategy::StaleEnergy;
+                }
+
+                // save the column of the pixel in the current row
+                CurrentSeam[Row] = currentCol;
+
+                // update to current column
+                col = currentCol;
+            }
+        }
+
+        // mark appropriate pixels
+        for (int32_t Row = 0; Row < NumRows_; Row++)
+        {
+            col = CurrentSeam[Row];
+            MarkedPixels.Mark(Row, col);
+            SeamPixels.Mark(Row, col);
+            PixelEnergy[Row][col] = PosInf_;
+        }
+        SeamsSinceRecalculation.insert(SeamsSinceRecalculation.end(),
+                                       CurrentSeam.begin(), CurrentSeam.end());
+        if (SearchReport_ != nullptr)
+        {
+            SearchReport_->Strategies.push_back(Strategy);
+        }
+
+        ContinueSeamFindingLoop:
+        {
+            continue;
+        }
+    }
+
+    this->CollectVerticalSeams(SeamPixels, OutDiscoveredSeams);
+    return true;
+}
+
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindGreedyVerticalSeam(const KMatrix2D<EnergyType>& PixelEnergy,
+                                                          vector<int32_t>& OutSeam)
+{
+    // the top row only holds border pixels of the same energy, so walks start above the pixels
+    //      of lowest energy in the row below it. A walk that gets stuck is retried from the next
+    //      start, which is still far cheaper than recalculating the cumulative energies
+    const int32_t StartRow = std::min(1, BottomRow_);
+    int32_t TriedColumns[CMaxGreedyAttempts_];
+    for (int32_t Attempt = 0; Attempt < CMaxGreedyAttempts_; Attempt++)
+    {
+        int32_t Column = -1;
+        EnergyType MinEnergy = PosInf_;
+        for (int32_t StartColumn = MarkedPixels.FindFirstUnmarked(0, 0);
+             StartColumn != -1 && StartColumn < NumColumns_;
+             StartColumn = MarkedPixels.FindFirstUnmarked(0, StartColumn + 1))
+        {
+            if (PixelEnergy[StartRow][StartColumn] < MinEnergy &&
+                std::find(TriedColumns, TriedColumns + Attempt, StartColumn) == TriedColumns + Attempt)
+            {
+                MinEnergy = PixelEnergy[StartRow][StartColumn];
+                Column = StartColumn;
+            }
+        }
+
+        if (Column == -1)
+        {
+            return false;
+        }
+        TriedColumns[Attempt] = Column;
+
+        OutSeam[0] = Column;
+        int32_t Row = 1;
+        for (; Row < NumRows_; Row++)
+        {
+            // straight down wins ties, so the seam only bends for lower energy
+            int32_t NextColumn = -1;
+            const int32_t Candidates[3] = { Column, Column - 1, Column + 1 };
+            for (int32_t Candidate : Candidates)
+            {
+                if (Candidate >= 0 && Candidate < NumColumns_ && !MarkedPixels.IsMarked(Row, Candidate) &&
+                    (NextColumn == -1 || PixelEnergy[Row][Candidate] < PixelEnergy[Row][NextColumn]))
+                {
+                    NextColumn = Candidate;
+                }
+            }
+
+            if (NextColumn == -1)
+            {
+                break;
+            }
+            OutSeam[Row] = NextColumn;
+            Column = NextColumn;
+        }
+
+        if (Row == NumRows_)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::CollectVerticalSeams(const KBitMask2D& SeamPixels,
+                                                        KSeamMatrix& OutDiscoveredSeams)
+{
+    // seams never share a pixel, so scanning the bits of a row yields its seam columns already
+    //      in increasing order, without sorting
+    for (int32_t Row = 0; Row < NumRows_; Row++)
+    {
+        int32_t* RowSeams = OutDiscoveredSeams[Row];
+        for (int32_t Column = SeamPixels.FindFirstMarked(Row, 0); Column != -1;
+             Column = SeamPixels.FindFirstMarked(Row, Column + 1))
+        {
+            *RowSeams++ = Column;
+        }
+    }
+}
+
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindVerticalSeamsCoarseToFine(int32_t NumSeams, const cv::Mat& img,
+                                                                 int32_t NumLevels, int32_t BandHalfWidth,
+                                                                 KSeamMatrix& OutDiscoveredSeams)
 {
     this->NumRows_ = img.rows;
     this->NumColumns_ = img.cols;
     this->BottomRow_ = NumRows_ - 1;
     this->RightColumn_ = NumColumns_ - 1;
-    this->PosInf_ = std::numeric_limits<double>::max();
+    this->PosInf_ = KEnergyTraits<EnergyType>::PosInf();
+
+    KMatrix2D<EnergyType>& PixelEnergy = Workspace_.PixelEnergy;
+
+    // removing one column of the coarser level removes two of this one. The coarser level must
+    //      be large enough to be worth searching and leave room between its seams
+    const int32_t NumCoarseSeams = (NumSeams + 1) / 2;
+    const int32_t NumCoarseRows = (NumRows_ + 1) / 2;
+    const int32_t NumCoarseColumns = (NumColumns_ + 1) / 2;
+    bool bRefine = NumLevels > 0 && NumSeams > 0 && img.depth() == CV_8U &&
+                   std::min(NumCoarseRows, NumCoarseColumns) >= CMinPyramidLevelSize_ &&
+                   NumCoarseSeams <= NumCoarseColumns / 2;
+
+    if (bRefine)
+    {
+        cv::Mat& CoarseImage = Workspace_.CoarseImage;
+        cv::pyrDown(img, CoarseImage, cv::Size(NumCoarseColumns, NumCoarseRows));
+
+        // the coarser levels are searched by a carver of their own that shares the thread pool
+        //      and a copy of the energy calculator, so they are searched with the same energy policy.
+        //      It is kept in the workspace, so its buffers are reused by the next call.
+        //      A coarse pixel is marked if any of the four pixels it covers is marked
+        if (Workspace_.CoarseCarver == nullptr)
+        {
+            Workspace_.CoarseCarver.reset(new KSeamCarverT<EnergyType>(CMarginEnergy));
+            Workspace_.CoarseCarver->ThreadPool_ = ThreadPool_;
+            Workspace_.CoarseCarver->PixelEnergyCalculator_ = PixelEnergyCalculator_->Clone();
+        }
+        KSeamCarverT<EnergyType>& CoarseCarver = *Workspace_.CoarseCarver;
+        CoarseCarver.MarkedPixels.Resize(NumCoarseRows, NumCoarseColumns);
+        CoarseCarver.MarkedPixels.Fill(false);
+        for (int32_t Row = 0; Row < NumRows_; Row++)
+        {
+            for (int32_t Column = MarkedPixels.FindFirstMarked(Row, 0); Column != -1;
+                 Column = MarkedPixels.FindFirstMarked(Row, Column + 1))
+            {
+                CoarseCarver.MarkedPixels.Mark(Row / 2, Column / 2);
+            }
+        }
+
+        KSeamMatrix& CoarseSeams = Workspace_.CoarseSeams;
+        CoarseSeams.Resize(NumCoarseRows, NumCoarseSeams);
+        bRefine = CoarseCarver.FindVerticalSeamsCoarseToFine(NumCoarseSeams, CoarseImage, NumLevels - 1,
+                                                             BandHalfWidth, CoarseSeams);
+        if (bRefine)
+        {
+            // seam k is searched around coarse seam k * NumCoarseSeams / NumSeams, scaled to this
+            //      level. The seams sharing a coarse seam are guided to the two columns it covers.
+            //      Odd rows lie between two coarse rows and take the mean of both columns, so the
+            //      guides move by at most one column from row to row and stay sorted
+            KSeamMatrix& GuideSeams = Workspace_.GuideSeams;
+            GuideSeams.Resize(NumRows_, NumSeams);
+            for (int32_t Row = 0; Row < NumRows_; Row++)
+            {
+                const int32_t* CoarseRowSeams = CoarseSeams[Row / 2];
+                const int32_t* NextCoarseRowSeams = CoarseSeams[std::min(Row / 2 + 1, NumCoarseRows - 1)];
+                for (int32_t Seam = 0; Seam < NumSeams; Seam++)
+                {
+                    const int32_t CoarseSeam = Seam * NumCoarseSeams / NumSeams;
+                    const int32_t FirstSeam = (CoarseSeam * NumSeams + NumCoarseSeams - 1) / NumCoarseSeams;
+                    const int32_t Column = Row % 2 == 0 ? 2 * CoarseRowSeams[CoarseSeam] :
+                        CoarseRowSeams[CoarseSeam] + NextCoarseRowSeams[CoarseSeam];
+                    GuideSeams[Row][Seam] = std::min(Column + Seam - FirstSeam, RightColumn_);
+                }
+            }
+
+            // bands cut off by other seams are widened up to MaxHalfWidth, so only the energy of
+            //      the pixels within that width of the guides is needed. The guides of a row are
+            //      sorted, so overlapping bands are merged on the fly
+            const int32_t MaxHalfWidth = CMaxBandWideningFactor_ * BandHalfWidth;
+            PixelEnergyCalculator_->SetDimensions(NumColumns_, NumRows_, img.channels());
+            PixelEnergy.Resize(NumRows_, NumColumns_);
+            for (int32_t Row = 0; Row < NumRows_ && bRefine; Row++)
+            {
+                int32_t SpanStart = 0;
+                int32_t SpanEnd = 0;
+                for (int32_t Seam = 0; Seam <= NumSeams && bRefine; Seam++)
+                {
+                    const int32_t BandStart = Seam < NumSeams ?
+                        std::max(GuideSeams[Row][Seam] - MaxHalfWidth, 0) : NumColumns_ + 1;
+                    if (BandStart > SpanEnd)
+                    {
+                        bRefine = SpanEnd == SpanStart ||
+                            PixelEnergyCalculator_->CalculatePixelEnergyForPixels(img, PixelEnergy, Row,
+                                                                                 SpanStart, SpanEnd);
+                        SpanStart = BandStart;
+                    }
+                    if (Seam < NumSeams)
+                    {
+                        SpanEnd = std::max(SpanEnd, std::min(GuideSeams[Row][Seam] + MaxHalfWidth + 1, NumColumns_));
+                    }
+                }
+            }
+
+            bRefine = bRefine &&
+                this->FindVerticalSeamsInBands(NumSeams, PixelEnergy, GuideSeams, BandHalfWidth,
+                                               MaxHalfWidth, OutDiscoveredSeams);
+        }
+    }
+
+    if (bRefine)
+    {
+        return true;
+    }
+
+    PixelEnergyCalculator_->SetDimensions(NumColumns_, NumRows_, img.channels());
+    if (false == PixelEnergyCalculator_->CalculatePixelEnergy(img, PixelEnergy))
+    {
+        return false;
+    }
+    return this->FindVerticalSeams(NumSeams, PixelEnergy, OutDiscoveredSeams);
+}
+
+
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindVerticalSeamsInBands(int32_t NumSeams,
+                                                            KMatrix2D<EnergyType>& PixelEnergy,
+                                                            const KSeamMatrix& GuideSeams,
+                                                            int32_t HalfWidth,
+                                                            int32_t MaxHalfWidth,
+                                                            KSeamMatrix& OutDiscoveredSeams)
+{
+    // pixels of the seams found by this search, kept apart from pixels marked before it
+    KBitMask2D& SeamPixels = Workspace_.SeamPixels;
+    SeamPixels.Resize(NumRows_, NumColumns_);
+    SeamPixels.Fill(false);
+
+    for (int32_t Row = 0; Row < NumRows_; Row++)
+    {
+        this->ApplyMarkedPixelSentinel(PixelEnergy, Row, 0, NumColumns_);
+    }
+
+    // same layout as the full search, one padding column on each side of the cumulative energies
+    Workspace_.TotalEnergyTo.Resize(NumRows_, NumColumns_ + 2);
+    KMatrix2D<EnergyType> TotalEnergyTo(Workspace_.TotalEnergyTo.GetData() + 1, NumRows_, NumColumns_,
+                                        Workspace_.TotalEnergyTo.GetStride());
+    KMatrix2D<int8_t>& ColumnTo = Workspace_.ParentOffsets;
+    ColumnTo.Resize(NumRows_, NumColumns_);
+
+    vector<int32_t>& CurrentSeam = Workspace_.CurrentSeam;
+    CurrentSeam.resize(NumRows_);
+
+    // seams are searched from left to right, every one avoids the pixels of those found before it
+    for (int32_t Seam = 0; Seam < NumSeams; Seam++)
+    {
+        // the seams found before can cut the band off. It is then searched again at twice the
+        //      width, until it is MaxHalfWidth wide
+        int32_t MinTotalEnergyColumn = -1;
+        for (int32_t BandHalfWidth = HalfWidth; MinTotalEnergyColumn == -1; BandHalfWidth *= 2)
+        {
+            BandHalfWidth = std::min(BandHalfWidth, MaxHalfWidth);
+
+            // the window follows the guide seam, so its ends move by at most one column from row
+            //      to row. Two columns of +INF on each side of the window keep the row kernel from
+            //      picking cumulative energies of the rows outside of it, left over by other seams
+            int32_t StartColumn = 0;
+            int32_t EndColumn = 0;
+            for (int32_t Row = 0; Row < NumRows_; Row++)
+            {
+                const int32_t Center = GuideSeams[Row][Seam];
+                StartColumn = std::max(Center - BandHalfWidth, 0);
+                EndColumn = std::min(Center + BandHalfWidth + 1, NumColumns_);
 
-    // check if removing more seams than columns available
-    if (NumSeams > NumColumns_)
-    {
-        return false;
+                if (Row == 0)
+                {
+                    for (int32_t Column = StartColumn; Column < EndColumn; Column++)
+                    {
+                        TotalEnergyTo[0][Column] = PixelEnergy[0][Column] >= PosInf_ ? PosInf_ : this->CMarginEnergy;
+                        ColumnTo[0][Column] = SeamCarverKernels::CNoParentOffset;
+                    }
+                }
+                else
+                {
+                    this->CalculateCumulativeVerticalPathEnergyRow(PixelEnergy, Row, StartColumn, EndColumn,
+                                                                   TotalEnergyTo, ColumnTo);
+                }
+
+                for (int32_t Column = std::max(StartColumn - 2, -1); Column < StartColumn; Column++)
+                {
+                    TotalEnergyTo[Row][Column] = PosInf_;
+                }
+                for (int32_t Column = EndColumn; Column < std::min(EndColumn + 2, NumColumns_ + 1); Column++)
+                {
+                    TotalEnergyTo[Row][Column] = PosInf_;
+                }
+            }
+
+            // find least cumulative energy column of the window in the bottom row
+            EnergyType MinTotalEnergy = PosInf_;
+            for (int32_t Column = StartColumn; Column < EndColumn; Column++)
+            {
+                if (TotalEnergyTo[BottomRow_][Column] < MinTotalEnergy)
+                {
+                    MinTotalEnergy = TotalEnergyTo[BottomRow_][Column];
+                    MinTotalEnergyColumn = Column;
+                }
+            }
+
+            // every path within the widest band runs into a marked pixel
+            if (MinTotalEnergyColumn == -1 && BandHalfWidth == MaxHalfWidth)
+            {
+                return false;
+            }
+        }
+
+        // marked pixels are at +INF, so the path never runs into one
+        CurrentSeam[BottomRow_] = MinTotalEnergyColumn;
+        for (int32_t Row = BottomRow_ - 1; Row >= 0; Row--)
+        {
+            CurrentSeam[Row] = CurrentSeam[Row + 1] + ColumnTo[Row + 1][CurrentSeam[Row + 1]];
+        }
+
+        // the +INF energy keeps the following seams off this one, MarkedPixels is only updated
+        //      once all seams were found
+        for (int32_t Row = 0; Row < NumRows_; Row++)
+        {
+            SeamPixels.Mark(Row, CurrentSeam[Row]);
+            PixelEnergy[Row][CurrentSeam[Row]] = PosInf_;
+        }
     }
 
-    /*** DECLARE VECTORS THAT WILL BE USED THROUGHOUT THE SEAM REMOVAL PROCESS ***/
-    // output of the function to compute energy
-    // input to the CurrentSeam finding function
-    vector<vector<double>> PixelEnergy;
-    // resize output if necessary
-    PixelEnergy.resize(NumRows_);
-    for (int r = 0; r < NumRows_; r++)
+    MarkedPixels.Or(SeamPixels);
+    this->CollectVerticalSeams(SeamPixels, OutDiscoveredSeams);
+    return true;
+}
+
+
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::CalculateCumulativeVerticalPathEnergy(
+    const KMatrix2D<EnergyType>& PixelEnergy,
+    KMatrix2D<EnergyType>& OutTotalEnergyTo,
+    KMatrix2D<int8_t>& OutColumnTo)
+{
+    // the padding columns on both sides are never reachable, so the row kernel can read the
+    //      up/left and up/right parents of the edge pixels like those of any other pixel
+    // the width shrinks while seams are removed iteratively, so they are written on every call
+    for (int32_t Row = 0; Row < NumRows_; Row++)
     {
-        PixelEnergy[r].resize(NumColumns_);
+        OutTotalEnergyTo[Row][-1] = PosInf_;
+        OutTotalEnergyTo[Row][NumColumns_] = PosInf_;
     }
 
-    // output of the CurrentSeam finding function
-    // input to the CurrentSeam removal function
-    // vector of minimum-oriented priority queues. Each row in the vector corresponds to a
-    //      priority queue for that row in the image
-    VectorOfMinPQ seams;
-    seams.resize(NumRows_);
+    // initialize top row
+    for (int32_t Column = 0; Column < NumColumns_; Column++)
+    {
+        // if previously MarkedPixels, set its energy to +INF
+        OutTotalEnergyTo[0][Column] = PixelEnergy[0][Column] >= PosInf_ ? PosInf_ : this->CMarginEnergy;
+        OutColumnTo[0][Column] = SeamCarverKernels::CNoParentOffset;
+    }
 
-    // make sure MarkedPixels hasn't been set before
-    // resize MarkedPixels matrix to the same size as img;
-    if (MarkedPixels.size() != NumRows_)
+    // find minimum energy path from previous row to every pixel in the current row
+    auto CalculateRows = [&](int32_t StartColumn, int32_t EndColumn, KSpinBarrier* Barrier)
     {
-        MarkedPixels.resize(NumRows_);
-        for (int32_t r = 0; r < NumRows_; r++)
+        for (int32_t Row = 1; Row < NumRows_; Row++)
         {
-            MarkedPixels[r].resize(NumColumns_);
-            for (int32_t c = 0; c < NumColumns_; c++)
+            this->CalculateCumulativeVerticalPathEnergyRow(PixelEnergy, Row, StartColumn, EndColumn,
+                                                           OutTotalEnergyTo, OutColumnTo);
+
+            // the next row of a band reads one column beyond each side of the band
+            if (Barrier != nullptr)
             {
-                MarkedPixels[r][c] = false;
+                Barrier->Wait();
             }
         }
+    };
+
+    int32_t NumBands = 1;
+    if (ThreadPool_ != nullptr)
+    {
+        NumBands = std::min(ThreadPool_->GetNumThreads(), NumColumns_ / CMinColumnsPerBand_);
+    }
+
+    if (NumBands <= 1)
+    {
+        CalculateRows(0, NumColumns_, nullptr);
+        return;
     }
 
-    // vector to store the image's channels separately
-    vector<cv::Mat> bgr;
-    bgr.resize(3);
-    cv::split(img, bgr);
+    // split the columns into vertical bands that advance row by row in lockstep
+    KSpinBarrier Barrier(NumBands);
+    const int32_t ColumnsPerBand = (NumColumns_ + NumBands - 1) / NumBands;
+    ThreadPool_->RunConcurrently(NumBands, [&](int32_t Band)
+    {
+        int32_t StartColumn = Band * ColumnsPerBand;
+        int32_t EndColumn = std::min(StartColumn + ColumnsPerBand, NumColumns_);
+        CalculateRows(StartColumn, EndColumn, &Barrier);
+    });
+}
 
-    try
+
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::CalculateCumulativeVerticalPathEnergyRow(
+    const KMatrix2D<EnergyType>& PixelEnergy,
+    int32_t Row,
+    int32_t StartColumn,
+    int32_t EndColumn,
+    KMatrix2D<EnergyType>& OutTotalEnergyTo,
+    KMatrix2D<int8_t>& OutColumnTo)
+{
+    // marked pixels carry +INF energy, so the kernel needs neither the mask nor bounds checks
+    if (ForwardCostImage_ == nullptr)
+    {
+        CumulativeEnergyRowKernel_(OutTotalEnergyTo[Row - 1], PixelEnergy[Row], StartColumn, EndColumn,
+                                   PosInf_, OutTotalEnergyTo[Row], OutColumnTo[Row]);
+        return;
+    }
+
+    // the costs are only needed for this row, so they are computed into three rows that stay in
+    //      the cache. Bands calculated in parallel write disjoint columns of them
+    KMatrix2D<EnergyType>& ForwardCosts = Workspace_.ForwardCosts;
+    SeamCarverKernels::CalculateForwardCostRow(ForwardCostImage_->ptr<uint8_t>(Row - 1),
+                                               ForwardCostImage_->ptr<uint8_t>(Row), NumColumns_,
+                                               ForwardCostImage_->channels(), StartColumn, EndColumn,
+                                               ForwardCosts[0], ForwardCosts[1], ForwardCosts[2]);
+    ForwardCumulativeEnergyRowKernel_(OutTotalEnergyTo[Row - 1], PixelEnergy[Row], ForwardCosts[0],
+                                      ForwardCosts[1], ForwardCosts[2], StartColumn, EndColumn, PosInf_,
+                                      OutTotalEnergyTo[Row], OutColumnTo[Row]);
+}
+
+
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::RecalculateCumulativeVerticalPathEnergy(
+    const KMatrix2D<EnergyType>& PixelEnergy,
+    const vector<int32_t>& ChangedSeams,
+    const vector<int32_t>& InvalidatedColumns,
+    KMatrix2D<EnergyType>& OutTotalEnergyTo,
+    KMatrix2D<int8_t>& OutColumnTo)
+{
+    typedef typename KWorkspace::KColumnSpan KColumnSpan;
+
+    const int32_t NumChangedSeams = static_cast<int32_t>(ChangedSeams.size()) / NumRows_;
+
+    // spans of columns [first, second) to recalculate in the current row and spans of columns
+    //      whose cumulative energy actually changed in the previous row
+    vector<KColumnSpan>& DirtySpans = Workspace_.DirtySpans;
+    vector<KColumnSpan>& ChangedSpans = Workspace_.ChangedSpans;
+    ChangedSpans.clear();
+
+    // cumulative energies of a span before recalculating it
+    vector<EnergyType>& PreviousTotalEnergyTo = Workspace_.PreviousTotalEnergyTo;
+    PreviousTotalEnergyTo.resize(NumColumns_);
+
+    // without new seams only the invalidated bottom row pixels are out of date
+    for (int32_t Row = NumChangedSeams > 0 ? 0 : BottomRow_; Row < NumRows_; Row++)
     {
-        // allocate min-oriented priority queue for each row to hold NumSeams elements
-        for (int32_t r = 0; r < NumRows_; r++)
+        // every changed pixel can change the three pixels below it, and every newly marked pixel
+        //      changes itself
+        DirtySpans.clear();
+        for (const KColumnSpan& Span : ChangedSpans)
+        {
+            DirtySpans.push_back(KColumnSpan(std::max(Span.first - 1, 0),
+                                             std::min(Span.second + 1, NumColumns_)));
+        }
+        for (int32_t Seam = 0; Seam < NumChangedSeams; Seam++)
+        {
+            int32_t Column = ChangedSeams[Seam * NumRows_ + Row];
+            DirtySpans.push_back(KColumnSpan(Column, Column + 1));
+        }
+        if (Row == BottomRow_)
         {
-            if (!seams[r].allocate(NumSeams))
+            for (int32_t Column : InvalidatedColumns)
             {
-                throw std::exception("Could not allocate memory for min oriented priority queue");
+                DirtySpans.push_back(KColumnSpan(Column, Column + 1));
             }
         }
 
-        auto start = high_resolution_clock::now();
-        auto stop = high_resolution_clock::now();
-        auto duration = duration_cast<microseconds>(stop - start);
-
-        // Compute pixel energy
-        if (computeEnergyFn == nullptr)
+        // merge overlapping and touching spans
+        std::sort(DirtySpans.begin(), DirtySpans.end());
+        size_t NumMergedSpans = 0;
+        for (const KColumnSpan& Span : DirtySpans)
         {
-            start = high_resolution_clock::now();
-            PixelEnergyCalculator_.SetDimensions(NumColumns_, NumRows_, img.channels());
-            if (false == PixelEnergyCalculator_.CalculatePixelEnergy(img, PixelEnergy))
+            if (NumMergedSpans > 0 && Span.first <= DirtySpans[NumMergedSpans - 1].second)
             {
-                return false;
+                DirtySpans[NumMergedSpans - 1].second =
+                    std::max(DirtySpans[NumMergedSpans - 1].second, Span.second);
+            }
+            else
+            {
+                DirtySpans[NumMergedSpans++] = Span;
             }
-            stop = high_resolution_clock::now();
-            duration = duration_cast<microseconds>(stop - start);
-
-#ifdef USEDEBUGDISPLAY
-            KDebugDisplay d;
-            d.Display2DVector<double>(PixelEnergy, PixelEnergyCalculator_.GetMarginEnergy());
-#endif
         }
-        else
+        DirtySpans.resize(NumMergedSpans);
+
+        ChangedSpans.clear();
+        for (const KColumnSpan& Span : DirtySpans)
         {
-            // TODO refactor names/parameters associated with user defined function
-            // call user-defined energy computation function
-            computeEnergyFn(img, PixelEnergy);
-        }
+            std::copy(OutTotalEnergyTo[Row] + Span.first, OutTotalEnergyTo[Row] + Span.second,
+                      PreviousTotalEnergyTo.begin());
 
-        // find all vertical seams
-        start = high_resolution_clock::now();
-        this->FindVerticalSeams(NumSeams, PixelEnergy, seams); // ~2.5s
-        stop = high_resolution_clock::now();
-        duration = duration_cast<microseconds>(stop - start);
-
-        // remove all found seams
-        start = high_resolution_clock::now();
-        //this->markVerticalSeams(bgr, seams);
-        this->RemoveVerticalSeams(bgr, seams);  // ~55ms
-        stop = high_resolution_clock::now();
-        duration = duration_cast<microseconds>(stop - start);
-
-        // combine separate channels into output image
-        start = high_resolution_clock::now();
-        cv::merge(bgr, outImg); // ~300-400us
-        stop = high_resolution_clock::now();
-        duration = duration_cast<microseconds>(stop - start);
-    }
-    catch (std::exception e)
-    {
-        std::cout << e.what() << std::endl;
-        //this->markVerticalSeams(bgr, seams);
-        //this->markInfEnergy(bgr, PixelEnergy);
-        //cv::merge(bgr, outImg);
-        return false;
-    }
+            if (Row == 0)
+            {
+                for (int32_t Column = Span.first; Column < Span.second; Column++)
+                {
+                    OutTotalEnergyTo[0][Column] = PixelEnergy[0][Column] >= PosInf_ ? PosInf_ : this->CMarginEnergy;
+                    OutColumnTo[0][Column] = SeamCarverKernels::CNoParentOffset;
+                }
+            }
+            else
+            {
+                this->CalculateCumulativeVerticalPathEnergyRow(PixelEnergy, Row, Span.first, Span.second,
+                                                               OutTotalEnergyTo, OutColumnTo);
+            }
 
-    return true;
+            // only pixels whose cumulative energy changed affect the next row. Marked parents
+            //      are at +INF, so marking a pixel that was already unreachable changes nothing
+            //      below it
+            for (int32_t Column = Span.first; Column < Span.second; Column++)
+            {
+                if (OutTotalEnergyTo[Row][Column] == PreviousTotalEnergyTo[Column - Span.first])
+                {
+                    continue;
+                }
+
+                if (!ChangedSpans.empty() && ChangedSpans.back().second == Column)
+                {
+                    ChangedSpans.back().second++;
+                }
+                else
+                {
+                    ChangedSpans.push_back(KColumnSpan(Column, Column + 1));
+                }
+            }
+        }
+    }
 }
 
 
-bool ct::KSeamCarver::FindVerticalSeams(int32_t NumSeams, vector<vector<double>>& PixelEnergy,
-                                        VectorOfMinPQ& OutDiscoveredSeams)
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::ApplyMarkedPixelSentinel(KMatrix2D<EnergyType>& PixelEnergy,
+                                                            int32_t Row,
+                                                            int32_t StartColumn,
+                                                            int32_t EndColumn)
 {
-    if (PixelEnergy.size() == 0)
+    // the mask keeps the width of the input, so marked columns past EndColumn are ignored
+    for (int32_t Column = MarkedPixels.FindFirstMarked(Row, StartColumn);
+         Column != -1 && Column < EndColumn;
+         Column = MarkedPixels.FindFirstMarked(Row, Column + 1))
     {
-        throw std::out_of_range("Pixel energy vector is empty\n");
+        PixelEnergy[Row][Column] = PosInf_;
     }
+}
 
-    if (OutDiscoveredSeams.size() != PixelEnergy.size())
+
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::ApplyProtectionBias(KMatrix2D<EnergyType>& PixelEnergy)
+{
+    const KMatrix2D<int32_t>& Biases = SearchProtection_->GetBiases();
+    for (int32_t Row = 0; Row < NumRows_; Row++)
     {
-        throw std::out_of_range("OutDiscoveredSeams does not have enough rows\n");
+        // columns outside the span have no bias, rows without biased regions have an empty span
+        const KProtectionMask::KColumnSpan Span = SearchProtection_->GetBiasSpan(Row);
+        EnergyType* Energies = PixelEnergy[Row];
+        const int32_t* RowBiases = Biases[Row];
+        for (int32_t Column = Span.first; Column < Span.second; Column++)
+        {
+            Energies[Column] = KEnergyTraits<EnergyType>::AddBias(Energies[Column], RowBiases[Column]);
+        }
     }
+}
 
-    int32_t SeamRecalculationCount = 0;
 
-    // TotalEnergyTo will store cumulative energy to each pixel
-    // ColumnTo will store the columnn of the pixel in the row above to get to current pixel
-    vector<vector<double>> TotalEnergyTo;
-    vector<vector<int32_t>> ColumnTo;
+template<typename EnergyType>
+bool ct::KSeamCarverT<EnergyType>::FindHorizontalSeams(int32_t NumSeams,
+                                                       const KMatrix2D<EnergyType>& PixelEnergy,
+                                                       KSeamMatrix& OutDiscoveredSeams)
+{
+    // pixels of the seams found by this search, kept apart from pixels marked before it, see
+    //      FindVerticalSeams
+    KBitMask2D& SeamPixels = Workspace_.SeamPixels;
+    SeamPixels.Resize(NumRows_, NumColumns_);
+    SeamPixels.Fill(false);
 
-    // resize number of rows
-    TotalEnergyTo.resize(NumRows_);
-    ColumnTo.resize(NumRows_);
+    if (PixelEnergy.Empty())
+    {
+        throw std::out_of_range("Pixel energy matrix is empty\n");
+    }
 
-    // resize number of columns for each row
-    for (int32_t r = 0; r < NumRows_; r++)
+    if (OutDiscoveredSeams.GetNumRows() != PixelEnergy.GetNumColumns() ||
+        OutDiscoveredSeams.GetNumColumns() != NumSeams)
     {
-        TotalEnergyTo[r].resize(NumColumns_);
-        ColumnTo[r].resize(NumColumns_);
+        throw std::out_of_range("OutDiscoveredSeams does not have one row of NumSeams rows per image column\n");
     }
 
-    // initial path calculation
-    this->CalculateCumulativeVerticalPathEnergy(PixelEnergy, TotalEnergyTo, ColumnTo);
+    // TotalEnergyTo will store cumulative energy to each pixel
+    // RowTo will store the offset to the row of the pixel in the column to the left to get to
+    //      current pixel
+    KMatrix2D<EnergyType>& TotalEnergyTo = Workspace_.TotalEnergyTo;
+    TotalEnergyTo.Resize(NumRows_, NumColumns_);
+    KMatrix2D<int8_t>& RowTo = Workspace_.ParentOffsets;
+    RowTo.Resize(NumRows_, NumColumns_);
 
-    // temporary CurrentSeam to verify that there are no previously MarkedPixels 
-    //      in this CurrentSeam
-    // otherwise the cumulative energies need to be recalculated
-    vector<int32_t> CurrentSeam;
-    CurrentSeam.resize(NumRows_);
+    this->CalculateCumulativeHorizontalPathEnergy(PixelEnergy, TotalEnergyTo, RowTo);
 
-    // declare/initialize variables used in CurrentSeam discovery when looking for the least
-    //      cumulative energy column in the bottom row
-    double minTotalEnergy = PosInf_;
-    int32_t minTotalEnergyCol = -1;
+    // set once a seam was marked after the last calculation of the cumulative energies
+    bool bMarkedSinceCalculation = false;
 
-    /*** RUN SEAM DISCOVERY ***/
+    vector<int32_t>& CurrentSeam = Workspace_.CurrentSeam;
+    CurrentSeam.resize(NumColumns_);
     for (int32_t n = 0; n < NumSeams; n++)
     {
-        // find least cumulative energy column in bottom row
-        // initialize total energy to +INF and run linear search for a pixel of least cumulative
-        //      energy (if one exists)
-        minTotalEnergy = PosInf_;
-        minTotalEnergyCol = -1;
-        for (int32_t Column = 0; Column < NumColumns_; Column++)
+        // find least cumulative energy row in the right column
+        EnergyType MinTotalEnergy = PosInf_;
+        int32_t MinTotalEnergyRow = -1;
+        for (int32_t Row = 0; Row < NumRows_; Row++)
         {
-            if (!MarkedPixels[BottomRow_][Column] &&
-                TotalEnergyTo[BottomRow_][Column] < minTotalEnergy)
+            if (!MarkedPixels.IsMarked(Row, RightColumn_) && TotalEnergyTo[Row][RightColumn_] < MinTotalEnergy)
             {
-                minTotalEnergy = TotalEnergyTo[BottomRow_][Column];
-                minTotalEnergyCol = Column;
+                MinTotalEnergy = TotalEnergyTo[Row][RightColumn_];
+                MinTotalEnergyRow = Row;
             }
         }
 
-        // all pixels in bottom row are unreachable due to +INF cumulative energy to all of them
-        // therefore need to recalculate cumulative energies
-        if (minTotalEnergyCol == -1)
+        // all pixels in the right column are unreachable, recalculate the cumulative energies
+        if (MinTotalEnergyRow == -1)
         {
-            // decrement CurrentSeam number iterator since this CurrentSeam was invalid
-            // need to recalculate the cumulative energy
+            // the cumulative energies are up to date, so there is no unmarked path left
+            if (!bMarkedSinceCalculation)
+            {
+                return false;
+            }
+
+            this->CalculateCumulativeHorizontalPathEnergy(PixelEnergy, TotalEnergyTo, RowTo);
+            Stats_.NumRecalculations++;
+            bMarkedSinceCalculation = false;
             n--;
-            SeamRecalculationCount++;
-            this->CalculateCumulativeVerticalPathEnergy(PixelEnergy, TotalEnergyTo, ColumnTo);
-            std::cout << "recalculated seam number: " << n + 1 << std::endl;
-            goto ContinueSeamFindingLoop;
+            continue;
         }
 
-        // save last column as part of CurrentSeam
-        CurrentSeam[BottomRow_] = minTotalEnergyCol;
-
-        int32_t col = minTotalEnergyCol;
-        int32_t currentCol = col;
-        for (int32_t Row = BottomRow_ - 1; Row >= 0; Row--)
+        // follow the path to the left column
+        CurrentSeam[RightColumn_] = MinTotalEnergyRow;
+        bool bValidSeam = true;
+        for (int32_t Column = RightColumn_ - 1; Column >= 0; Column--)
         {
-            // using the below pixel's row and column, extract the column of the pixel in the
-            //      current row
-            currentCol = ColumnTo[Row + 1][col];
+            int32_t Row = CurrentSeam[Column + 1] + RowTo[CurrentSeam[Column + 1]][Column + 1];
 
-            // check if the current seam we're swimming up has a pixel that has been used part of
-            //      another seam
-            if (MarkedPixels[Row][currentCol])
+            // path runs into a pixel used by another seam, never start from this pixel again
+            if (MarkedPixels.IsMarked(Row, Column))
             {
-                // mark the starting pixel in bottom row as having +INF cumulative energy so it
-                //      will not be chosen again
-                TotalEnergyTo[BottomRow_][minTotalEnergyCol] = PosInf_;
-                // decrement CurrentSeam number iterator since this CurrentSeam was invalid
-                n--;
-                // restart CurrentSeam finding loop
-                goto ContinueSeamFindingLoop;
+                TotalEnergyTo[MinTotalEnergyRow][RightColumn_] = PosInf_;
+                Stats_.NumRejectedSeams++;
+                bValidSeam = false;
+                break;
             }
+            CurrentSeam[Column] = Row;
+        }
 
-            // save the column of the pixel in the current row
-            CurrentSeam[Row] = currentCol;
-
-            // update to current column
-            col = currentCol;
+        if (!bValidSeam)
+        {
+            n--;
+            continue;
         }
 
-        // copy CurrentSeam and mark appropriate pixels
-        for (int32_t Row = 0; Row < NumRows_; Row++)
+        for (int32_t Column = 0; Column < NumColumns_; Column++)
         {
-            col = CurrentSeam[Row];
-            OutDiscoveredSeams[Row].push(col);
-            MarkedPixels[Row][col] = true;
+            MarkedPixels.Mark(CurrentSeam[Column], Column);
+            SeamPixels.Mark(CurrentSeam[Column], Column);
         }
+        bMarkedSinceCalculation = true;
+    }
 
-        ContinueSeamFindingLoop:
+    // scanning the rows from the top appends the seam rows of every column in increasing order
+    vector<int32_t>& NumFound = Workspace_.ColumnCounts;
+    NumFound.assign(NumColumns_, 0);
+    for (int32_t Row = 0; Row < NumRows_; Row++)
+    {
+        for (int32_t Column = SeamPixels.FindFirstMarked(Row, 0); Column != -1;
+             Column = SeamPixels.FindFirstMarked(Row, Column + 1))
         {
-            continue;
+            OutDiscoveredSeams[Column][NumFound[Column]++] = Row;
         }
     }
-    std::cout << "recalculated total times: " << SeamRecalculationCount << std::endl;
     return true;
 }
 
 
-void ct::KSeamCarver::CalculateCumulativeVerticalPathEnergy(
-    const vector<vector<double>>& PixelEnergy,
-    vector<vector<double>>& OutTotalEnergyTo,
-    vector<vector<int32_t>>& OutColumnTo)
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::CalculateCumulativeHorizontalPathEnergy(
+    const KMatrix2D<EnergyType>& PixelEnergy,
+    KMatrix2D<EnergyType>& OutTotalEnergyTo,
+    KMatrix2D<int8_t>& OutRowTo)
 {
-    // initialize top row
-    for (int32_t Column = 0; Column < NumColumns_; Column++)
+    // initialize left column
+    for (int32_t Row = 0; Row < NumRows_; Row++)
     {
-        // if previously MarkedPixels, set its energy to +INF
-        if (MarkedPixels[0][Column])
-        {
-            OutTotalEnergyTo[0][Column] = PosInf_;
-        }
-        else
-        {
-            OutTotalEnergyTo[0][Column] = this->CMarginEnergy;
-        }
-        OutColumnTo[0][Column] = -1;
+        OutTotalEnergyTo[Row][0] = MarkedPixels.IsMarked(Row, 0) ? PosInf_ : this->CMarginEnergy;
+        OutRowTo[Row][0] = SeamCarverKernels::CNoParentOffset;
     }
 
-    // cache the total energy to the pixels up/left, directly above, and up/right
-    //   instead of accessing memory for the same pixels
-    // shift energy values to the left and access memory only once
-    // SHIFT OPERATION:
-    //   left/above <== directly above
-    //   directly above <== right/above
-    //   right/above = access new memory
-    double energyUpLeft = PosInf_;
-    double energyUp = PosInf_;
-    double energyUpRight = PosInf_;
-
-    bool markedUpLeft = false;
-    bool markedUp = false;
-    bool markedUpRight = false;
+    // every column depends on the whole column to its left, so walking column by column would
+    //      touch a new cache line in every row. Instead, blocks of columns as wide as a cache line
+    //      are swept top to bottom along a diagonal wavefront: step Step computes pixel
+    //      (Step - k, BlockStart + k) for every column k of the block. Its parents in column k - 1
+    //      are at rows Step - k - 1 .. Step - k + 1, which were computed in the previous step or
+    //      earlier in this step, so memory is walked row after row
+    const int32_t CColumnsPerBlock = 8;
 
-    double minEnergy = PosInf_;
-    int32_t minEnergyCol = -1;
-
-    for (int32_t Row = 1; Row < NumRows_; Row++)
+    for (int32_t BlockStart = 1; BlockStart < NumColumns_; BlockStart += CColumnsPerBlock)
     {
-        energyUpLeft = PosInf_;
-        energyUp = OutTotalEnergyTo[Row - 1][0];
-        energyUpRight = NumColumns_ > 1 ? OutTotalEnergyTo[Row - 1][1] : PosInf_;
-
-        markedUpLeft = true;
-        markedUp = MarkedPixels[Row - 1][0];
-        markedUpRight = NumColumns_ > 1 ? MarkedPixels[Row - 1][1] : true;
+        const int32_t BlockEnd = std::min(BlockStart + CColumnsPerBlock, NumColumns_);
+        const int32_t BlockWidth = BlockEnd - BlockStart;
 
-        // find minimum energy path from previous row to every pixel in the current row
-        for (int32_t Column = 0; Column < NumColumns_; Column++)
+        for (int32_t Step = 0; Step < NumRows_ + BlockWidth - 1; Step++)
         {
-            // initialize min energy to +INF and initialize the previous column to -1
-            //   to set error state
-            minEnergy = PosInf_;
-            minEnergyCol = -1;
-
-            // save some cycles by not doing any comparisons if the current pixel has been
-            //      previously MarkedPixels
-            if (!MarkedPixels[Row][Column])
+            const int32_t FirstColumn = BlockStart + std::max(0, Step - BottomRow_);
+            const int32_t LastColumn = std::min(BlockEnd, BlockStart + Step + 1);
+            for (int32_t Column = FirstColumn; Column < LastColumn; Column++)
             {
-                // check above
-                if (!markedUp && energyUp < minEnergy)
-                {
-                    minEnergy = energyUp;
-                    minEnergyCol = Column;
-                }
+                const int32_t Row = Step - (Column - BlockStart);
 
-                // check if right/above is min
-                if (Column < NumColumns_ - 1)
+                // initialize min energy to +INF and initialize the previous row to -1
+                //   to set error state
+                EnergyType MinEnergy = PosInf_;
+                int32_t MinEnergyRow = -1;
+
+                if (!MarkedPixels.IsMarked(Row, Column))
                 {
-                    if (!markedUpRight && energyUpRight < minEnergy)
+                    // check left
+                    if (!MarkedPixels.IsMarked(Row, Column - 1) && OutTotalEnergyTo[Row][Column - 1] < MinEnergy)
                     {
-                        minEnergy = energyUpRight;
-                        minEnergyCol = Column + 1;
+                        MinEnergy = OutTotalEnergyTo[Row][Column - 1];
+                        MinEnergyRow = Row;
                     }
-                }
 
-                // check if left/above is min
-                if (Column > 0)
-                {
-                    if (!markedUpLeft && energyUpLeft < minEnergy)
+                    // check if left/below is min
+                    if (Row < BottomRow_ &&
+                        !MarkedPixels.IsMarked(Row + 1, Column - 1) && OutTotalEnergyTo[Row + 1][Column - 1] < MinEnergy)
+                    {
+                        MinEnergy = OutTotalEnergyTo[Row + 1][Column - 1];
+                        MinEnergyRow = Row + 1;
+                    }
+
+                    // check if left/above is min
+                    if (Row > 0 &&
+                        !MarkedPixels.IsMarked(Row - 1, Column - 1) && OutTotalEnergyTo[Row - 1][Column - 1] < MinEnergy)
                     {
-                        minEnergy = energyUpLeft;
-                        minEnergyCol = Column - 1;
+                        MinEnergy = OutTotalEnergyTo[Row - 1][Column - 1];
+                        MinEnergyRow = Row - 1;
                     }
                 }
+
+                // current pixel is unreachable from parent pixels since they are all marked
+                //   OR current pixel already marked
+                OutTotalEnergyTo[Row][Column] = MinEnergyRow == -1 ?
+                    PosInf_ : KEnergyTraits<EnergyType>::Add(MinEnergy, PixelEnergy[Row][Column]);
+                OutRowTo[Row][Column] = MinEnergyRow == -1 ?
+                    SeamCarverKernels::CNoParentOffset : static_cast<int8_t>(MinEnergyRow - Row);
             }
+        }
+    }
+}
 
-            // shift energy to the left
-            energyUpLeft = energyUp;
-            markedUpLeft = markedUp;
-            energyUp = energyUpRight;
-            markedUp = markedUpRight;
 
-            // get MarkedPixels and TotalEnergyTo data for pixels right/above
-            if (NumColumns_ > 1 && Column < NumColumns_ - 2)
-            {
-                energyUpRight = OutTotalEnergyTo[Row - 1][Column + 2];
-                markedUpRight = MarkedPixels[Row - 1][Column + 2];
-            }
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::InsertVerticalSeams(const cv::Mat& img, const KSeamMatrix& seams,
+                                                       cv::Mat& outImg)
+{
+    const int32_t NumSeams = seams.GetNumColumns();
+    const size_t PixelSize = img.elemSize();
+
+    cv::Mat Result = PrepareOutputImage(img, outImg, NumRows_, NumColumns_ + NumSeams);
+
+    // rows are independent, every output row is written once from left to right
+    auto InsertRows = [&](int32_t StartRow, int32_t EndRow)
+    {
+        for (int32_t Row = StartRow; Row < EndRow; Row++)
+        {
+            const uint8_t* InPixels = img.ptr<uint8_t>(Row);
+            uint8_t* OutPixels = Result.ptr<uint8_t>(Row);
+            int32_t SpanStart = 0;
 
-            // assign cumulative energy to current pixel and save the column of the parent pixel
-            if (minEnergyCol == -1)
+            // seam columns are stored from left to right
+            for (int32_t Seam = 0; Seam < NumSeams; Seam++)
             {
-                // current pixel is unreachable from parent pixels since they are all MarkedPixels
-                //   OR current pixel already MarkedPixels
-                // set energy to reach current pixel to +INF
-                OutTotalEnergyTo[Row][Column] = PosInf_;
+                int32_t SeamColumn = seams[Row][Seam];
+
+                // copy everything up to and including the seam pixel
+                size_t SpanSize = (SeamColumn + 1 - SpanStart) * PixelSize;
+                std::memcpy(OutPixels, InPixels + SpanStart * PixelSize, SpanSize);
+                OutPixels += SpanSize;
+
+                // new pixel is the average of its neighbors, rounded to nearest
+                int32_t NeighborColumn = SeamColumn < RightColumn_ ? SeamColumn + 1 : std::max(SeamColumn - 1, 0);
+                const uint8_t* SeamPixel = InPixels + SeamColumn * PixelSize;
+                const uint8_t* NeighborPixel = InPixels + NeighborColumn * PixelSize;
+                for (size_t Channel = 0; Channel < PixelSize; Channel++)
+                {
+                    OutPixels[Channel] = static_cast<uint8_t>((SeamPixel[Channel] + NeighborPixel[Channel] + 1) >> 1);
+                }
+                OutPixels += PixelSize;
+
+                SpanStart = SeamColumn + 1;
             }
-            else
+
+            std::memcpy(OutPixels, InPixels + SpanStart * PixelSize, (NumColumns_ - SpanStart) * PixelSize);
+        }
+    };
+
+    if (ThreadPool_ != nullptr)
+    {
+        ThreadPool_->ParallelFor(0, NumRows_, InsertRows, CMinRowsPerBand_);
+    }
+    else
+    {
+        InsertRows(0, NumRows_);
+    }
+    outImg = Result;
+}
+
+
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::RemoveHorizontalSeams(const cv::Mat& img, const KSeamMatrix& seams,
+                                                         cv::Mat& outImg)
+{
+    const int32_t NumSeams = seams.GetNumColumns();
+    const size_t PixelSize = img.elemSize();
+
+    // number of pixels already removed above the current output row in every column, which is
+    //      also the index of the next seam row of the column
+    vector<int32_t>& NumRemovedAbove = Workspace_.ColumnCounts;
+    NumRemovedAbove.assign(NumColumns_, 0);
+
+    // the output is written row by row, every pixel is taken from the same column of the input,
+    //      moved up by the number of removed pixels above it. The input rows read for one output
+    //      row lie within NumSeams rows of each other
+    cv::Mat Result = PrepareOutputImage(img, outImg, NumRows_ - NumSeams, NumColumns_);
+    for (int32_t OutRow = 0; OutRow < Result.rows; OutRow++)
+    {
+        uint8_t* OutPixels = Result.ptr<uint8_t>(OutRow);
+        for (int32_t Column = 0; Column < NumColumns_; Column++)
+        {
+            // every column holds one pixel per seam, stored in increasing row order
+            int32_t SourceRow = OutRow + NumRemovedAbove[Column];
+            while (NumRemovedAbove[Column] < NumSeams && seams[Column][NumRemovedAbove[Column]] == SourceRow)
             {
-                OutTotalEnergyTo[Row][Column] = minEnergy + PixelEnergy[Row][Column];
+                NumRemovedAbove[Column]++;
+                SourceRow++;
             }
-            OutColumnTo[Row][Column] = minEnergyCol;
+
+            std::memcpy(OutPixels + Column * PixelSize, img.ptr<uint8_t>(SourceRow) + Column * PixelSize,
+                        PixelSize);
         }
     }
+    outImg = Result;
 }
 
 
-void ct::KSeamCarver::RemoveVerticalSeams(vector<cv::Mat>& bgr, VectorOfMinPQ& seams)
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::RemoveVerticalSeamInPlace(cv::Mat& Image, KMatrix2D<EnergyType>& PixelEnergy,
+                                                             const vector<int32_t>& Seam)
 {
-    // each row of seams stores an ordered queue of pixels to remove in that row
-    //   starting with the min number column
-    // each time a new column is encountered, move the pixels to the right of it
-    //   (up until the next column number) to the left by the number of pixels already removed
-
-    int32_t colToRemove = 0;
-    int32_t numSeamsRemoved = 0;
-    /*** REMOVE PIXELS FOR EVERY ROW ***/
-    for (int32_t r = 0; r < NumRows_; r++)
-    {
-        // SeamRecalculationCount the number of seams to the left of the current pixel
-        //   to indicate how many spaces to move pixels that aren't being removed to the left
-        numSeamsRemoved = 0;
-        // loop through all pixels to remove in current row
-        while (seams[r].size())
-        {
-            numSeamsRemoved++;
-            // column location of pixel to remove in row Row
-            colToRemove = seams[r].pop();
-            //seams[Row].pop();
-            // mark right endpoint/next pixel column
-            int32_t rightColBorder = (seams[r].empty() ? NumColumns_ : seams[r].top());
-            // starting at the column to the right of the column to remove,
-            //      move the pixel to the left by the number of seams to the left of the pixel,
-            //      until the right end point which is either the last column or the next column
-            //      to remove whichever comes first
-            for (int c = colToRemove + 1; c < rightColBorder; c++)
-            {
-                for (int32_t j = 0; j < 3; j++)
+    const size_t PixelSize = Image.elemSize();
+    for (int32_t Row = 0; Row < NumRows_; Row++)
+    {
+        int32_t Column = Seam[Row];
+        int32_t NumShifted = NumColumns_ - Column - 1;
+
+        uint8_t* ImageRow = Image.ptr<uint8_t>(Row);
+        std::memmove(ImageRow + Column * PixelSize, ImageRow + (Column + 1) * PixelSize,
+                     NumShifted * PixelSize);
+        std::memmove(PixelEnergy[Row] + Column, PixelEnergy[Row] + Column + 1,
+                     NumShifted * sizeof(EnergyType));
+        MarkedPixels.EraseColumn(Row, Column);
+    }
+}
+
+
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::RemoveHorizontalSeamInPlace(cv::Mat& Image, KMatrix2D<EnergyType>& PixelEnergy,
+                                                               const vector<int32_t>& Seam)
+{
+    const size_t PixelSize = Image.elemSize();
+    const int32_t MinSeamRow = *std::min_element(Seam.begin(), Seam.begin() + NumColumns_);
+
+    // the pixels are moved up row by row, so every row is read and written in one sweep
+    for (int32_t Row = MinSeamRow; Row < BottomRow_; Row++)
+    {
+        uint8_t* ImageRow = Image.ptr<uint8_t>(Row);
+        const uint8_t* ImageRowBelow = Image.ptr<uint8_t>(Row + 1);
+        for (int32_t Column = 0; Column < NumColumns_; Column++)
+        {
+            if (Seam[Column] <= Row)
+            {
+                std::memcpy(ImageRow + Column * PixelSize, ImageRowBelow + Column * PixelSize, PixelSize);
+                PixelEnergy[Row][Column] = PixelEnergy[Row + 1][Column];
+                if (MarkedPixels.IsMarked(Row + 1, Column))
+                {
+                    MarkedPixels.Mark(Row, Column);
+                }
+                else
                 {
-                    bgr[j].at<uchar>(r, c - numSeamsRemoved) = bgr[j].at<uchar>(r, c);
+                    MarkedPixels.Unmark(Row, Column);
                 }
             }
         }
     }
 
-    /*** SHRINK IMAGE BY REMOVING SEAMS ***/
-    // TODO remove magic number
-    int32_t NumColorChannels = 3;
-    for (int32_t Channel = 0; Channel < NumColorChannels; Channel++)
+    // the row freed at the bottom is no longer part of the image
+    for (int32_t Column = 0; Column < NumColumns_; Column++)
+    {
+        MarkedPixels.Unmark(BottomRow_, Column);
+    }
+}
+
+
+template<typename EnergyType>
+void ct::KSeamCarverT<EnergyType>::RemoveVerticalSeams(const cv::Mat& img, const KSeamMatrix& seams,
+                                                       cv::Mat& outImg)
+{
+    const int32_t NumSeams = seams.GetNumColumns();
+    const size_t PixelSize = img.elemSize();
+
+    cv::Mat Result = PrepareOutputImage(img, outImg, NumRows_, NumColumns_ - NumSeams);
+
+    // each row of seams stores the columns of the pixels to remove in that row
+    //   starting with the min number column
+    // the pixels between two removed columns are copied as one block, rows are independent
+    auto RemoveRows = [&](int32_t StartRow, int32_t EndRow)
+    {
+        for (int32_t Row = StartRow; Row < EndRow; Row++)
+        {
+            const uint8_t* InPixels = img.ptr<uint8_t>(Row);
+            uint8_t* OutPixels = Result.ptr<uint8_t>(Row);
+            int32_t SpanStart = 0;
+
+            for (int32_t Seam = 0; Seam < NumSeams; Seam++)
+            {
+                int32_t ColumnToRemove = seams[Row][Seam];
+                size_t SpanSize = (ColumnToRemove - SpanStart) * PixelSize;
+                std::memcpy(OutPixels, InPixels + SpanStart * PixelSize, SpanSize);
+                OutPixels += SpanSize;
+                SpanStart = ColumnToRemove + 1;
+            }
+
+            std::memcpy(OutPixels, InPixels + SpanStart * PixelSize, (NumColumns_ - SpanStart) * PixelSize);
+        }
+    };
+
+    if (ThreadPool_ != nullptr)
+    {
+        ThreadPool_->ParallelFor(0, NumRows_, RemoveRows, CMinRowsPerBand_);
+    }
+    else
     {
-        bgr[Channel] = bgr[Channel].colRange(0, bgr[Channel].cols - numSeamsRemoved);
+        RemoveRows(0, NumRows_);
     }
+    outImg = Result;
 }
+
+template class ct::KSeamCarverT<double>;
+template class ct::KSeamCarverT<int32_t>;
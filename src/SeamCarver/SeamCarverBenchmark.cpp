@@ -0,0 +1,278 @@
+#include "SeamCarver.h"
+#include "benchmark/benchmark.h"
+#include <algorithm>
+#include <random>
+#include <string>
+
+/**
+ * Microbenchmarks of every stage of the seam carver on synthetic images from 256 x 256 to 8K and
+ *      on the bundled images. Every benchmark reports its throughput in MPixels/s. Results are
+ *      kept with
+ *          SeamCarverBenchmark --benchmark_out=SeamCarver.json --benchmark_out_format=json
+ *      and single stages are picked with e.g. --benchmark_filter=FindVerticalSeams
+ */
+
+#ifndef SEAMCARVER_IMAGES_DIR
+#define SEAMCARVER_IMAGES_DIR "../../images"
+#endif
+
+namespace
+{
+    /**
+     * @brief gives the benchmarks access to the stages of the seam carver
+     */
+    template<typename EnergyType>
+    class KStageSeamCarver : public ct::KSeamCarverT<EnergyType>
+    {
+    public:
+        using ct::KSeamCarverT<EnergyType>::CalculateCumulativeVerticalPathEnergy;
+        using ct::KSeamCarverT<EnergyType>::FindVerticalSeams;
+        using ct::KSeamCarverT<EnergyType>::RemoveVerticalSeams;
+
+        /**
+         * @brief sets the dimensions and the pixel energy calculator up for img and unmarks every
+         *      pixel, as the public calls do before searching seams
+         */
+        void Prepare(const cv::Mat& img)
+        {
+            this->NumRows_ = img.rows;
+            this->NumColumns_ = img.cols;
+            this->BottomRow_ = img.rows - 1;
+            this->RightColumn_ = img.cols - 1;
+            this->MarkedPixels.Resize(img.rows, img.cols);
+            this->MarkedPixels.Fill(false);
+            this->PixelEnergyCalculator_->SetDimensions(img.cols, img.rows, img.channels());
+        }
+
+        bool CalculatePixelEnergy(const cv::Mat& img, ct::KMatrix2D<EnergyType>& OutPixelEnergy)
+        {
+            return this->PixelEnergyCalculator_->CalculatePixelEnergy(img, OutPixelEnergy);
+        }
+
+        void UnmarkPixels() { this->MarkedPixels.Fill(false); }
+    };
+
+    // width and height of the synthetic images
+    const int32_t CImageSizes[][2] = {
+        { 256, 256 },
+        { 1280, 720 },
+        { 1920, 1080 },
+        { 3840, 2160 },
+        { 7680, 4320 }
+    };
+
+    // number of seams, in percent of the image width
+    const int32_t CSeamPercentages[] = { 1, 5, 20 };
+
+    // the seam search costs about pixels times seams, so images larger than this skip seam counts
+    //      above CMaxLargeImageSeamPercentage to keep a full run within minutes
+    const int32_t CMaxFullSweepPixels = 1920 * 1080;
+    const int32_t CMaxLargeImageSeamPercentage = 5;
+
+    const char* CImageNames[] = { "beach.jpg", "bw.png", "eagle.jpg", "guitar.png", "rgb.png", "woods.png" };
+
+    /**
+     * @brief photo-like synthetic image: smooth 32 x 32 pixel blocks with fine noise on top, the
+     *      same for every run
+     */
+    cv::Mat MakeSyntheticImage(int32_t NumColumns, int32_t NumRows)
+    {
+        std::mt19937 Generator(NumColumns * 7919 + NumRows);
+        const int32_t CBlockSize = 32;
+        const int32_t NumBlockColumns = (NumColumns + CBlockSize - 1) / CBlockSize;
+        std::vector<uint8_t> BlockColors(((NumRows + CBlockSize - 1) / CBlockSize) * NumBlockColumns * 3);
+        for (uint8_t& Color : BlockColors)
+        {
+            Color = static_cast<uint8_t>(Generator() % 224);
+        }
+
+        cv::Mat Image(NumRows, NumColumns, CV_8UC3);
+        for (int32_t Row = 0; Row < NumRows; Row++)
+        {
+            uint8_t* Pixels = Image.ptr<uint8_t>(Row);
+            const uint8_t* BlockRow = &BlockColors[(Row / CBlockSize) * NumBlockColumns * 3];
+            for (int32_t Column = 0; Column < NumColumns; Column++)
+            {
+                for (int32_t Channel = 0; Channel < 3; Channel++)
+                {
+                    Pixels[Column * 3 + Channel] = static_cast<uint8_t>(
+                        BlockRow[(Column / CBlockSize) * 3 + Channel] + Generator() % 32);
+                }
+            }
+        }
+        return Image;
+    }
+
+    cv::Mat LoadImage(const std::string& Name)
+    {
+        return cv::imread(std::string(SEAMCARVER_IMAGES_DIR) + "/" + Name);
+    }
+
+    void SetThroughput(benchmark::State& State, const cv::Mat& Image)
+    {
+        State.counters["MPixels/s"] = benchmark::Counter(
+            static_cast<double>(Image.rows) * Image.cols * State.iterations() / 1e6, benchmark::Counter::kIsRate);
+    }
+
+    template<typename EnergyType>
+    void CalculatePixelEnergy(benchmark::State& State, const cv::Mat& Image)
+    {
+        KStageSeamCarver<EnergyType> Carver;
+        Carver.Prepare(Image);
+        ct::KMatrix2D<EnergyType> PixelEnergy(Image.rows, Image.cols);
+        for (auto _ : State)
+        {
+            benchmark::DoNotOptimize(Carver.CalculatePixelEnergy(Image, PixelEnergy));
+        }
+        SetThroughput(State, Image);
+    }
+
+    template<typename EnergyType>
+    void CalculateCumulativeVerticalPathEnergy(benchmark::State& State, const cv::Mat& Image)
+    {
+        KStageSeamCarver<EnergyType> Carver;
+        Carver.Prepare(Image);
+        ct::KMatrix2D<EnergyType> PixelEnergy(Image.rows, Image.cols);
+        Carver.CalculatePixelEnergy(Image, PixelEnergy);
+
+        // one padding column on each side, see CalculateCumulativeVerticalPathEnergy
+        ct::KMatrix2D<EnergyType> TotalEnergyToBuffer(Image.rows, Image.cols + 2);
+        ct::KMatrix2D<EnergyType> TotalEnergyTo(TotalEnergyToBuffer.GetData() + 1, Image.rows, Image.cols,
+                                                TotalEnergyToBuffer.GetStride());
+        ct::KMatrix2D<int8_t> ColumnTo(Image.rows, Image.cols);
+        for (auto _ : State)
+        {
+            Carver.CalculateCumulativeVerticalPathEnergy(PixelEnergy, TotalEnergyTo, ColumnTo);
+            benchmark::ClobberMemory();
+        }
+        SetThroughput(State, Image);
+    }
+
+    template<typename EnergyType>
+    void FindVerticalSeams(benchmark::State& State, const cv::Mat& Image, int32_t NumSeams)
+    {
+        KStageSeamCarver<EnergyType> Carver;
+        Carver.Prepare(Image);
+        ct::KMatrix2D<EnergyType> ImageEnergy(Image.rows, Image.cols);
+        Carver.CalculatePixelEnergy(Image, ImageEnergy);
+        ct::KMatrix2D<EnergyType> PixelEnergy;
+        ct::KSeamMatrix Seams(Image.rows, NumSeams);
+        for (auto _ : State)
+        {
+            // the search marks its seams in the pixel energy and the mask
+            State.PauseTiming();
+            PixelEnergy = ImageEnergy;
+            Carver.UnmarkPixels();
+            State.ResumeTiming();
+
+            if (!Carver.FindVerticalSeams(NumSeams, PixelEnergy, Seams))
+            {
+                State.SkipWithError("seam search failed");
+                break;
+            }
+        }
+        SetThroughput(State, Image);
+    }
+
+    template<typename EnergyType>
+    void RemoveVerticalSeams(benchmark::State& State, const cv::Mat& Image, int32_t NumSeams)
+    {
+        KStageSeamCarver<EnergyType> Carver;
+        Carver.Prepare(Image);
+        ct::KMatrix2D<EnergyType> PixelEnergy(Image.rows, Image.cols);
+        Carver.CalculatePixelEnergy(Image, PixelEnergy);
+        ct::KSeamMatrix Seams(Image.rows, NumSeams);
+        if (!Carver.FindVerticalSeams(NumSeams, PixelEnergy, Seams))
+        {
+            State.SkipWithError("seam search failed");
+            return;
+        }
+
+        cv::Mat OutImage;
+        for (auto _ : State)
+        {
+            Carver.RemoveVerticalSeams(Image, Seams, OutImage);
+            benchmark::ClobberMemory();
+        }
+        SetThroughput(State, Image);
+    }
+
+    template<typename EnergyType>
+    void FindAndRemoveVerticalSeams(benchmark::State& State, const cv::Mat& Image, int32_t NumSeams)
+    {
+        KStageSeamCarver<EnergyType> Carver;
+        cv::Mat OutImage;
+        // repeated calls on the same size reuse every buffer, as for the frames of a video
+        for (auto _ : State)
+        {
+            if (!Carver.FindAndRemoveVerticalSeams(NumSeams, Image, OutImage))
+            {
+                State.SkipWithError("seam removal failed");
+                break;
+            }
+        }
+        SetThroughput(State, Image);
+    }
+
+    template<typename EnergyType>
+    void RegisterBenchmarks(const std::string& TypeName, const std::string& ImageName, const cv::Mat& Image)
+    {
+        const std::string Suffix = "<" + TypeName + ">/" + ImageName;
+        benchmark::RegisterBenchmark(("CalculatePixelEnergy" + Suffix).c_str(),
+                                     CalculatePixelEnergy<EnergyType>, Image)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("CalculateCumulativeVerticalPathEnergy" + Suffix).c_str(),
+                                     CalculateCumulativeVerticalPathEnergy<EnergyType>, Image)
+            ->Unit(benchmark::kMillisecond);
+
+        for (int32_t SeamPercentage : CSeamPercentages)
+        {
+            if (Image.rows * Image.cols > CMaxFullSweepPixels && SeamPercentage > CMaxLargeImageSeamPercentage)
+            {
+                continue;
+            }
+
+            const int32_t NumSeams = std::max(Image.cols * SeamPercentage / 100, 1);
+            const std::string SeamSuffix = Suffix + "/seams:" + std::to_string(NumSeams);
+            benchmark::RegisterBenchmark(("FindVerticalSeams" + SeamSuffix).c_str(),
+                                         FindVerticalSeams<EnergyType>, Image, NumSeams)
+                ->Unit(benchmark::kMillisecond);
+            benchmark::RegisterBenchmark(("RemoveVerticalSeams" + SeamSuffix).c_str(),
+                                         RemoveVerticalSeams<EnergyType>, Image, NumSeams)
+                ->Unit(benchmark::kMillisecond);
+            benchmark::RegisterBenchmark(("FindAndRemoveVerticalSeams" + SeamSuffix).c_str(),
+                                         FindAndRemoveVerticalSeams<EnergyType>, Image, NumSeams)
+                ->Unit(benchmark::kMillisecond);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    for (const auto& Size : CImageSizes)
+    {
+        const cv::Mat Image = MakeSyntheticImage(Size[0], Size[1]);
+        const std::string ImageName = std::to_string(Size[0]) + "x" + std::to_string(Size[1]);
+        RegisterBenchmarks<double>("double", ImageName, Image);
+        RegisterBenchmarks<int32_t>("int32_t", ImageName, Image);
+    }
+
+    // missing images are skipped, e.g. when the benchmark runs outside the source tree
+    for (const char* Name : CImageNames)
+    {
+        const cv::Mat Image = LoadImage(Name);
+        if (!Image.empty())
+        {
+            RegisterBenchmarks<double>("double", Name, Image);
+            RegisterBenchmarks<int32_t>("int32_t", Name, Image);
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
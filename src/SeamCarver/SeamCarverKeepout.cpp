@@ -13,29 +13,12 @@ bool ct::SeamCarverKeepout::findAndRemoveVerticalSeams(int32_t numSeams, const c
     }
   }
 
-  // if marked matrix hasn't been initialized, need to initialize so that keepout region data isn't overwritten in a future memory initialization
-  // default initialization to false
-  // then initialize keepout region
-  if (this->keepoutRegionExists_) {
-    if (MarkedPixels.size() != img.size().height ) {
-      MarkedPixels.resize(img.size().height);
-      for (int32_t r = 0; r < img.size().height; r++) {
-        MarkedPixels[r].resize(img.size().width);
-        for (int32_t c = 0; c < img.size().width; c++) {
-          MarkedPixels[r][c] = false;
-        }
-      }
-    }
-
-    // set pixels to avoid by setting them as previously marked
-    for (int32_t r = this->keepoutRegion_.row_; r < this->keepoutRegion_.row_ + this->keepoutRegion_.height_; r++) {
-      for (int32_t c = this->keepoutRegion_.col_; c < this->keepoutRegion_.col_ + this->keepoutRegion_.width_; c++) {
-        MarkedPixels[r][c] = true;
-      }
-    }
+  // the regions were rasterized when they were set, they are only rasterized again for a new image size
+  if (this->protectionMask_.GetNumRows() != img.size().height || this->protectionMask_.GetNumColumns() != img.size().width) {
+    this->protectionMask_.Resize(img.size().height, img.size().width);
   }
 
-  return KSeamCarver::FindAndRemoveVerticalSeams(numSeams, img, outImg, computeEnergyFn);
+  return KSeamCarver::FindAndRemoveVerticalSeams(numSeams, img, outImg, this->protectionMask_, computeEnergyFn);
 }
 
 
@@ -45,21 +28,23 @@ void ct::SeamCarverKeepout::setKeepoutRegion(int32_t row, int32_t col, int32_t h
   this->keepoutRegion_.height_ = height;
   this->keepoutRegion_.width_ = width;
   this->keepoutRegionExists_ = true;
+
+  // only the pixels of the old and the new region are rasterized
+  const cv::Rect region(col, row, width, height);
+  if (this->keepoutRegionId_ == KProtectionMask::CInvalidRegionId) {
+    this->keepoutRegionId_ = this->protectionMask_.AddProtectedRegion(region);
+  }
+  else {
+    this->protectionMask_.UpdateRegion(this->keepoutRegionId_, region);
+  }
 }
 
 
 void ct::SeamCarverKeepout::deleteKeepoutRegion() {
-  // check if marked matrix has been allocated
-  // if not, then don't need to unmark pixels in the keepout region
-  if (this->keepoutRegionExists_ && this->MarkedPixels.size() > 0) {
-    // unmark mixels marked by keepout region
-    if (this->keepoutRegion_.row_ + this->keepoutRegion_.height_ >= (int32_t)MarkedPixels.size()) {
-      for (int32_t r = this->keepoutRegion_.row_; r < this->keepoutRegion_.row_ + this->keepoutRegion_.height_; r++) {
-        for (int32_t c = this->keepoutRegion_.col_; c < this->keepoutRegion_.col_ + this->keepoutRegion_.width_; c++) {
-          MarkedPixels[r][c] = false;
-        }
-      }
-    }
+  // the keepout region is only marked during a call, so removing it from the mask is enough
+  if (this->keepoutRegionId_ != KProtectionMask::CInvalidRegionId) {
+    this->protectionMask_.RemoveRegion(this->keepoutRegionId_);
+    this->keepoutRegionId_ = KProtectionMask::CInvalidRegionId;
   }
   this->keepoutRegionExists_ = false;
 
@@ -0,0 +1,252 @@
+#include "SeamCarverKernels.h"
+#include "EnergyTraits.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+    template<typename EnergyType>
+    void CalculateCumulativeEnergyRow(const EnergyType* PrevTotalEnergyTo,
+                                      const EnergyType* PixelEnergy,
+                                      int32_t StartColumn, int32_t EndColumn, EnergyType PosInf,
+                                      EnergyType* OutTotalEnergyTo, int8_t* OutColumnOffsetTo)
+    {
+        for (int32_t Column = StartColumn; Column < EndColumn; Column++)
+        {
+            // the padding columns hold +INF, so the edge pixels need no bounds checks
+            const EnergyType Up = PrevTotalEnergyTo[Column];
+            const EnergyType UpRight = PrevTotalEnergyTo[Column + 1];
+            const EnergyType UpLeft = PrevTotalEnergyTo[Column - 1];
+
+            // strict comparisons resolve ties in the order above, right/above, left/above
+            EnergyType MinEnergy = Up;
+            int8_t MinEnergyOffset = 0;
+            MinEnergyOffset = UpRight < MinEnergy ? 1 : MinEnergyOffset;
+            MinEnergy = UpRight < MinEnergy ? UpRight : MinEnergy;
+            MinEnergyOffset = UpLeft < MinEnergy ? -1 : MinEnergyOffset;
+            MinEnergy = UpLeft < MinEnergy ? UpLeft : MinEnergy;
+
+            // current pixel is unreachable from parent pixels since they are all marked
+            //   OR current pixel already marked
+            const bool bUnreachable = MinEnergy >= PosInf || PixelEnergy[Column] >= PosInf;
+            OutTotalEnergyTo[Column] = bUnreachable ?
+                PosInf : ct::KEnergyTraits<EnergyType>::Add(MinEnergy, PixelEnergy[Column]);
+            OutColumnOffsetTo[Column] = bUnreachable ?
+                ct::SeamCarverKernels::CNoParentOffset : MinEnergyOffset;
+        }
+    }
+
+    template<typename EnergyType>
+    void CalculateForwardCumulativeEnergyRow(const EnergyType* PrevTotalEnergyTo,
+                                             const EnergyType* PixelEnergy,
+                                             const EnergyType* UpCost,
+                                             const EnergyType* UpLeftCost,
+                                             const EnergyType* UpRightCost,
+                                             int32_t StartColumn, int32_t EndColumn, EnergyType PosInf,
+                                             EnergyType* OutTotalEnergyTo, int8_t* OutColumnOffsetTo)
+    {
+        // a parent at +INF stays at +INF, all other sums saturate below it
+        auto AddCost = [PosInf](EnergyType TotalEnergy, EnergyType Cost)
+        {
+            return TotalEnergy >= PosInf ? PosInf : ct::KEnergyTraits<EnergyType>::Add(TotalEnergy, Cost);
+        };
+
+        for (int32_t Column = StartColumn; Column < EndColumn; Column++)
+        {
+            const EnergyType Up = AddCost(PrevTotalEnergyTo[Column], UpCost[Column]);
+            const EnergyType UpRight = AddCost(PrevTotalEnergyTo[Column + 1], UpRightCost[Column]);
+            const EnergyType UpLeft = AddCost(PrevTotalEnergyTo[Column - 1], UpLeftCost[Column]);
+
+            EnergyType MinEnergy = Up;
+            int8_t MinEnergyOffset = 0;
+            MinEnergyOffset = UpRight < MinEnergy ? 1 : MinEnergyOffset;
+            MinEnergy = UpRight < MinEnergy ? UpRight : MinEnergy;
+            MinEnergyOffset = UpLeft < MinEnergy ? -1 : MinEnergyOffset;
+            MinEnergy = UpLeft < MinEnergy ? UpLeft : MinEnergy;
+
+            const bool bUnreachable = MinEnergy >= PosInf || PixelEnergy[Column] >= PosInf;
+            OutTotalEnergyTo[Column] = bUnreachable ? PosInf : MinEnergy;
+            OutColumnOffsetTo[Column] = bUnreachable ?
+                ct::SeamCarverKernels::CNoParentOffset : MinEnergyOffset;
+        }
+    }
+
+    /**
+     * @brief sum of the absolute differences of the channels of two pixels
+     */
+    template<int32_t NumChannels>
+    inline int32_t AbsoluteDifference(const uint8_t* Pixel1, const uint8_t* Pixel2, int32_t RuntimeNumChannels)
+    {
+        // NumChannels is 0 for channel counts without an instantiation of their own
+        const int32_t Channels = NumChannels > 0 ? NumChannels : RuntimeNumChannels;
+        int32_t Difference = 0;
+        for (int32_t Channel = 0; Channel < Channels; Channel++)
+        {
+            Difference += std::abs(Pixel1[Channel] - Pixel2[Channel]);
+        }
+        return Difference;
+    }
+
+    template<int32_t NumChannels, typename EnergyType>
+    void CalculateForwardCostsForChannels(const uint8_t* Above, const uint8_t* Current, int32_t NumColumns,
+                                          int32_t RuntimeNumChannels, int32_t StartColumn, int32_t EndColumn,
+                                          EnergyType* OutUpCost, EnergyType* OutUpLeftCost,
+                                          EnergyType* OutUpRightCost)
+    {
+        const int32_t Channels = NumChannels > 0 ? NumChannels : RuntimeNumChannels;
+        for (int32_t Column = StartColumn; Column < EndColumn; Column++)
+        {
+            // pixels beyond the edges repeat the edge pixel
+            const uint8_t* Left = Current + std::max(Column - 1, 0) * Channels;
+            const uint8_t* Right = Current + std::min(Column + 1, NumColumns - 1) * Channels;
+            const uint8_t* Up = Above + Column * Channels;
+
+            const int32_t Cost = AbsoluteDifference<NumChannels>(Right, Left, Channels);
+            OutUpCost[Column] = static_cast<EnergyType>(Cost);
+            OutUpLeftCost[Column] = static_cast<EnergyType>(Cost + AbsoluteDifference<NumChannels>(Up, Left, Channels));
+            OutUpRightCost[Column] = static_cast<EnergyType>(Cost + AbsoluteDifference<NumChannels>(Up, Right, Channels));
+        }
+    }
+
+    template<typename EnergyType>
+    void CalculateForwardCosts(const uint8_t* Above, const uint8_t* Current, int32_t NumColumns,
+                               int32_t NumChannels, int32_t StartColumn, int32_t EndColumn,
+                               EnergyType* OutUpCost, EnergyType* OutUpLeftCost, EnergyType* OutUpRightCost)
+    {
+        // grayscale and BGR get loops unrolled for their number of channels
+        switch (NumChannels)
+        {
+        case 1:
+            CalculateForwardCostsForChannels<1>(Above, Current, NumColumns, NumChannels, StartColumn,
+                                                EndColumn, OutUpCost, OutUpLeftCost, OutUpRightCost);
+            break;
+        case 3:
+            CalculateForwardCostsForChannels<3>(Above, Current, NumColumns, NumChannels, StartColumn,
+                                                EndColumn, OutUpCost, OutUpLeftCost, OutUpRightCost);
+            break;
+        default:
+            CalculateForwardCostsForChannels<0>(Above, Current, NumColumns, NumChannels, StartColumn,
+                                                EndColumn, OutUpCost, OutUpLeftCost, OutUpRightCost);
+            break;
+        }
+    }
+}
+
+void ct::SeamCarverKernels::CalculateCumulativeEnergyRowScalar(const double* PrevTotalEnergyTo,
+                                                               const double* PixelEnergy,
+                                                               int32_t StartColumn,
+                                                               int32_t EndColumn,
+                                                               double PosInf,
+                                                               double* OutTotalEnergyTo,
+                                                               int8_t* OutColumnOffsetTo)
+{
+    CalculateCumulativeEnergyRow(PrevTotalEnergyTo, PixelEnergy, StartColumn, EndColumn, PosInf,
+                                 OutTotalEnergyTo, OutColumnOffsetTo);
+}
+
+void ct::SeamCarverKernels::CalculateCumulativeEnergyRowScalar(const int32_t* PrevTotalEnergyTo,
+                                                               const int32_t* PixelEnergy,
+                                                               int32_t StartColumn,
+                                                               int32_t EndColumn,
+                                                               int32_t PosInf,
+                                                               int32_t* OutTotalEnergyTo,
+                                                               int8_t* OutColumnOffsetTo)
+{
+    CalculateCumulativeEnergyRow(PrevTotalEnergyTo, PixelEnergy, StartColumn, EndColumn, PosInf,
+                                 OutTotalEnergyTo, OutColumnOffsetTo);
+}
+
+void ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowScalar(const double* PrevTotalEnergyTo,
+                                                                      const double* PixelEnergy,
+                                                                      const double* UpCost,
+                                                                      const double* UpLeftCost,
+                                                                      const double* UpRightCost,
+                                                                      int32_t StartColumn,
+                                                                      int32_t EndColumn,
+                                                                      double PosInf,
+                                                                      double* OutTotalEnergyTo,
+                                                                      int8_t* OutColumnOffsetTo)
+{
+    CalculateForwardCumulativeEnergyRow(PrevTotalEnergyTo, PixelEnergy, UpCost, UpLeftCost, UpRightCost,
+                                        StartColumn, EndColumn, PosInf, OutTotalEnergyTo, OutColumnOffsetTo);
+}
+
+void ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowScalar(const int32_t* PrevTotalEnergyTo,
+                                                                      const int32_t* PixelEnergy,
+                                                                      const int32_t* UpCost,
+                                                                      const int32_t* UpLeftCost,
+                                                                      const int32_t* UpRightCost,
+                                                                      int32_t StartColumn,
+                                                                      int32_t EndColumn,
+                                                                      int32_t PosInf,
+                                                                      int32_t* OutTotalEnergyTo,
+                                                                      int8_t* OutColumnOffsetTo)
+{
+    CalculateForwardCumulativeEnergyRow(PrevTotalEnergyTo, PixelEnergy, UpCost, UpLeftCost, UpRightCost,
+                                        StartColumn, EndColumn, PosInf, OutTotalEnergyTo, OutColumnOffsetTo);
+}
+
+void ct::SeamCarverKernels::CalculateForwardCostRow(const uint8_t* Above, const uint8_t* Current,
+                                                    int32_t NumColumns, int32_t NumChannels,
+                                                    int32_t StartColumn, int32_t EndColumn,
+                                                    double* OutUpCost, double* OutUpLeftCost,
+                                                    double* OutUpRightCost)
+{
+    CalculateForwardCosts(Above, Current, NumColumns, NumChannels, StartColumn, EndColumn,
+                          OutUpCost, OutUpLeftCost, OutUpRightCost);
+}
+
+void ct::SeamCarverKernels::CalculateForwardCostRow(const uint8_t* Above, const uint8_t* Current,
+                                                    int32_t NumColumns, int32_t NumChannels,
+                                                    int32_t StartColumn, int32_t EndColumn,
+                                                    int32_t* OutUpCost, int32_t* OutUpLeftCost,
+                                                    int32_t* OutUpRightCost)
+{
+    CalculateForwardCosts(Above, Current, NumColumns, NumChannels, StartColumn, EndColumn,
+                          OutUpCost, OutUpLeftCost, OutUpRightCost);
+}
+
+template<typename EnergyType>
+ct::SeamCarverKernels::KCumulativeEnergyRowKernelT<EnergyType>
+ct::SeamCarverKernels::SelectCumulativeEnergyRowKernel()
+{
+    // the overload matching EnergyType is picked by the return type
+#ifdef CT_X86_SIMD
+    if (KCpuFeatures::HasAVX2())
+    {
+        return CalculateCumulativeEnergyRowAVX2;
+    }
+    if (KCpuFeatures::HasSSE41())
+    {
+        return CalculateCumulativeEnergyRowSSE41;
+    }
+#endif
+    return CalculateCumulativeEnergyRowScalar;
+}
+
+template ct::SeamCarverKernels::KCumulativeEnergyRowKernelT<double>
+ct::SeamCarverKernels::SelectCumulativeEnergyRowKernel<double>();
+template ct::SeamCarverKernels::KCumulativeEnergyRowKernelT<int32_t>
+ct::SeamCarverKernels::SelectCumulativeEnergyRowKernel<int32_t>();
+
+template<typename EnergyType>
+ct::SeamCarverKernels::KForwardCumulativeEnergyRowKernelT<EnergyType>
+ct::SeamCarverKernels::SelectForwardCumulativeEnergyRowKernel()
+{
+#ifdef CT_X86_SIMD
+    if (KCpuFeatures::HasAVX2())
+    {
+        return CalculateForwardCumulativeEnergyRowAVX2;
+    }
+    if (KCpuFeatures::HasSSE41())
+    {
+        return CalculateForwardCumulativeEnergyRowSSE41;
+    }
+#endif
+    return CalculateForwardCumulativeEnergyRowScalar;
+}
+
+template ct::SeamCarverKernels::KForwardCumulativeEnergyRowKernelT<double>
+ct::SeamCarverKernels::SelectForwardCumulativeEnergyRowKernel<double>();
+template ct::SeamCarverKernels::KForwardCumulativeEnergyRowKernelT<int32_t>
+ct::SeamCarverKernels::SelectForwardCumulativeEnergyRowKernel<int32_t>();
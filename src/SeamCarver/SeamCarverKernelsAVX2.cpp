@@ -0,0 +1,251 @@
+#include "SeamCarverKernels.h"
+
+#ifdef CT_X86_SIMD
+#include <immintrin.h>
+#include <cstring>
+
+namespace
+{
+    /**
+     * @brief narrows the 4 int32 offsets of Offsets to bytes and stores them
+     */
+    inline void StoreColumnOffsets(__m128i Offsets, int8_t* OutColumnOffsetTo)
+    {
+        const __m128i Bytes = _mm_packs_epi16(_mm_packs_epi32(Offsets, Offsets), Offsets);
+        const int32_t Packed = _mm_cvtsi128_si32(Bytes);
+        std::memcpy(OutColumnOffsetTo, &Packed, sizeof(Packed));
+    }
+
+    /**
+     * @brief narrows the 8 int32 offsets of Offsets to bytes and stores them
+     */
+    inline void StoreColumnOffsets(__m256i Offsets, int8_t* OutColumnOffsetTo)
+    {
+        // packing works within each 128 bit lane, so every lane holds 4 of the bytes
+        const __m256i Words = _mm256_packs_epi32(Offsets, Offsets);
+        const __m256i Bytes = _mm256_packs_epi16(Words, Words);
+        const __m128i Joined = _mm_unpacklo_epi32(_mm256_castsi256_si128(Bytes),
+                                                  _mm256_extracti128_si256(Bytes, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(OutColumnOffsetTo), Joined);
+    }
+}
+
+void ct::SeamCarverKernels::CalculateCumulativeEnergyRowAVX2(const double* PrevTotalEnergyTo,
+                                                              const double* PixelEnergy,
+                                                              int32_t StartColumn,
+                                                              int32_t EndColumn,
+                                                              double PosInf,
+                                                              double* OutTotalEnergyTo,
+                                                              int8_t* OutColumnOffsetTo)
+{
+    const int32_t CPixelsPerIteration = 4;
+
+    const __m256d Inf = _mm256_set1_pd(PosInf);
+    const __m256d OffsetRight = _mm256_set1_pd(1.0);
+    const __m256d OffsetLeft = _mm256_set1_pd(-1.0);
+    const __m256d NoParent = _mm256_set1_pd(ct::SeamCarverKernels::CNoParentOffset);
+
+    // the padding columns hold +INF, so the first and last column need no special case
+    int32_t Column = StartColumn;
+    for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+    {
+        const __m256d Up = _mm256_loadu_pd(PrevTotalEnergyTo + Column);
+        const __m256d UpRight = _mm256_loadu_pd(PrevTotalEnergyTo + Column + 1);
+        const __m256d UpLeft = _mm256_loadu_pd(PrevTotalEnergyTo + Column - 1);
+        const __m256d Energy = _mm256_loadu_pd(PixelEnergy + Column);
+
+        // strict comparisons in the order up, up/right, up/left resolve ties like the scalar code
+        __m256d MinEnergy = Up;
+        __m256d Offset = _mm256_setzero_pd();
+        __m256d IsLess = _mm256_cmp_pd(UpRight, MinEnergy, _CMP_LT_OQ);
+        MinEnergy = _mm256_blendv_pd(MinEnergy, UpRight, IsLess);
+        Offset = _mm256_blendv_pd(Offset, OffsetRight, IsLess);
+        IsLess = _mm256_cmp_pd(UpLeft, MinEnergy, _CMP_LT_OQ);
+        MinEnergy = _mm256_blendv_pd(MinEnergy, UpLeft, IsLess);
+        Offset = _mm256_blendv_pd(Offset, OffsetLeft, IsLess);
+
+        // pixel is unreachable if no parent was below +INF or if it is marked itself
+        const __m256d Invalid = _mm256_or_pd(_mm256_cmp_pd(MinEnergy, Inf, _CMP_GE_OQ),
+                                             _mm256_cmp_pd(Energy, Inf, _CMP_GE_OQ));
+
+        const __m256d Total = _mm256_add_pd(MinEnergy, Energy);
+        _mm256_storeu_pd(OutTotalEnergyTo + Column, _mm256_blendv_pd(Total, Inf, Invalid));
+
+        // offsets are small integers, so converting them through double is exact
+        StoreColumnOffsets(_mm256_cvtpd_epi32(_mm256_blendv_pd(Offset, NoParent, Invalid)),
+                           OutColumnOffsetTo + Column);
+    }
+
+    CalculateCumulativeEnergyRowScalar(PrevTotalEnergyTo, PixelEnergy, Column, EndColumn, PosInf,
+                                       OutTotalEnergyTo, OutColumnOffsetTo);
+}
+
+void ct::SeamCarverKernels::CalculateCumulativeEnergyRowAVX2(const int32_t* PrevTotalEnergyTo,
+                                                              const int32_t* PixelEnergy,
+                                                              int32_t StartColumn,
+                                                              int32_t EndColumn,
+                                                              int32_t PosInf,
+                                                              int32_t* OutTotalEnergyTo,
+                                                              int8_t* OutColumnOffsetTo)
+{
+    const int32_t CPixelsPerIteration = 8;
+
+    const __m256i Inf = _mm256_set1_epi32(PosInf);
+    // energies are non-negative, so the sum of two of them fits in 32 unsigned bits and an
+    //      unsigned min saturates it exactly like KEnergyTraits<int32_t>::Add
+    const __m256i MaxEnergy = _mm256_set1_epi32(PosInf - 1);
+    const __m256i OffsetRight = _mm256_set1_epi32(1);
+    const __m256i OffsetLeft = _mm256_set1_epi32(-1);
+    const __m256i NoParent = _mm256_set1_epi32(ct::SeamCarverKernels::CNoParentOffset);
+
+    int32_t Column = StartColumn;
+    for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+    {
+        const __m256i Up =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(PrevTotalEnergyTo + Column));
+        const __m256i UpRight =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(PrevTotalEnergyTo + Column + 1));
+        const __m256i UpLeft =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(PrevTotalEnergyTo + Column - 1));
+        const __m256i Energy =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(PixelEnergy + Column));
+
+        // Min > Candidate is the strict Candidate < Min of the scalar code
+        __m256i MinEnergy = Up;
+        __m256i Offset = _mm256_setzero_si256();
+        __m256i IsLess = _mm256_cmpgt_epi32(MinEnergy, UpRight);
+        MinEnergy = _mm256_blendv_epi8(MinEnergy, UpRight, IsLess);
+        Offset = _mm256_blendv_epi8(Offset, OffsetRight, IsLess);
+        IsLess = _mm256_cmpgt_epi32(MinEnergy, UpLeft);
+        MinEnergy = _mm256_blendv_epi8(MinEnergy, UpLeft, IsLess);
+        Offset = _mm256_blendv_epi8(Offset, OffsetLeft, IsLess);
+
+        const __m256i Invalid = _mm256_or_si256(_mm256_cmpeq_epi32(MinEnergy, Inf),
+                                                _mm256_cmpeq_epi32(Energy, Inf));
+
+        const __m256i Total = _mm256_min_epu32(_mm256_add_epi32(MinEnergy, Energy), MaxEnergy);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(OutTotalEnergyTo + Column),
+                            _mm256_blendv_epi8(Total, Inf, Invalid));
+
+        StoreColumnOffsets(_mm256_blendv_epi8(Offset, NoParent, Invalid), OutColumnOffsetTo + Column);
+    }
+
+    CalculateCumulativeEnergyRowScalar(PrevTotalEnergyTo, PixelEnergy, Column, EndColumn, PosInf,
+                                       OutTotalEnergyTo, OutColumnOffsetTo);
+}
+
+void ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowAVX2(const double* PrevTotalEnergyTo,
+                                                                    const double* PixelEnergy,
+                                                                    const double* UpCost,
+                                                                    const double* UpLeftCost,
+                                                                    const double* UpRightCost,
+                                                                    int32_t StartColumn,
+                                                                    int32_t EndColumn,
+                                                                    double PosInf,
+                                                                    double* OutTotalEnergyTo,
+                                                                    int8_t* OutColumnOffsetTo)
+{
+    const int32_t CPixelsPerIteration = 4;
+
+    const __m256d Inf = _mm256_set1_pd(PosInf);
+    const __m256d OffsetRight = _mm256_set1_pd(1.0);
+    const __m256d OffsetLeft = _mm256_set1_pd(-1.0);
+    const __m256d NoParent = _mm256_set1_pd(ct::SeamCarverKernels::CNoParentOffset);
+
+    // parents at +INF stay at +INF when their transition cost is added
+    auto AddCost = [&Inf](__m256d TotalEnergy, __m256d Cost)
+    {
+        return _mm256_blendv_pd(_mm256_add_pd(TotalEnergy, Cost), Inf,
+                                _mm256_cmp_pd(TotalEnergy, Inf, _CMP_GE_OQ));
+    };
+
+    int32_t Column = StartColumn;
+    for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+    {
+        const __m256d Up = AddCost(_mm256_loadu_pd(PrevTotalEnergyTo + Column), _mm256_loadu_pd(UpCost + Column));
+        const __m256d UpRight = AddCost(_mm256_loadu_pd(PrevTotalEnergyTo + Column + 1),
+                                        _mm256_loadu_pd(UpRightCost + Column));
+        const __m256d UpLeft = AddCost(_mm256_loadu_pd(PrevTotalEnergyTo + Column - 1),
+                                       _mm256_loadu_pd(UpLeftCost + Column));
+        const __m256d Energy = _mm256_loadu_pd(PixelEnergy + Column);
+
+        __m256d MinEnergy = Up;
+        __m256d Offset = _mm256_setzero_pd();
+        __m256d IsLess = _mm256_cmp_pd(UpRight, MinEnergy, _CMP_LT_OQ);
+        MinEnergy = _mm256_blendv_pd(MinEnergy, UpRight, IsLess);
+        Offset = _mm256_blendv_pd(Offset, OffsetRight, IsLess);
+        IsLess = _mm256_cmp_pd(UpLeft, MinEnergy, _CMP_LT_OQ);
+        MinEnergy = _mm256_blendv_pd(MinEnergy, UpLeft, IsLess);
+        Offset = _mm256_blendv_pd(Offset, OffsetLeft, IsLess);
+
+        // the energy of the pixel only tells whether it is marked
+        const __m256d Invalid = _mm256_or_pd(_mm256_cmp_pd(MinEnergy, Inf, _CMP_GE_OQ),
+                                             _mm256_cmp_pd(Energy, Inf, _CMP_GE_OQ));
+        _mm256_storeu_pd(OutTotalEnergyTo + Column, _mm256_blendv_pd(MinEnergy, Inf, Invalid));
+        StoreColumnOffsets(_mm256_cvtpd_epi32(_mm256_blendv_pd(Offset, NoParent, Invalid)),
+                           OutColumnOffsetTo + Column);
+    }
+
+    CalculateForwardCumulativeEnergyRowScalar(PrevTotalEnergyTo, PixelEnergy, UpCost, UpLeftCost, UpRightCost,
+                                              Column, EndColumn, PosInf, OutTotalEnergyTo, OutColumnOffsetTo);
+}
+
+void ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowAVX2(const int32_t* PrevTotalEnergyTo,
+                                                                    const int32_t* PixelEnergy,
+                                                                    const int32_t* UpCost,
+                                                                    const int32_t* UpLeftCost,
+                                                                    const int32_t* UpRightCost,
+                                                                    int32_t StartColumn,
+                                                                    int32_t EndColumn,
+                                                                    int32_t PosInf,
+                                                                    int32_t* OutTotalEnergyTo,
+                                                                    int8_t* OutColumnOffsetTo)
+{
+    const int32_t CPixelsPerIteration = 8;
+
+    const __m256i Inf = _mm256_set1_epi32(PosInf);
+    const __m256i MaxEnergy = _mm256_set1_epi32(PosInf - 1);
+    const __m256i OffsetRight = _mm256_set1_epi32(1);
+    const __m256i OffsetLeft = _mm256_set1_epi32(-1);
+    const __m256i NoParent = _mm256_set1_epi32(ct::SeamCarverKernels::CNoParentOffset);
+
+    // sums saturate below +INF with an unsigned min like CalculateCumulativeEnergyRowAVX2, parents
+    //      at +INF stay at +INF
+    auto AddCost = [&Inf, &MaxEnergy](__m256i TotalEnergy, __m256i Cost)
+    {
+        const __m256i Sum = _mm256_min_epu32(_mm256_add_epi32(TotalEnergy, Cost), MaxEnergy);
+        return _mm256_blendv_epi8(Sum, Inf, _mm256_cmpeq_epi32(TotalEnergy, Inf));
+    };
+    auto Load = [](const int32_t* Energies)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Energies));
+    };
+
+    int32_t Column = StartColumn;
+    for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+    {
+        const __m256i Up = AddCost(Load(PrevTotalEnergyTo + Column), Load(UpCost + Column));
+        const __m256i UpRight = AddCost(Load(PrevTotalEnergyTo + Column + 1), Load(UpRightCost + Column));
+        const __m256i UpLeft = AddCost(Load(PrevTotalEnergyTo + Column - 1), Load(UpLeftCost + Column));
+        const __m256i Energy = Load(PixelEnergy + Column);
+
+        __m256i MinEnergy = Up;
+        __m256i Offset = _mm256_setzero_si256();
+        __m256i IsLess = _mm256_cmpgt_epi32(MinEnergy, UpRight);
+        MinEnergy = _mm256_blendv_epi8(MinEnergy, UpRight, IsLess);
+        Offset = _mm256_blendv_epi8(Offset, OffsetRight, IsLess);
+        IsLess = _mm256_cmpgt_epi32(MinEnergy, UpLeft);
+        MinEnergy = _mm256_blendv_epi8(MinEnergy, UpLeft, IsLess);
+        Offset = _mm256_blendv_epi8(Offset, OffsetLeft, IsLess);
+
+        const __m256i Invalid = _mm256_or_si256(_mm256_cmpeq_epi32(MinEnergy, Inf),
+                                                _mm256_cmpeq_epi32(Energy, Inf));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(OutTotalEnergyTo + Column),
+                            _mm256_blendv_epi8(MinEnergy, Inf, Invalid));
+        StoreColumnOffsets(_mm256_blendv_epi8(Offset, NoParent, Invalid), OutColumnOffsetTo + Column);
+    }
+
+    CalculateForwardCumulativeEnergyRowScalar(PrevTotalEnergyTo, PixelEnergy, UpCost, UpLeftCost, UpRightCost,
+                                              Column, EndColumn, PosInf, OutTotalEnergyTo, OutColumnOffsetTo);
+}
+#endif
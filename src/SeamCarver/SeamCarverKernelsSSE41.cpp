@@ -0,0 +1,233 @@
+#include "SeamCarverKernels.h"
+
+#ifdef CT_X86_SIMD
+#include <smmintrin.h>
+#include <cstring>
+
+namespace
+{
+    /**
+     * @brief narrows the 4 int32 offsets of Offsets to bytes and stores the lowest NumPixels of them
+     */
+    inline void StoreColumnOffsets(__m128i Offsets, int32_t NumPixels, int8_t* OutColumnOffsetTo)
+    {
+        const __m128i Bytes = _mm_packs_epi16(_mm_packs_epi32(Offsets, Offsets), Offsets);
+        const int32_t Packed = _mm_cvtsi128_si32(Bytes);
+        std::memcpy(OutColumnOffsetTo, &Packed, NumPixels);
+    }
+}
+
+void ct::SeamCarverKernels::CalculateCumulativeEnergyRowSSE41(const double* PrevTotalEnergyTo,
+                                                              const double* PixelEnergy,
+                                                              int32_t StartColumn,
+                                                              int32_t EndColumn,
+                                                              double PosInf,
+                                                              double* OutTotalEnergyTo,
+                                                              int8_t* OutColumnOffsetTo)
+{
+    const int32_t CPixelsPerIteration = 2;
+
+    const __m128d Inf = _mm_set1_pd(PosInf);
+    const __m128d OffsetRight = _mm_set1_pd(1.0);
+    const __m128d OffsetLeft = _mm_set1_pd(-1.0);
+    const __m128d NoParent = _mm_set1_pd(ct::SeamCarverKernels::CNoParentOffset);
+
+    // the padding columns hold +INF, so the first and last column need no special case
+    int32_t Column = StartColumn;
+    for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+    {
+        const __m128d Up = _mm_loadu_pd(PrevTotalEnergyTo + Column);
+        const __m128d UpRight = _mm_loadu_pd(PrevTotalEnergyTo + Column + 1);
+        const __m128d UpLeft = _mm_loadu_pd(PrevTotalEnergyTo + Column - 1);
+        const __m128d Energy = _mm_loadu_pd(PixelEnergy + Column);
+
+        // strict comparisons in the order up, up/right, up/left resolve ties like the scalar code
+        __m128d MinEnergy = Up;
+        __m128d Offset = _mm_setzero_pd();
+        __m128d IsLess = _mm_cmplt_pd(UpRight, MinEnergy);
+        MinEnergy = _mm_blendv_pd(MinEnergy, UpRight, IsLess);
+        Offset = _mm_blendv_pd(Offset, OffsetRight, IsLess);
+        IsLess = _mm_cmplt_pd(UpLeft, MinEnergy);
+        MinEnergy = _mm_blendv_pd(MinEnergy, UpLeft, IsLess);
+        Offset = _mm_blendv_pd(Offset, OffsetLeft, IsLess);
+
+        // pixel is unreachable if no parent was below +INF or if it is marked itself
+        const __m128d Invalid = _mm_or_pd(_mm_cmpge_pd(MinEnergy, Inf), _mm_cmpge_pd(Energy, Inf));
+
+        const __m128d Total = _mm_add_pd(MinEnergy, Energy);
+        _mm_storeu_pd(OutTotalEnergyTo + Column, _mm_blendv_pd(Total, Inf, Invalid));
+
+        // offsets are small integers, so converting them through double is exact
+        StoreColumnOffsets(_mm_cvtpd_epi32(_mm_blendv_pd(Offset, NoParent, Invalid)),
+                           CPixelsPerIteration, OutColumnOffsetTo + Column);
+    }
+
+    CalculateCumulativeEnergyRowScalar(PrevTotalEnergyTo, PixelEnergy, Column, EndColumn, PosInf,
+                                       OutTotalEnergyTo, OutColumnOffsetTo);
+}
+
+void ct::SeamCarverKernels::CalculateCumulativeEnergyRowSSE41(const int32_t* PrevTotalEnergyTo,
+                                                              const int32_t* PixelEnergy,
+                                                              int32_t StartColumn,
+                                                              int32_t EndColumn,
+                                                              int32_t PosInf,
+                                                              int32_t* OutTotalEnergyTo,
+                                                              int8_t* OutColumnOffsetTo)
+{
+    const int32_t CPixelsPerIteration = 4;
+
+    const __m128i Inf = _mm_set1_epi32(PosInf);
+    // energies are non-negative, so the sum of two of them fits in 32 unsigned bits and an
+    //      unsigned min saturates it exactly like KEnergyTraits<int32_t>::Add
+    const __m128i MaxEnergy = _mm_set1_epi32(PosInf - 1);
+    const __m128i OffsetRight = _mm_set1_epi32(1);
+    const __m128i OffsetLeft = _mm_set1_epi32(-1);
+    const __m128i NoParent = _mm_set1_epi32(ct::SeamCarverKernels::CNoParentOffset);
+
+    int32_t Column = StartColumn;
+    for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+    {
+        const __m128i Up = _mm_loadu_si128(reinterpret_cast<const __m128i*>(PrevTotalEnergyTo + Column));
+        const __m128i UpRight =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(PrevTotalEnergyTo + Column + 1));
+        const __m128i UpLeft =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(PrevTotalEnergyTo + Column - 1));
+        const __m128i Energy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(PixelEnergy + Column));
+
+        // Min > Candidate is the strict Candidate < Min of the scalar code
+        __m128i MinEnergy = Up;
+        __m128i Offset = _mm_setzero_si128();
+        __m128i IsLess = _mm_cmpgt_epi32(MinEnergy, UpRight);
+        MinEnergy = _mm_blendv_epi8(MinEnergy, UpRight, IsLess);
+        Offset = _mm_blendv_epi8(Offset, OffsetRight, IsLess);
+        IsLess = _mm_cmpgt_epi32(MinEnergy, UpLeft);
+        MinEnergy = _mm_blendv_epi8(MinEnergy, UpLeft, IsLess);
+        Offset = _mm_blendv_epi8(Offset, OffsetLeft, IsLess);
+
+        const __m128i Invalid = _mm_or_si128(_mm_cmpeq_epi32(MinEnergy, Inf), _mm_cmpeq_epi32(Energy, Inf));
+
+        const __m128i Total = _mm_min_epu32(_mm_add_epi32(MinEnergy, Energy), MaxEnergy);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(OutTotalEnergyTo + Column),
+                         _mm_blendv_epi8(Total, Inf, Invalid));
+
+        StoreColumnOffsets(_mm_blendv_epi8(Offset, NoParent, Invalid), CPixelsPerIteration,
+                           OutColumnOffsetTo + Column);
+    }
+
+    CalculateCumulativeEnergyRowScalar(PrevTotalEnergyTo, PixelEnergy, Column, EndColumn, PosInf,
+                                       OutTotalEnergyTo, OutColumnOffsetTo);
+}
+
+void ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowSSE41(const double* PrevTotalEnergyTo,
+                                                                     const double* PixelEnergy,
+                                                                     const double* UpCost,
+                                                                     const double* UpLeftCost,
+                                                                     const double* UpRightCost,
+                                                                     int32_t StartColumn,
+                                                                     int32_t EndColumn,
+                                                                     double PosInf,
+                                                                     double* OutTotalEnergyTo,
+                                                                     int8_t* OutColumnOffsetTo)
+{
+    const int32_t CPixelsPerIteration = 2;
+
+    const __m128d Inf = _mm_set1_pd(PosInf);
+    const __m128d OffsetRight = _mm_set1_pd(1.0);
+    const __m128d OffsetLeft = _mm_set1_pd(-1.0);
+    const __m128d NoParent = _mm_set1_pd(ct::SeamCarverKernels::CNoParentOffset);
+
+    // parents at +INF stay at +INF when their transition cost is added
+    auto AddCost = [&Inf](__m128d TotalEnergy, __m128d Cost)
+    {
+        return _mm_blendv_pd(_mm_add_pd(TotalEnergy, Cost), Inf, _mm_cmpge_pd(TotalEnergy, Inf));
+    };
+
+    int32_t Column = StartColumn;
+    for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+    {
+        const __m128d Up = AddCost(_mm_loadu_pd(PrevTotalEnergyTo + Column), _mm_loadu_pd(UpCost + Column));
+        const __m128d UpRight = AddCost(_mm_loadu_pd(PrevTotalEnergyTo + Column + 1),
+                                        _mm_loadu_pd(UpRightCost + Column));
+        const __m128d UpLeft = AddCost(_mm_loadu_pd(PrevTotalEnergyTo + Column - 1),
+                                       _mm_loadu_pd(UpLeftCost + Column));
+        const __m128d Energy = _mm_loadu_pd(PixelEnergy + Column);
+
+        __m128d MinEnergy = Up;
+        __m128d Offset = _mm_setzero_pd();
+        __m128d IsLess = _mm_cmplt_pd(UpRight, MinEnergy);
+        MinEnergy = _mm_blendv_pd(MinEnergy, UpRight, IsLess);
+        Offset = _mm_blendv_pd(Offset, OffsetRight, IsLess);
+        IsLess = _mm_cmplt_pd(UpLeft, MinEnergy);
+        MinEnergy = _mm_blendv_pd(MinEnergy, UpLeft, IsLess);
+        Offset = _mm_blendv_pd(Offset, OffsetLeft, IsLess);
+
+        // the energy of the pixel only tells whether it is marked
+        const __m128d Invalid = _mm_or_pd(_mm_cmpge_pd(MinEnergy, Inf), _mm_cmpge_pd(Energy, Inf));
+        _mm_storeu_pd(OutTotalEnergyTo + Column, _mm_blendv_pd(MinEnergy, Inf, Invalid));
+        StoreColumnOffsets(_mm_cvtpd_epi32(_mm_blendv_pd(Offset, NoParent, Invalid)),
+                           CPixelsPerIteration, OutColumnOffsetTo + Column);
+    }
+
+    CalculateForwardCumulativeEnergyRowScalar(PrevTotalEnergyTo, PixelEnergy, UpCost, UpLeftCost, UpRightCost,
+                                              Column, EndColumn, PosInf, OutTotalEnergyTo, OutColumnOffsetTo);
+}
+
+void ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowSSE41(const int32_t* PrevTotalEnergyTo,
+                                                                     const int32_t* PixelEnergy,
+                                                                     const int32_t* UpCost,
+                                                                     const int32_t* UpLeftCost,
+                                                                     const int32_t* UpRightCost,
+                                                                     int32_t StartColumn,
+                                                                     int32_t EndColumn,
+                                                                     int32_t PosInf,
+                                                                     int32_t* OutTotalEnergyTo,
+                                                                     int8_t* OutColumnOffsetTo)
+{
+    const int32_t CPixelsPerIteration = 4;
+
+    const __m128i Inf = _mm_set1_epi32(PosInf);
+    const __m128i MaxEnergy = _mm_set1_epi32(PosInf - 1);
+    const __m128i OffsetRight = _mm_set1_epi32(1);
+    const __m128i OffsetLeft = _mm_set1_epi32(-1);
+    const __m128i NoParent = _mm_set1_epi32(ct::SeamCarverKernels::CNoParentOffset);
+
+    // sums saturate below +INF with an unsigned min like CalculateCumulativeEnergyRowSSE41, parents
+    //      at +INF stay at +INF
+    auto AddCost = [&Inf, &MaxEnergy](__m128i TotalEnergy, __m128i Cost)
+    {
+        const __m128i Sum = _mm_min_epu32(_mm_add_epi32(TotalEnergy, Cost), MaxEnergy);
+        return _mm_blendv_epi8(Sum, Inf, _mm_cmpeq_epi32(TotalEnergy, Inf));
+    };
+    auto Load = [](const int32_t* Energies)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(Energies));
+    };
+
+    int32_t Column = StartColumn;
+    for (; Column + CPixelsPerIteration <= EndColumn; Column += CPixelsPerIteration)
+    {
+        const __m128i Up = AddCost(Load(PrevTotalEnergyTo + Column), Load(UpCost + Column));
+        const __m128i UpRight = AddCost(Load(PrevTotalEnergyTo + Column + 1), Load(UpRightCost + Column));
+        const __m128i UpLeft = AddCost(Load(PrevTotalEnergyTo + Column - 1), Load(UpLeftCost + Column));
+        const __m128i Energy = Load(PixelEnergy + Column);
+
+        __m128i MinEnergy = Up;
+        __m128i Offset = _mm_setzero_si128();
+        __m128i IsLess = _mm_cmpgt_epi32(MinEnergy, UpRight);
+        MinEnergy = _mm_blendv_epi8(MinEnergy, UpRight, IsLess);
+        Offset = _mm_blendv_epi8(Offset, OffsetRight, IsLess);
+        IsLess = _mm_cmpgt_epi32(MinEnergy, UpLeft);
+        MinEnergy = _mm_blendv_epi8(MinEnergy, UpLeft, IsLess);
+        Offset = _mm_blendv_epi8(Offset, OffsetLeft, IsLess);
+
+        const __m128i Invalid = _mm_or_si128(_mm_cmpeq_epi32(MinEnergy, Inf), _mm_cmpeq_epi32(Energy, Inf));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(OutTotalEnergyTo + Column),
+                         _mm_blendv_epi8(MinEnergy, Inf, Invalid));
+        StoreColumnOffsets(_mm_blendv_epi8(Offset, NoParent, Invalid), CPixelsPerIteration,
+                           OutColumnOffsetTo + Column);
+    }
+
+    CalculateForwardCumulativeEnergyRowScalar(PrevTotalEnergyTo, PixelEnergy, UpCost, UpLeftCost, UpRightCost,
+                                              Column, EndColumn, PosInf, OutTotalEnergyTo, OutColumnOffsetTo);
+}
+#endif
@@ -0,0 +1,276 @@
+#include "SeamCarverKernels.h"
+#include "EnergyTraits.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cfloat>
+#include <random>
+#include <vector>
+
+TEST(SeamCarverKernels, ScalarPicksCheapestUnmarkedParent)
+{
+    const double PosInf = DBL_MAX;
+    const int32_t NumColumns = 5;
+
+    // ties resolve to up, then up/right, then up/left. Columns -1 and NumColumns are padding,
+    //      column 3 of the previous row is marked and column 4 of the current row is marked
+    double PrevTotalEnergyTo[NumColumns + 2] = { PosInf, 1.0, 2.0, 2.0, PosInf, PosInf, PosInf };
+    double PixelEnergy[NumColumns] = { 10.0, 20.0, 30.0, 40.0, PosInf };
+
+    double TotalEnergyTo[NumColumns];
+    int8_t ColumnTo[NumColumns];
+    ct::SeamCarverKernels::CalculateCumulativeEnergyRowScalar(PrevTotalEnergyTo + 1, PixelEnergy, 0,
+                                                              NumColumns, PosInf, TotalEnergyTo,
+                                                              ColumnTo);
+
+    // back-pointers are offsets to the column of the parent
+    EXPECT_EQ(ColumnTo[0], 0);
+    EXPECT_EQ(TotalEnergyTo[0], 11.0);
+    EXPECT_EQ(ColumnTo[1], -1);
+    EXPECT_EQ(TotalEnergyTo[1], 21.0);
+    EXPECT_EQ(ColumnTo[2], 0);
+    EXPECT_EQ(TotalEnergyTo[2], 32.0);
+    // up is marked and up/right is +INF
+    EXPECT_EQ(ColumnTo[3], -1);
+    EXPECT_EQ(TotalEnergyTo[3], 42.0);
+    // marked pixels are unreachable
+    EXPECT_EQ(ColumnTo[4], ct::SeamCarverKernels::CNoParentOffset);
+    EXPECT_EQ(TotalEnergyTo[4], PosInf);
+}
+
+TEST(SeamCarverKernels, Int32SumsSaturateBelowPosInf)
+{
+    const int32_t PosInf = ct::KEnergyTraits<int32_t>::PosInf();
+    const int32_t MaxEnergy = ct::KEnergyTraits<int32_t>::CMaxEnergy;
+    const int32_t NumColumns = 3;
+
+    int32_t PrevTotalEnergyTo[NumColumns + 2] = { PosInf, MaxEnergy - 5, 100, MaxEnergy, PosInf };
+    int32_t PixelEnergy[NumColumns] = { 10, 390150, 390150 };
+
+    int32_t TotalEnergyTo[NumColumns];
+    int8_t ColumnTo[NumColumns];
+    ct::SeamCarverKernels::CalculateCumulativeEnergyRowScalar(PrevTotalEnergyTo + 1, PixelEnergy, 0,
+                                                              NumColumns, PosInf, TotalEnergyTo,
+                                                              ColumnTo);
+
+    // saturated paths are still reachable
+    EXPECT_EQ(ColumnTo[0], 1);
+    EXPECT_EQ(TotalEnergyTo[0], 110);
+    EXPECT_EQ(ColumnTo[2], -1);
+    EXPECT_EQ(TotalEnergyTo[2], 100 + 390150);
+
+    PrevTotalEnergyTo[2] = MaxEnergy - 5;
+    ct::SeamCarverKernels::CalculateCumulativeEnergyRowScalar(PrevTotalEnergyTo + 1, PixelEnergy, 0,
+                                                              NumColumns, PosInf, TotalEnergyTo,
+                                                              ColumnTo);
+    EXPECT_EQ(ColumnTo[0], 0);
+    EXPECT_EQ(TotalEnergyTo[0], MaxEnergy);
+    EXPECT_EQ(ColumnTo[2], -1);
+    EXPECT_EQ(TotalEnergyTo[2], MaxEnergy);
+}
+
+namespace
+{
+    /**
+     * @brief compares every kernel against the scalar kernel on random rows of every width up to 139
+     * @param BaseEnergy: added to every cumulative energy of the previous row, values close to
+     *      the largest energy make integer sums saturate
+     */
+    template<typename EnergyType>
+    void ExpectKernelsMatchScalar(
+        const std::vector<ct::SeamCarverKernels::KCumulativeEnergyRowKernelT<EnergyType>>& Kernels,
+        EnergyType BaseEnergy)
+    {
+        const EnergyType PosInf = ct::KEnergyTraits<EnergyType>::PosInf();
+        std::mt19937 Generator(7);
+
+        for (int32_t NumColumns = 1; NumColumns < 140; NumColumns++)
+        {
+            // few distinct energies produce many ties, which must resolve exactly like the scalar code
+            // the previous row has a padding column on each side, +INF stands for unreachable or
+            //      marked pixels
+            std::vector<EnergyType> PrevTotalEnergyTo(NumColumns + 2, PosInf);
+            std::vector<EnergyType> PixelEnergy(NumColumns);
+            for (int32_t Column = 0; Column < NumColumns; Column++)
+            {
+                PrevTotalEnergyTo[Column + 1] = Generator() % 4 == 0 ? PosInf : BaseEnergy + static_cast<EnergyType>(Generator() % 4);
+                PixelEnergy[Column] = Generator() % 6 == 0 ? PosInf : static_cast<EnergyType>(Generator() % 400);
+            }
+
+            for (int32_t StartColumn = 0; StartColumn < std::min(NumColumns, 3); StartColumn++)
+            {
+                std::vector<EnergyType> ExpectedTotal(NumColumns, -2);
+                std::vector<int8_t> ExpectedColumn(NumColumns, -2);
+                ct::SeamCarverKernels::CalculateCumulativeEnergyRowScalar(
+                    PrevTotalEnergyTo.data() + 1, PixelEnergy.data(), StartColumn, NumColumns, PosInf,
+                    ExpectedTotal.data(), ExpectedColumn.data());
+
+                for (ct::SeamCarverKernels::KCumulativeEnergyRowKernelT<EnergyType> Kernel : Kernels)
+                {
+                    std::vector<EnergyType> ActualTotal(NumColumns, -2);
+                    std::vector<int8_t> ActualColumn(NumColumns, -2);
+                    Kernel(PrevTotalEnergyTo.data() + 1, PixelEnergy.data(), StartColumn, NumColumns,
+                           PosInf, ActualTotal.data(), ActualColumn.data());
+                    // columns outside of the requested range must be left untouched
+                    ASSERT_EQ(ActualTotal, ExpectedTotal);
+                    ASSERT_EQ(ActualColumn, ExpectedColumn);
+                }
+            }
+        }
+    }
+}
+
+TEST(SeamCarverKernels, SimdKernelsMatchScalar)
+{
+    std::vector<ct::SeamCarverKernels::KCumulativeEnergyRowKernelT<double>> Kernels;
+    std::vector<ct::SeamCarverKernels::KCumulativeEnergyRowKernelT<int32_t>> Int32Kernels;
+#ifdef CT_X86_SIMD
+    if (ct::KCpuFeatures::HasSSE41())
+    {
+        Kernels.push_back(ct::SeamCarverKernels::CalculateCumulativeEnergyRowSSE41);
+        Int32Kernels.push_back(ct::SeamCarverKernels::CalculateCumulativeEnergyRowSSE41);
+    }
+    if (ct::KCpuFeatures::HasAVX2())
+    {
+        Kernels.push_back(ct::SeamCarverKernels::CalculateCumulativeEnergyRowAVX2);
+        Int32Kernels.push_back(ct::SeamCarverKernels::CalculateCumulativeEnergyRowAVX2);
+    }
+#endif
+
+    ExpectKernelsMatchScalar(Kernels, 0.0);
+    ExpectKernelsMatchScalar(Int32Kernels, 0);
+    ExpectKernelsMatchScalar(Int32Kernels, ct::KEnergyTraits<int32_t>::CMaxEnergy - 200);
+}
+
+TEST(SeamCarverKernels, ForwardCostsOfRow)
+{
+    // grayscale row below a row of 10s, the edge pixels repeat themselves beyond the edges
+    const uint8_t Above[4] = { 10, 10, 10, 10 };
+    const uint8_t Current[4] = { 0, 20, 50, 50 };
+
+    int32_t UpCost[4];
+    int32_t UpLeftCost[4];
+    int32_t UpRightCost[4];
+    ct::SeamCarverKernels::CalculateForwardCostRow(Above, Current, 4, 1, 0, 4, UpCost, UpLeftCost, UpRightCost);
+
+    // |right - left|, plus |above - left| or |above - right|
+    EXPECT_EQ(UpCost[0], 20);
+    EXPECT_EQ(UpLeftCost[0], 20 + 10);
+    EXPECT_EQ(UpRightCost[0], 20 + 10);
+    EXPECT_EQ(UpCost[1], 50);
+    EXPECT_EQ(UpLeftCost[1], 50 + 10);
+    EXPECT_EQ(UpRightCost[1], 50 + 40);
+    EXPECT_EQ(UpCost[3], 0);
+    EXPECT_EQ(UpLeftCost[3], 40);
+    EXPECT_EQ(UpRightCost[3], 40);
+
+    // differences are summed over the channels
+    const uint8_t AboveC3[6] = { 0, 0, 0, 0, 0, 0 };
+    const uint8_t CurrentC3[6] = { 1, 2, 3, 4, 6, 8 };
+    ct::SeamCarverKernels::CalculateForwardCostRow(AboveC3, CurrentC3, 2, 3, 0, 2, UpCost, UpLeftCost, UpRightCost);
+    EXPECT_EQ(UpCost[0], 3 + 4 + 5);
+    EXPECT_EQ(UpLeftCost[0], 12 + 6);
+    EXPECT_EQ(UpRightCost[0], 12 + 18);
+}
+
+TEST(SeamCarverKernels, ForwardScalarAddsTransitionCosts)
+{
+    const double PosInf = DBL_MAX;
+    const int32_t NumColumns = 4;
+
+    double PrevTotalEnergyTo[NumColumns + 2] = { PosInf, 10.0, 10.0, 10.0, PosInf, PosInf };
+    // finite pixel energies are ignored, column 3 is marked
+    double PixelEnergy[NumColumns] = { 1000.0, 0.0, 5.0, PosInf };
+    double UpCost[NumColumns] = { 5.0, 5.0, 5.0, 5.0 };
+    double UpLeftCost[NumColumns] = { 1.0, 1.0, 9.0, 1.0 };
+    double UpRightCost[NumColumns] = { 9.0, 7.0, 3.0, 1.0 };
+
+    double TotalEnergyTo[NumColumns];
+    int8_t ColumnTo[NumColumns];
+    ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowScalar(PrevTotalEnergyTo + 1, PixelEnergy,
+                                                                     UpCost, UpLeftCost, UpRightCost, 0,
+                                                                     NumColumns, PosInf, TotalEnergyTo,
+                                                                     ColumnTo);
+
+    // up/left of column 0 is padding
+    EXPECT_EQ(ColumnTo[0], 0);
+    EXPECT_EQ(TotalEnergyTo[0], 15.0);
+    EXPECT_EQ(ColumnTo[1], -1);
+    EXPECT_EQ(TotalEnergyTo[1], 11.0);
+    // up/right of column 2 is marked
+    EXPECT_EQ(ColumnTo[2], 0);
+    EXPECT_EQ(TotalEnergyTo[2], 15.0);
+    EXPECT_EQ(ColumnTo[3], ct::SeamCarverKernels::CNoParentOffset);
+    EXPECT_EQ(TotalEnergyTo[3], PosInf);
+}
+
+namespace
+{
+    template<typename EnergyType>
+    void ExpectForwardKernelsMatchScalar(
+        const std::vector<ct::SeamCarverKernels::KForwardCumulativeEnergyRowKernelT<EnergyType>>& Kernels,
+        EnergyType BaseEnergy)
+    {
+        const EnergyType PosInf = ct::KEnergyTraits<EnergyType>::PosInf();
+        std::mt19937 Generator(11);
+
+        for (int32_t NumColumns = 1; NumColumns < 140; NumColumns++)
+        {
+            std::vector<EnergyType> PrevTotalEnergyTo(NumColumns + 2, PosInf);
+            std::vector<EnergyType> PixelEnergy(NumColumns);
+            std::vector<EnergyType> Costs(3 * NumColumns);
+            for (int32_t Column = 0; Column < NumColumns; Column++)
+            {
+                PrevTotalEnergyTo[Column + 1] = Generator() % 4 == 0 ? PosInf : BaseEnergy + static_cast<EnergyType>(Generator() % 4);
+                PixelEnergy[Column] = Generator() % 6 == 0 ? PosInf : static_cast<EnergyType>(Generator() % 400);
+            }
+            for (EnergyType& Cost : Costs)
+            {
+                Cost = static_cast<EnergyType>(Generator() % 3);
+            }
+            const EnergyType* UpCost = Costs.data();
+            const EnergyType* UpLeftCost = UpCost + NumColumns;
+            const EnergyType* UpRightCost = UpLeftCost + NumColumns;
+
+            for (int32_t StartColumn = 0; StartColumn < std::min(NumColumns, 3); StartColumn++)
+            {
+                std::vector<EnergyType> ExpectedTotal(NumColumns, -2);
+                std::vector<int8_t> ExpectedColumn(NumColumns, -2);
+                ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowScalar(
+                    PrevTotalEnergyTo.data() + 1, PixelEnergy.data(), UpCost, UpLeftCost, UpRightCost,
+                    StartColumn, NumColumns, PosInf, ExpectedTotal.data(), ExpectedColumn.data());
+
+                for (ct::SeamCarverKernels::KForwardCumulativeEnergyRowKernelT<EnergyType> Kernel : Kernels)
+                {
+                    std::vector<EnergyType> ActualTotal(NumColumns, -2);
+                    std::vector<int8_t> ActualColumn(NumColumns, -2);
+                    Kernel(PrevTotalEnergyTo.data() + 1, PixelEnergy.data(), UpCost, UpLeftCost, UpRightCost,
+                           StartColumn, NumColumns, PosInf, ActualTotal.data(), ActualColumn.data());
+                    ASSERT_EQ(ActualTotal, ExpectedTotal);
+                    ASSERT_EQ(ActualColumn, ExpectedColumn);
+                }
+            }
+        }
+    }
+}
+
+TEST(SeamCarverKernels, ForwardSimdKernelsMatchScalar)
+{
+    std::vector<ct::SeamCarverKernels::KForwardCumulativeEnergyRowKernelT<double>> Kernels;
+    std::vector<ct::SeamCarverKernels::KForwardCumulativeEnergyRowKernelT<int32_t>> Int32Kernels;
+#ifdef CT_X86_SIMD
+    if (ct::KCpuFeatures::HasSSE41())
+    {
+        Kernels.push_back(ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowSSE41);
+        Int32Kernels.push_back(ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowSSE41);
+    }
+    if (ct::KCpuFeatures::HasAVX2())
+    {
+        Kernels.push_back(ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowAVX2);
+        Int32Kernels.push_back(ct::SeamCarverKernels::CalculateForwardCumulativeEnergyRowAVX2);
+    }
+#endif
+
+    ExpectForwardKernelsMatchScalar(Kernels, 0.0);
+    ExpectForwardKernelsMatchScalar(Int32Kernels, 0);
+    ExpectForwardKernelsMatchScalar(Int32Kernels, ct::KEnergyTraits<int32_t>::CMaxEnergy - 3);
+}
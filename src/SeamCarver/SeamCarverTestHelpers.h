@@ -0,0 +1,62 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstring>
+#include <random>
+#include <stdint.h>
+
+namespace ct
+{
+    namespace test
+    {
+        /**
+         * @brief fills an 8 bit image with reproducible noise
+         * @param NumRows: height of the image
+         * @param NumColumns: width of the image
+         * @param NumChannels: number of 8 bit channels
+         * @param Seed: seed of the noise, the same seed gives the same image
+         */
+        inline cv::Mat MakeRandomImage(int32_t NumRows, int32_t NumColumns, int32_t NumChannels, uint32_t Seed)
+        {
+            std::mt19937 Generator(Seed);
+            cv::Mat Image(NumRows, NumColumns, CV_8UC(NumChannels));
+            for (int32_t Row = 0; Row < NumRows; Row++)
+            {
+                uint8_t* Pixels = Image.ptr<uint8_t>(Row);
+                for (int32_t Index = 0; Index < NumColumns * NumChannels; Index++)
+                {
+                    Pixels[Index] = static_cast<uint8_t>(Generator() & 0xFF);
+                }
+            }
+            return Image;
+        }
+
+        /**
+         * @brief fills a 3 channel 8 bit image with reproducible noise
+         */
+        inline cv::Mat MakeRandomImage(int32_t NumRows, int32_t NumColumns, uint32_t Seed)
+        {
+            return MakeRandomImage(NumRows, NumColumns, 3, Seed);
+        }
+
+        /**
+         * @brief compares the size, the type and every byte of the pixels of two images
+         */
+        inline bool IsEqual(const cv::Mat& Image1, const cv::Mat& Image2)
+        {
+            if (Image1.size() != Image2.size() || Image1.type() != Image2.type())
+            {
+                return false;
+            }
+
+            for (int32_t Row = 0; Row < Image1.rows; Row++)
+            {
+                if (std::memcmp(Image1.ptr<uint8_t>(Row), Image2.ptr<uint8_t>(Row),
+                                Image1.cols * Image1.elemSize()) != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+}
@@ -0,0 +1,658 @@
+#include "SeamCarver.h"
+#include "SeamCarverTestHelpers.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    using ct::test::IsEqual;
+    using ct::test::MakeRandomImage;
+
+    /**
+     * @brief exposes the stages of the seam search
+     */
+    template<typename EnergyType>
+    class KTestSeamCarver : public ct::KSeamCarverT<EnergyType>
+    {
+    public:
+        using ct::KSeamCarverT<EnergyType>::CalculateCumulativeVerticalPathEnergy;
+        using ct::KSeamCarverT<EnergyType>::RecalculateCumulativeVerticalPathEnergy;
+        using ct::KSeamCarverT<EnergyType>::RemoveVerticalSeams;
+        using ct::KSeamCarverT<EnergyType>::CalculateImageEnergy;
+        using ct::KSeamCarverT<EnergyType>::FindVerticalSeams;
+        using ct::KSeamCarverT<EnergyType>::FindHorizontalSeams;
+        using ct::KSeamCarverT<EnergyType>::FindVerticalSeamsCoarseToFine;
+        using ct::KSeamCarverT<EnergyType>::MarkedPixels;
+
+        void SetDimensions(int32_t NumRows, int32_t NumColumns)
+        {
+            this->NumRows_ = NumRows;
+            this->NumColumns_ = NumColumns;
+            this->BottomRow_ = NumRows - 1;
+            this->RightColumn_ = NumColumns - 1;
+        }
+
+        // searches within bands that found all seams
+        int32_t NumBandSearches = 0;
+
+    protected:
+        bool FindVerticalSeamsInBands(int32_t NumSeams, ct::KMatrix2D<EnergyType>& PixelEnergy,
+                                      const ct::KSeamMatrix& GuideSeams, int32_t HalfWidth,
+                                      int32_t MaxHalfWidth, ct::KSeamMatrix& OutDiscoveredSeams) override
+        {
+            const bool bFound = ct::KSeamCarverT<EnergyType>::FindVerticalSeamsInBands(
+                NumSeams, PixelEnergy, GuideSeams, HalfWidth, MaxHalfWidth, OutDiscoveredSeams);
+            NumBandSearches += bFound ? 1 : 0;
+            return bFound;
+        }
+    };
+
+    void ThrowingEnergy(const cv::Mat&, ct::KMatrix2D<double>&)
+    {
+        throw std::runtime_error("energy failed");
+    }
+
+    /**
+     * @brief marks NumSeams random walks of one column per row with +INF energy and recalculates
+     *      the cumulative energies of their cone, then compares them to a full calculation
+     */
+    template<typename EnergyType>
+    void ExpectRecalculationMatchesFullCalculation(uint32_t Seed)
+    {
+        const int32_t NumRows = 50;
+        const int32_t NumColumns = 90;
+        const EnergyType PosInf = ct::KEnergyTraits<EnergyType>::PosInf();
+        std::mt19937 Generator(Seed);
+
+        // few distinct energies produce many ties
+        ct::KMatrix2D<EnergyType> PixelEnergy(NumRows, NumColumns);
+        for (int32_t Row = 0; Row < NumRows; Row++)
+        {
+            for (int32_t Column = 0; Column < NumColumns; Column++)
+            {
+                PixelEnergy[Row][Column] = static_cast<EnergyType>(Generator() % 8);
+            }
+        }
+
+        KTestSeamCarver<EnergyType> Carver;
+        Carver.SetDimensions(NumRows, NumColumns);
+
+        // one padding column on each side, as in the seam search
+        ct::KMatrix2D<EnergyType> TotalEnergyToBuffer(NumRows, NumColumns + 2);
+        ct::KMatrix2D<EnergyType> TotalEnergyTo(TotalEnergyToBuffer.GetData() + 1, NumRows, NumColumns,
+                                                TotalEnergyToBuffer.GetStride());
+        ct::KMatrix2D<int8_t> ColumnTo(NumRows, NumColumns);
+        Carver.CalculateCumulativeVerticalPathEnergy(PixelEnergy, TotalEnergyTo, ColumnTo);
+
+        ct::KMatrix2D<EnergyType> ExpectedBuffer(NumRows, NumColumns + 2);
+        ct::KMatrix2D<EnergyType> ExpectedTotalEnergyTo(ExpectedBuffer.GetData() + 1, NumRows, NumColumns,
+                                                        ExpectedBuffer.GetStride());
+        ct::KMatrix2D<int8_t> ExpectedColumnTo(NumRows, NumColumns);
+
+        for (int32_t Round = 0; Round < 6; Round++)
+        {
+            const int32_t NumSeams = Round % 3;
+            std::vector<int32_t> Seams;
+            for (int32_t Seam = 0; Seam < NumSeams; Seam++)
+            {
+                int32_t Column = static_cast<int32_t>(Generator() % NumColumns);
+                for (int32_t Row = 0; Row < NumRows; Row++)
+                {
+                    Column = std::min(std::max(Column + static_cast<int32_t>(Generator() % 3) - 1, 0), NumColumns - 1);
+                    Seams.push_back(Column);
+                    PixelEnergy[Row][Column] = PosInf;
+                }
+            }
+
+            // bottom row pixels whose path was rejected are set to +INF by the search
+            std::vector<int32_t> InvalidatedColumns;
+            for (int32_t Index = 0; Index < 3; Index++)
+            {
+                InvalidatedColumns.push_back(static_cast<int32_t>(Generator() % NumColumns));
+                TotalEnergyTo[NumRows - 1][InvalidatedColumns.back()] = PosInf;
+            }
+
+            Carver.RecalculateCumulativeVerticalPathEnergy(PixelEnergy, Seams, InvalidatedColumns, TotalEnergyTo,
+                                                           ColumnTo);
+            Carver.CalculateCumulativeVerticalPathEnergy(PixelEnergy, ExpectedTotalEnergyTo, ExpectedColumnTo);
+            for (int32_t Row = 0; Row < NumRows; Row++)
+            {
+                for (int32_t Column = 0; Column < NumColumns; Column++)
+                {
+                    ASSERT_EQ(TotalEnergyTo[Row][Column], ExpectedTotalEnergyTo[Row][Column])
+                        << "round " << Round << " row " << Row << " column " << Column;
+                    ASSERT_EQ(ColumnTo[Row][Column], ExpectedColumnTo[Row][Column])
+                        << "round " << Round << " row " << Row << " column " << Column;
+                }
+            }
+        }
+    }
+}
+
+TEST(SeamCarver, ForwardSeamMatchesReference)
+{
+    std::mt19937 Generator(5);
+    cv::Mat Image(30, 40, CV_8UC1);
+    for (int32_t Row = 0; Row < Image.rows; Row++)
+    {
+        for (int32_t Column = 0; Column < Image.cols; Column++)
+        {
+            Image.ptr<uint8_t>(Row)[Column] = static_cast<uint8_t>(Generator() & 0xFF);
+        }
+    }
+
+    // straightforward forward energy: M(0, j) = 0 and
+    //      M(i, j) = min(M(i-1, j-1) + CL, M(i-1, j) + CU, M(i-1, j+1) + CR)
+    auto Pixel = [&Image](int32_t Row, int32_t Column)
+    {
+        return static_cast<int32_t>(Image.ptr<uint8_t>(Row)[std::min(std::max(Column, 0), Image.cols - 1)]);
+    };
+    std::vector<std::vector<int64_t>> TotalEnergyTo(Image.rows, std::vector<int64_t>(Image.cols, 0));
+    std::vector<std::vector<int32_t>> ColumnTo(Image.rows, std::vector<int32_t>(Image.cols, 0));
+    for (int32_t Row = 1; Row < Image.rows; Row++)
+    {
+        for (int32_t Column = 0; Column < Image.cols; Column++)
+        {
+            const int32_t UpCost = std::abs(Pixel(Row, Column + 1) - Pixel(Row, Column - 1));
+            const int64_t Up = TotalEnergyTo[Row - 1][Column] + UpCost;
+            int64_t MinEnergy = Up;
+            ColumnTo[Row][Column] = Column;
+            if (Column + 1 < Image.cols)
+            {
+                const int64_t UpRight = TotalEnergyTo[Row - 1][Column + 1] + UpCost +
+                    std::abs(Pixel(Row - 1, Column) - Pixel(Row, Column + 1));
+                if (UpRight < MinEnergy)
+                {
+                    MinEnergy = UpRight;
+                    ColumnTo[Row][Column] = Column + 1;
+                }
+            }
+            if (Column > 0)
+            {
+                const int64_t UpLeft = TotalEnergyTo[Row - 1][Column - 1] + UpCost +
+                    std::abs(Pixel(Row - 1, Column) - Pixel(Row, Column - 1));
+                if (UpLeft < MinEnergy)
+                {
+                    MinEnergy = UpLeft;
+                    ColumnTo[Row][Column] = Column - 1;
+                }
+            }
+            TotalEnergyTo[Row][Column] = MinEnergy;
+        }
+    }
+
+    std::vector<int32_t> Seam(Image.rows);
+    const std::vector<int64_t>& BottomRow = TotalEnergyTo[Image.rows - 1];
+    Seam[Image.rows - 1] = static_cast<int32_t>(std::min_element(BottomRow.begin(), BottomRow.end()) - BottomRow.begin());
+    for (int32_t Row = Image.rows - 1; Row > 0; Row--)
+    {
+        Seam[Row - 1] = ColumnTo[Row][Seam[Row]];
+    }
+
+    ct::KSeamCarverT<int32_t> Carver;
+    cv::Mat Carved;
+    ASSERT_TRUE(Carver.FindAndRemoveVerticalSeams(1, Image, Carved, ct::KSeamCost::Forward));
+    ASSERT_EQ(Carved.cols, Image.cols - 1);
+    for (int32_t Row = 0; Row < Image.rows; Row++)
+    {
+        for (int32_t Column = 0; Column < Carved.cols; Column++)
+        {
+            const int32_t SourceColumn = Column < Seam[Row] ? Column : Column + 1;
+            ASSERT_EQ(Carved.ptr<uint8_t>(Row)[Column], Image.ptr<uint8_t>(Row)[SourceColumn])
+                << "row " << Row << " column " << Column;
+        }
+    }
+
+    // the seam differs from the one of backward energy
+    cv::Mat BackwardCarved;
+    ct::KSeamCarverT<int32_t> BackwardCarver;
+    ASSERT_TRUE(BackwardCarver.FindAndRemoveVerticalSeams(1, Image, BackwardCarved, ct::KSeamCost::Backward));
+    bool bSameSeam = true;
+    for (int32_t Row = 0; Row < Image.rows; Row++)
+    {
+        bSameSeam = bSameSeam && std::memcmp(Carved.ptr<uint8_t>(Row), BackwardCarved.ptr<uint8_t>(Row), Carved.cols) == 0;
+    }
+    EXPECT_FALSE(bSameSeam);
+}
+
+
+TEST(SeamCarver, RecalculationMatchesFullCalculation)
+{
+    ExpectRecalculationMatchesFullCalculation<double>(3);
+    ExpectRecalculationMatchesFullCalculation<int32_t>(4);
+}
+
+TEST(SeamCarver, SameSizeFramesMatchFreshCarver)
+{
+    const int32_t NumSeams = 20;
+    ct::KSeamCarver Carver;
+
+    // the seams of one frame must not be kept out of the next one
+    for (uint32_t Frame = 0; Frame < 8; Frame++)
+    {
+        cv::Mat Image = MakeRandomImage(60, 100, Frame);
+        cv::Mat Result;
+        cv::Mat Expected;
+
+        ASSERT_TRUE(Carver.FindAndRemoveVerticalSeams(NumSeams, Image, Result)) << "frame " << Frame;
+        ASSERT_TRUE(ct::KSeamCarver().FindAndRemoveVerticalSeams(NumSeams, Image, Expected));
+        EXPECT_TRUE(IsEqual(Result, Expected)) << "frame " << Frame;
+
+        ASSERT_TRUE(Carver.FindAndInsertVerticalSeams(NumSeams, Image, Result)) << "frame " << Frame;
+        ASSERT_TRUE(ct::KSeamCarver().FindAndInsertVerticalSeams(NumSeams, Image, Expected));
+        EXPECT_TRUE(IsEqual(Result, Expected)) << "frame " << Frame;
+
+        ASSERT_TRUE(Carver.FindAndRemoveHorizontalSeams(NumSeams, Image, Result)) << "frame " << Frame;
+        ASSERT_TRUE(ct::KSeamCarver().FindAndRemoveHorizontalSeams(NumSeams, Image, Expected));
+        EXPECT_TRUE(IsEqual(Result, Expected)) << "frame " << Frame;
+    }
+}
+
+TEST(SeamCarver, IterativeRemovalMatchesSingleSeamRemoval)
+{
+    const int32_t NumSeams = 15;
+    cv::Mat Image = MakeRandomImage(40, 60, 6);
+
+    // every seam is found on the exact energy of the image left by the ones before, as when the
+    //      energy of the whole image is calculated again for every seam
+    ct::KSeamCarver Carver;
+    cv::Mat Result;
+    ASSERT_TRUE(Carver.FindAndRemoveVerticalSeamsIteratively(NumSeams, Image, Result));
+
+    cv::Mat Expected = Image.clone();
+    for (int32_t Seam = 0; Seam < NumSeams; Seam++)
+    {
+        cv::Mat Carved;
+        ASSERT_TRUE(ct::KSeamCarver().FindAndRemoveVerticalSeams(1, Expected, Carved));
+        Expected = Carved;
+    }
+    EXPECT_TRUE(IsEqual(Result, Expected));
+
+    ct::KSeamCarverT<int32_t> Int32Carver;
+    ASSERT_TRUE(Int32Carver.FindAndRemoveVerticalSeamsIteratively(NumSeams, Image, Result));
+    EXPECT_TRUE(IsEqual(Result, Expected));
+}
+
+TEST(SeamCarver, HorizontalRemovalMatchesTransposedVerticalRemoval)
+{
+    const int32_t NumSeams = 12;
+    cv::Mat Image = MakeRandomImage(50, 36, 7);
+
+    ct::KSeamCarver Carver;
+    cv::Mat Result;
+    ASSERT_TRUE(Carver.FindAndRemoveHorizontalSeams(NumSeams, Image, Result));
+    ASSERT_EQ(Result.rows, Image.rows - NumSeams);
+    ASSERT_EQ(Result.cols, Image.cols);
+
+    // the dual-gradient energy is the same for the transposed image, so are the seams
+    cv::Mat Transposed;
+    cv::Mat Carved;
+    cv::Mat Expected;
+    cv::transpose(Image, Transposed);
+    ASSERT_TRUE(ct::KSeamCarver().FindAndRemoveVerticalSeams(NumSeams, Transposed, Carved));
+    cv::transpose(Carved, Expected);
+    EXPECT_TRUE(IsEqual(Result, Expected));
+}
+
+TEST(SeamCarver, InsertionKeepsOriginalPixels)
+{
+    const int32_t NumSeams = 14;
+    cv::Mat Image = MakeRandomImage(30, 40, 8);
+
+    ct::KSeamCarver Carver;
+    cv::Mat Result;
+    ASSERT_TRUE(Carver.FindAndInsertVerticalSeams(NumSeams, Image, Result));
+    ASSERT_EQ(Result.rows, Image.rows);
+    ASSERT_EQ(Result.cols, Image.cols + NumSeams);
+    ASSERT_EQ(Result.type(), Image.type());
+
+    // every row holds the pixels of the input in order, with NumSeams new pixels between them
+    for (int32_t Row = 0; Row < Image.rows; Row++)
+    {
+        const uint8_t* Pixels = Image.ptr<uint8_t>(Row);
+        const uint8_t* ResultPixels = Result.ptr<uint8_t>(Row);
+        int32_t Column = 0;
+        for (int32_t ResultColumn = 0; ResultColumn < Result.cols && Column < Image.cols; ResultColumn++)
+        {
+            if (std::memcmp(ResultPixels + ResultColumn * 3, Pixels + Column * 3, 3) == 0)
+            {
+                Column++;
+            }
+        }
+        EXPECT_EQ(Column, Image.cols) << "row " << Row;
+    }
+
+    // inserting no seams copies the image, more seams than columns cannot be found by one search
+    ASSERT_TRUE(Carver.FindAndInsertVerticalSeams(0, Image, Result));
+    EXPECT_TRUE(IsEqual(Result, Image));
+    EXPECT_FALSE(Carver.FindAndInsertVerticalSeams(Image.cols + 1, Image, Result));
+}
+
+TEST(SeamCarver, InPlaceRemovalMatchesSplitMerge)
+{
+    const int32_t NumRows = 70;
+    const int32_t NumColumns = 45;
+    const int32_t NumSeams = 9;
+    std::mt19937 Generator(10);
+
+    // any sorted columns can be removed, seams do not need to be connected for the copy
+    ct::KSeamMatrix Seams(NumRows, NumSeams);
+    for (int32_t Row = 0; Row < NumRows; Row++)
+    {
+        std::vector<int32_t> Columns(NumColumns);
+        for (int32_t Column = 0; Column < NumColumns; Column++)
+        {
+            Columns[Column] = Column;
+        }
+        std::shuffle(Columns.begin(), Columns.end(), Generator);
+        std::sort(Columns.begin(), Columns.begin() + NumSeams);
+        std::copy(Columns.begin(), Columns.begin() + NumSeams, Seams[Row]);
+    }
+
+    for (int32_t Type : { CV_8UC1, CV_8UC3, CV_8UC4, CV_16UC3 })
+    {
+        cv::Mat Image(NumRows, NumColumns, Type);
+        for (int32_t Row = 0; Row < NumRows; Row++)
+        {
+            uint8_t* Pixels = Image.ptr<uint8_t>(Row);
+            for (size_t Index = 0; Index < NumColumns * Image.elemSize(); Index++)
+            {
+                Pixels[Index] = static_cast<uint8_t>(Generator() & 0xFF);
+            }
+        }
+
+        // every channel on its own, as before the interleaved removal
+        std::vector<cv::Mat> Channels;
+        cv::split(Image, Channels);
+        for (cv::Mat& Channel : Channels)
+        {
+            cv::Mat Carved(NumRows, NumColumns - NumSeams, Channel.type());
+            const size_t PixelSize = Channel.elemSize();
+            for (int32_t Row = 0; Row < NumRows; Row++)
+            {
+                int32_t CarvedColumn = 0;
+                for (int32_t Column = 0; Column < NumColumns; Column++)
+                {
+                    if (std::find(Seams[Row], Seams[Row] + NumSeams, Column) == Seams[Row] + NumSeams)
+                    {
+                        std::memcpy(Carved.ptr<uint8_t>(Row) + CarvedColumn++ * PixelSize,
+                                    Channel.ptr<uint8_t>(Row) + Column * PixelSize, PixelSize);
+                    }
+                }
+            }
+            Channel = Carved;
+        }
+        cv::Mat Expected;
+        cv::merge(Channels, Expected);
+
+        // rows in parallel bands and serially
+        for (int32_t NumThreads : { 1, 4 })
+        {
+            KTestSeamCarver<double> Carver;
+            Carver.SetNumThreads(NumThreads);
+            Carver.SetDimensions(NumRows, NumColumns);
+            cv::Mat Result;
+            Carver.RemoveVerticalSeams(Image, Seams, Result);
+            EXPECT_TRUE(IsEqual(Result, Expected)) << "type " << Type << " threads " << NumThreads;
+        }
+    }
+}
+
+TEST(SeamCarver, SeamMatrixHoldsSortedSeamPixels)
+{
+    const int32_t NumSeams = 16;
+    cv::Mat Image = MakeRandomImage(36, 48, 14);
+
+    KTestSeamCarver<double> Carver;
+    Carver.SetDimensions(Image.rows, Image.cols);
+    ct::KMatrix2D<double> PixelEnergy(Image.rows, Image.cols);
+
+    // row r of a vertical seam matrix holds the columns of the seam pixels of row r in increasing
+    //      order, as the min heap of every row used to pop them
+    Carver.MarkedPixels.Resize(Image.rows, Image.cols);
+    Carver.MarkedPixels.Fill(false);
+    ASSERT_TRUE(Carver.CalculateImageEnergy(Image, PixelEnergy, nullptr));
+    ct::KSeamMatrix Seams(Image.rows, NumSeams);
+    ASSERT_TRUE(Carver.FindVerticalSeams(NumSeams, PixelEnergy, Seams));
+    for (int32_t Row = 0; Row < Image.rows; Row++)
+    {
+        std::vector<int32_t> Marked;
+        for (int32_t Column = 0; Column < Image.cols; Column++)
+        {
+            if (Carver.MarkedPixels.IsMarked(Row, Column))
+            {
+                Marked.push_back(Column);
+            }
+        }
+        ASSERT_EQ(std::vector<int32_t>(Seams[Row], Seams[Row] + NumSeams), Marked) << "row " << Row;
+
+        // the k-th smallest columns of all rows form a connected seam
+        for (int32_t Seam = 0; Row > 0 && Seam < NumSeams; Seam++)
+        {
+            ASSERT_LE(std::abs(Seams[Row][Seam] - Seams[Row - 1][Seam]), 1) << "row " << Row;
+        }
+    }
+
+    // row c of a horizontal seam matrix holds the rows of the seam pixels of column c
+    Carver.MarkedPixels.Fill(false);
+    ASSERT_TRUE(Carver.CalculateImageEnergy(Image, PixelEnergy, nullptr));
+    ct::KSeamMatrix HorizontalSeams(Image.cols, NumSeams);
+    ASSERT_TRUE(Carver.FindHorizontalSeams(NumSeams, PixelEnergy, HorizontalSeams));
+    for (int32_t Column = 0; Column < Image.cols; Column++)
+    {
+        std::vector<int32_t> Marked;
+        for (int32_t Row = 0; Row < Image.rows; Row++)
+        {
+            if (Carver.MarkedPixels.IsMarked(Row, Column))
+            {
+                Marked.push_back(Row);
+            }
+        }
+        ASSERT_EQ(std::vector<int32_t>(HorizontalSeams[Column], HorizontalSeams[Column] + NumSeams), Marked)
+            << "column " << Column;
+    }
+}
+
+TEST(SeamCarver, PyramidSeamsAreConnectedAndDisjoint)
+{
+    const int32_t NumSeams = 40;
+    cv::Mat Image = MakeRandomImage(160, 200, 17);
+
+    // two coarser levels of 80 x 100 and 40 x 50 pixels
+    for (int32_t NumLevels : { 1, 2, 3 })
+    {
+        KTestSeamCarver<int32_t> Carver;
+        Carver.MarkedPixels.Resize(Image.rows, Image.cols);
+        Carver.MarkedPixels.Fill(false);
+        ct::KSeamMatrix Seams(Image.rows, NumSeams);
+        ASSERT_TRUE(Carver.FindVerticalSeamsCoarseToFine(NumSeams, Image, NumLevels, 2, Seams));
+
+        // the seams of the full resolution come from the bands, not from a full search
+        EXPECT_EQ(Carver.NumBandSearches, 1);
+
+        for (int32_t Row = 0; Row < Image.rows; Row++)
+        {
+            ASSERT_GE(Seams[Row][0], 0) << "row " << Row;
+            ASSERT_LT(Seams[Row][NumSeams - 1], Image.cols) << "row " << Row;
+            for (int32_t Seam = 0; Seam < NumSeams; Seam++)
+            {
+                ASSERT_TRUE(Seam == 0 || Seams[Row][Seam] > Seams[Row][Seam - 1]) << "row " << Row;
+                ASSERT_TRUE(Row == 0 || std::abs(Seams[Row][Seam] - Seams[Row - 1][Seam]) <= 1) << "row " << Row;
+                ASSERT_TRUE(Carver.MarkedPixels.IsMarked(Row, Seams[Row][Seam])) << "row " << Row;
+            }
+        }
+
+        cv::Mat Result;
+        ASSERT_TRUE(Carver.FindAndRemoveVerticalSeamsCoarseToFine(NumSeams, Image, Result, NumLevels, 2));
+        EXPECT_EQ(Result.rows, Image.rows);
+        EXPECT_EQ(Result.cols, Image.cols - NumSeams);
+    }
+}
+
+TEST(SeamCarver, PyramidReusesCoarseWorkspaces)
+{
+    const int32_t NumSeams = 40;
+    const int32_t NumLevels = 3;
+    ct::KSeamCarver Carver;
+    ct::KSeamCarver FreshCarver;
+    cv::Mat Result;
+    cv::Mat Expected;
+
+    ASSERT_TRUE(Carver.FindAndRemoveVerticalSeamsCoarseToFine(NumSeams, MakeRandomImage(160, 200, 1), Result,
+        NumLevels, 2));
+    const size_t FirstWorkspaceSize = Carver.GetStats().WorkspaceSize;
+
+    // frames of the same size only reuse the buffers of all levels
+    for (uint32_t Frame = 2; Frame < 5; Frame++)
+    {
+        cv::Mat Image = MakeRandomImage(160, 200, Frame);
+        ASSERT_TRUE(Carver.FindAndRemoveVerticalSeamsCoarseToFine(NumSeams, Image, Result, NumLevels, 2));
+        EXPECT_EQ(Carver.GetStats().NumBytesAllocated, 0u) << "frame " << Frame;
+        EXPECT_EQ(Carver.GetStats().WorkspaceSize, FirstWorkspaceSize) << "frame " << Frame;
+
+        ASSERT_TRUE(FreshCarver.FindAndRemoveVerticalSeamsCoarseToFine(NumSeams, Image, Expected, NumLevels, 2));
+        FreshCarver.ReleaseWorkspace();
+        EXPECT_TRUE(IsEqual(Result, Expected)) << "frame " << Frame;
+    }
+
+    // the coarser levels are part of the workspace
+    ct::KSeamCarver FullResolutionCarver;
+    ASSERT_TRUE(FullResolutionCarver.FindAndRemoveVerticalSeamsCoarseToFine(NumSeams, MakeRandomImage(160, 200, 1),
+        Result, 1, 2));
+    EXPECT_GT(FirstWorkspaceSize, FullResolutionCarver.GetStats().WorkspaceSize);
+}
+
+TEST(SeamCarver, RetargetToExactSize)
+{
+    cv::Mat Image = MakeRandomImage(34, 46, 19);
+    ct::KSeamCarver Carver;
+    cv::Mat Result;
+
+    for (const cv::Size& Size : { cv::Size(30, 20), cv::Size(46, 25), cv::Size(33, 34), cv::Size(46, 34),
+                                  cv::Size(1, 1) })
+    {
+        ASSERT_TRUE(Carver.RetargetTo(Size, Image, Result)) << Size.width << " x " << Size.height;
+        EXPECT_EQ(Result.cols, Size.width);
+        EXPECT_EQ(Result.rows, Size.height);
+        EXPECT_EQ(Result.type(), Image.type());
+    }
+
+    // with only one direction left to shrink, the seams are those of iterative removal
+    cv::Mat Expected;
+    ASSERT_TRUE(Carver.RetargetTo(cv::Size(36, Image.rows), Image, Result));
+    ASSERT_TRUE(ct::KSeamCarver().FindAndRemoveVerticalSeamsIteratively(10, Image, Expected));
+    EXPECT_TRUE(IsEqual(Result, Expected));
+
+    // seams cannot enlarge the image
+    EXPECT_FALSE(Carver.RetargetTo(cv::Size(Image.cols + 1, Image.rows), Image, Result));
+    EXPECT_FALSE(Carver.RetargetTo(cv::Size(Image.cols, Image.rows + 1), Image, Result));
+    EXPECT_FALSE(Carver.RetargetTo(cv::Size(20, 0), Image, Result));
+}
+
+TEST(SeamCarver, IterativeRemovalKeepsMarkedPixels)
+{
+    cv::Mat Image = MakeRandomImage(34, 46, 22);
+    KTestSeamCarver<double> Carver;
+    Carver.MarkedPixels.Resize(Image.rows, Image.cols);
+    Carver.MarkedPixels.Fill(false);
+    for (int32_t Row = 5; Row < 15; Row++)
+    {
+        for (int32_t Column = 20; Column < 26; Column++)
+        {
+            Carver.MarkedPixels.Mark(Row, Column);
+        }
+    }
+    ct::KBitMask2D Expected(Image.rows, Image.cols);
+    Expected.Or(Carver.MarkedPixels);
+
+    auto ExpectSameMarks = [&]()
+    {
+        for (int32_t Row = 0; Row < Image.rows; Row++)
+        {
+            for (int32_t Column = 0; Column < Image.cols; Column++)
+            {
+                ASSERT_EQ(Carver.MarkedPixels.IsMarked(Row, Column), Expected.IsMarked(Row, Column))
+                    << "row " << Row << " column " << Column;
+            }
+        }
+    };
+
+    // the marks still match the input, so every call of the same input gives the same result
+    cv::Mat FirstResult;
+    cv::Mat Result;
+    ASSERT_TRUE(Carver.FindAndRemoveVerticalSeamsIteratively(10, Image, FirstResult));
+    ExpectSameMarks();
+    ASSERT_TRUE(Carver.FindAndRemoveVerticalSeamsIteratively(10, Image, Result));
+    ExpectSameMarks();
+    EXPECT_TRUE(IsEqual(Result, FirstResult));
+
+    ct::KSeamIndexMap FirstSeamIndexMap;
+    ct::KSeamIndexMap SeamIndexMap;
+    ASSERT_TRUE(Carver.ComputeSeamIndexMap(10, Image, FirstSeamIndexMap));
+    ExpectSameMarks();
+    ASSERT_TRUE(Carver.ComputeSeamIndexMap(10, Image, SeamIndexMap));
+    ExpectSameMarks();
+    EXPECT_TRUE(IsEqual(SeamIndexMap.GetMap(), FirstSeamIndexMap.GetMap()));
+
+    ASSERT_TRUE(Carver.RetargetTo(cv::Size(36, 28), Image, FirstResult));
+    ExpectSameMarks();
+    ASSERT_TRUE(Carver.RetargetTo(cv::Size(36, 28), Image, Result));
+    ExpectSameMarks();
+    EXPECT_TRUE(IsEqual(Result, FirstResult));
+}
+
+TEST(SeamCarver, SearchReportOfDeadlines)
+{
+    const int32_t NumSeams = 30;
+    cv::Mat Image = MakeRandomImage(40, 50, 20);
+    ct::KSeamCarver Carver;
+    cv::Mat Result;
+    cv::Mat Expected;
+    ct::KSeamSearchReport Report;
+
+    // without a deadline every seam is exact, and the seams are those of the call without one
+    ASSERT_TRUE(Carver.FindAndRemoveVerticalSeams(NumSeams, Image, Result,
+                                                  std::chrono::steady_clock::time_point::max(), &Report));
+    ASSERT_TRUE(ct::KSeamCarver().FindAndRemoveVerticalSeams(NumSeams, Image, Expected));
+    EXPECT_TRUE(IsEqual(Result, Expected));
+    EXPECT_FALSE(Report.bDeadlineReached);
+    ASSERT_EQ(Report.Strategies.size(), static_cast<size_t>(NumSeams));
+    EXPECT_EQ(Report.CountSeams(ct::KSeamStrategy::Exact), NumSeams);
+    EXPECT_GT(Report.NumRecalculations, 0);
+
+    // past the deadline the first seam is still exact, the following ones are detoured or walked
+    //      greedily instead of recalculating the cumulative energies
+    ASSERT_TRUE(Carver.FindAndRemoveVerticalSeams(NumSeams, Image, Result,
+                                                  std::chrono::steady_clock::now() - std::chrono::seconds(1), &Report));
+    EXPECT_EQ(Result.cols, Image.cols - NumSeams);
+    EXPECT_TRUE(Report.bDeadlineReached);
+    ASSERT_EQ(Report.Strategies.size(), static_cast<size_t>(NumSeams));
+    EXPECT_EQ(Report.Strategies[0], ct::KSeamStrategy::Exact);
+    const int32_t NumCheaperSeams = Report.CountSeams(ct::KSeamStrategy::StaleEnergy) +
+                                    Report.CountSeams(ct::KSeamStrategy::GreedyDescent);
+    EXPECT_GT(NumCheaperSeams, 0);
+    EXPECT_EQ(Report.CountSeams(ct::KSeamStrategy::Exact) + NumCheaperSeams, NumSeams);
+}
+
+TEST(SeamCarver, ExceptionsAreReportedInStats)
+{
+    cv::Mat Image = MakeRandomImage(20, 30, 21);
+    ct::KSeamCarver Carver;
+    cv::Mat Result;
+
+    EXPECT_FALSE(Carver.FindAndRemoveVerticalSeams(4, Image, Result, ThrowingEnergy));
+    EXPECT_EQ(Carver.GetStats().ErrorMessage, "energy failed");
+    EXPECT_FALSE(Carver.FindAndInsertVerticalSeams(4, Image, Result, ThrowingEnergy));
+    EXPECT_EQ(Carver.GetStats().ErrorMessage, "energy failed");
+    EXPECT_FALSE(Carver.FindAndRemoveHorizontalSeams(4, Image, Result, ThrowingEnergy));
+    EXPECT_EQ(Carver.GetStats().ErrorMessage, "energy failed");
+
+    // the message only describes the call that failed
+    ASSERT_TRUE(Carver.FindAndRemoveVerticalSeams(4, Image, Result));
+    EXPECT_TRUE(Carver.GetStats().ErrorMessage.empty());
+}
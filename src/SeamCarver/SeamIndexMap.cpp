@@ -0,0 +1,110 @@
+#include "SeamIndexMap.h"
+#include <cstring>
+#include <vector>
+
+bool ct::KSeamIndexMap::Assign(const cv::Mat& SeamIndexMap)
+{
+    if (SeamIndexMap.type() != CV_16UC1 || SeamIndexMap.empty())
+    {
+        return false;
+    }
+
+    // every row removes one pixel per seam, so all rows have the same number of removed pixels
+    //      and hold every index below it exactly once. Retarget relies on this to drop exactly
+    //      img.cols - Width pixels from every row
+    int32_t NumSeams = -1;
+    std::vector<uint8_t> bSeen;
+    for (int32_t Row = 0; Row < SeamIndexMap.rows; Row++)
+    {
+        const uint16_t* Indices = SeamIndexMap.ptr<uint16_t>(Row);
+        int32_t NumRemoved = 0;
+        for (int32_t Column = 0; Column < SeamIndexMap.cols; Column++)
+        {
+            NumRemoved += Indices[Column] != CKeptPixel ? 1 : 0;
+        }
+
+        if (NumSeams != -1 && NumRemoved != NumSeams)
+        {
+            return false;
+        }
+        NumSeams = NumRemoved;
+
+        bSeen.assign(NumRemoved, 0);
+        for (int32_t Column = 0; Column < SeamIndexMap.cols; Column++)
+        {
+            const int32_t Index = Indices[Column];
+            if (Index == CKeptPixel)
+            {
+                continue;
+            }
+            if (Index >= NumRemoved || bSeen[Index] != 0)
+            {
+                return false;
+            }
+            bSeen[Index] = 1;
+        }
+    }
+
+    // a copy, so the caller cannot change the map once it was checked
+    Map_ = SeamIndexMap.clone();
+    NumSeams_ = NumSeams;
+    return true;
+}
+
+bool ct::KSeamIndexMap::Retarget(const cv::Mat& img, int32_t Width, cv::Mat& outImg) const
+{
+    if (img.rows != Map_.rows || img.cols != Map_.cols || Width < GetMinWidth() || Width > Map_.cols)
+    {
+        return false;
+    }
+
+    // pixels of the first NumRemoved seams are dropped, all others are copied in order
+    const int32_t NumRemoved = Map_.cols - Width;
+    const size_t PixelSize = img.elemSize();
+
+    // written to a new image if outImg shares memory with img, so img and outImg may be the same
+    cv::Mat Result;
+    if (outImg.datastart != nullptr && outImg.datastart == img.datastart)
+    {
+        Result.create(img.rows, Width, img.type());
+    }
+    else
+    {
+        outImg.create(img.rows, Width, img.type());
+        Result = outImg;
+    }
+
+    for (int32_t Row = 0; Row < img.rows; Row++)
+    {
+        const uint16_t* Indices = Map_.ptr<uint16_t>(Row);
+        const uint8_t* InPixels = img.ptr<uint8_t>(Row);
+        uint8_t* OutPixels = Result.ptr<uint8_t>(Row);
+
+        // the pixels between two dropped pixels are copied as one block
+        int32_t SpanStart = 0;
+        for (int32_t Column = 0; Column < img.cols; Column++)
+        {
+            if (Indices[Column] < NumRemoved)
+            {
+                size_t SpanSize = (Column - SpanStart) * PixelSize;
+                std::memcpy(OutPixels, InPixels + SpanStart * PixelSize, SpanSize);
+                OutPixels += SpanSize;
+                SpanStart = Column + 1;
+            }
+        }
+        std::memcpy(OutPixels, InPixels + SpanStart * PixelSize, (img.cols - SpanStart) * PixelSize);
+    }
+
+    outImg = Result;
+    return true;
+}
+
+bool ct::KSeamIndexMap::Save(const std::string& FileName) const
+{
+    return !Map_.empty() && cv::imwrite(FileName, Map_);
+}
+
+bool ct::KSeamIndexMap::Load(const std::string& FileName)
+{
+    return Assign(cv::imread(FileName, cv::IMREAD_UNCHANGED));
+}
@@ -0,0 +1,71 @@
+#include "SeamCarver.h"
+#include "SeamCarverTestHelpers.h"
+#include "SeamIndexMap.h"
+#include "gtest/gtest.h"
+
+using ct::test::IsEqual;
+using ct::test::MakeRandomImage;
+
+TEST(SeamIndexMap, RetargetMatchesIterativeRemoval)
+{
+    const int32_t NumSeams = 12;
+    cv::Mat Image = MakeRandomImage(40, 56, 1);
+
+    ct::KSeamIndexMap SeamIndexMap;
+    ct::KSeamCarverT<int32_t> Carver;
+    ASSERT_TRUE(Carver.ComputeSeamIndexMap(NumSeams, Image, SeamIndexMap));
+    EXPECT_EQ(SeamIndexMap.GetNumSeams(), NumSeams);
+    EXPECT_EQ(SeamIndexMap.GetMinWidth(), Image.cols - NumSeams);
+
+    for (int32_t NumRemoved = 0; NumRemoved <= NumSeams; NumRemoved += 3)
+    {
+        cv::Mat Retargeted;
+        ASSERT_TRUE(SeamIndexMap.Retarget(Image, Image.cols - NumRemoved, Retargeted));
+
+        cv::Mat Expected;
+        ct::KSeamCarverT<int32_t> ReferenceCarver;
+        ASSERT_TRUE(ReferenceCarver.FindAndRemoveVerticalSeamsIteratively(NumRemoved, Image, Expected));
+        EXPECT_TRUE(IsEqual(Retargeted, Expected)) << NumRemoved << " seams removed";
+    }
+
+    cv::Mat Retargeted;
+    EXPECT_FALSE(SeamIndexMap.Retarget(Image, Image.cols - NumSeams - 1, Retargeted));
+    EXPECT_FALSE(SeamIndexMap.Retarget(Image, Image.cols + 1, Retargeted));
+}
+
+TEST(SeamIndexMap, AssignRejectsInvalidMaps)
+{
+    ct::KSeamIndexMap SeamIndexMap;
+    EXPECT_FALSE(SeamIndexMap.Assign(cv::Mat(4, 4, CV_8UC1, cv::Scalar(0))));
+
+    // row 1 removes a pixel fewer than row 0
+    cv::Mat Map(2, 4, CV_16UC1, cv::Scalar(ct::KSeamIndexMap::CKeptPixel));
+    Map.at<uint16_t>(0, 1) = 0;
+    Map.at<uint16_t>(0, 2) = 1;
+    Map.at<uint16_t>(1, 3) = 0;
+    EXPECT_FALSE(SeamIndexMap.Assign(Map));
+
+    Map.at<uint16_t>(1, 0) = 1;
+    EXPECT_TRUE(SeamIndexMap.Assign(Map));
+    EXPECT_EQ(SeamIndexMap.GetNumSeams(), 2);
+
+    // seam 2 is recorded without seam 1
+    Map.at<uint16_t>(1, 0) = 2;
+    EXPECT_FALSE(SeamIndexMap.Assign(Map));
+
+    // seam 1 is recorded twice in row 1 and seam 0 not at all, retargeting would keep every
+    //      pixel of that row
+    Map.at<uint16_t>(1, 0) = 1;
+    Map.at<uint16_t>(1, 3) = 1;
+    EXPECT_FALSE(SeamIndexMap.Assign(Map));
+
+    // the map is copied, changing it afterwards does not change the assigned map
+    Map.at<uint16_t>(1, 3) = 0;
+    ASSERT_TRUE(SeamIndexMap.Assign(Map));
+    Map.at<uint16_t>(1, 3) = 1;
+    EXPECT_EQ(SeamIndexMap.GetMap().at<uint16_t>(1, 3), 0);
+    cv::Mat Image(2, 4, CV_8UC3, cv::Scalar(0));
+    cv::Mat Retargeted;
+    ASSERT_TRUE(SeamIndexMap.Retarget(Image, 3, Retargeted));
+    EXPECT_EQ(Retargeted.cols, 3);
+}
@@ -0,0 +1,154 @@
+#include "StreamingSeamCarver.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std::chrono;
+
+template<typename EnergyType>
+bool ct::KStreamingSeamCarverT<EnergyType>::CarveFrame(int32_t NumSeams, const cv::Mat& Frame,
+                                                       cv::Mat& OutFrame, KEnergyFunc computeEnergyFn)
+{
+    typename KSeamCarverT<EnergyType>::KStatsScope StatsScope(*this);
+    KSeamCarverStats& Stats = this->Stats_;
+
+    this->NumRows_ = Frame.rows;
+    this->NumColumns_ = Frame.cols;
+    this->BottomRow_ = this->NumRows_ - 1;
+    this->RightColumn_ = this->NumColumns_ - 1;
+    this->PosInf_ = KEnergyTraits<EnergyType>::PosInf();
+
+    // check if removing more seams than columns available
+    if (NumSeams > this->NumColumns_ || this->NumRows_ == 0)
+    {
+        return false;
+    }
+
+    // only the seams are carried over from the previous frame, not the pixels they marked
+    this->MarkedPixels.Resize(this->NumRows_, this->NumColumns_);
+    this->MarkedPixels.Fill(false);
+
+    KMatrix2D<EnergyType>& PixelEnergy = this->Workspace_.PixelEnergy;
+    KSeamMatrix& seams = this->Workspace_.Seams;
+    seams.Resize(this->NumRows_, NumSeams);
+
+    try
+    {
+        auto Start = steady_clock::now();
+        if (!this->CalculateFrameEnergy(Frame, computeEnergyFn))
+        {
+            return false;
+        }
+        Stats.EnergyTime += steady_clock::now() - Start;
+
+        bool bCanTrack = PreviousSeams_.GetNumRows() == this->NumRows_ &&
+                         PreviousSeams_.GetNumColumns() == NumSeams &&
+                         PreviousFrame_.size() == Frame.size() &&
+                         PreviousFrame_.type() == Frame.type() &&
+                         !this->IsSceneChange(Frame);
+
+        Start = steady_clock::now();
+        bool bTracked = false;
+        if (bCanTrack)
+        {
+            // every seam is searched near the seam with the same index in the previous frame. A
+            //      band only widens up to a few times the search window, a seam that moved further
+            //      is cheaper to find with the full search than with wider bands
+            const int32_t MaxHalfWidth = this->CMaxBandWideningFactor_ * SearchHalfWidth_;
+            bTracked = this->FindVerticalSeamsInBands(NumSeams, PixelEnergy, PreviousSeams_,
+                                                      SearchHalfWidth_, MaxHalfWidth, seams);
+            if (!bTracked)
+            {
+                // the seams tracked before the failure set their energy to +INF, start the full
+                //      search from a clean frame, the search time includes this energy
+                if (!this->CalculateFrameEnergy(Frame, computeEnergyFn))
+                {
+                    return false;
+                }
+            }
+        }
+
+        const bool bFound = bTracked || this->FindVerticalSeams(NumSeams, PixelEnergy, seams);
+        Stats.SeamSearchTime += steady_clock::now() - Start;
+        if (!bFound)
+        {
+            this->Reset();
+            return false;
+        }
+        bLastFrameFullSearch_ = !bTracked;
+
+        // Frame and OutFrame may be the same, so the frame is kept before it is carved
+        Frame.copyTo(PreviousFrame_);
+        PreviousSeams_ = seams;
+
+        Start = steady_clock::now();
+        this->RemoveVerticalSeams(Frame, seams, OutFrame);
+        Stats.SeamRemovalTime += steady_clock::now() - Start;
+    }
+    catch (const std::exception& e)
+    {
+        Stats.ErrorMessage = e.what();
+        this->Reset();
+        return false;
+    }
+
+    return true;
+}
+
+template<typename EnergyType>
+void ct::KStreamingSeamCarverT<EnergyType>::Reset()
+{
+    PreviousFrame_.release();
+    PreviousSeams_.Release();
+    bLastFrameFullSearch_ = false;
+}
+
+template<typename EnergyType>
+void ct::KStreamingSeamCarverT<EnergyType>::SetSearchHalfWidth(int32_t HalfWidth)
+{
+    SearchHalfWidth_ = std::max(HalfWidth, 1);
+}
+
+template<typename EnergyType>
+void ct::KStreamingSeamCarverT<EnergyType>::SetSceneChangeThreshold(double Threshold)
+{
+    SceneChangeThreshold_ = Threshold;
+}
+
+template<typename EnergyType>
+bool ct::KStreamingSeamCarverT<EnergyType>::IsSceneChange(const cv::Mat& Frame) const
+{
+    if (Frame.depth() != CV_8U)
+    {
+        return true;
+    }
+
+    const int32_t NumChannels = Frame.channels();
+    uint64_t SumOfDifferences = 0;
+    uint64_t NumSamples = 0;
+    for (int32_t Row = 0; Row < Frame.rows; Row += CSceneSampleStep_)
+    {
+        const uint8_t* Pixels = Frame.ptr<uint8_t>(Row);
+        const uint8_t* PreviousPixels = PreviousFrame_.ptr<uint8_t>(Row);
+        for (int32_t Column = 0; Column < Frame.cols; Column += CSceneSampleStep_)
+        {
+            for (int32_t Channel = 0; Channel < NumChannels; Channel++)
+            {
+                const int32_t Index = Column * NumChannels + Channel;
+                SumOfDifferences += std::abs(Pixels[Index] - PreviousPixels[Index]);
+            }
+            NumSamples += NumChannels;
+        }
+    }
+
+    return NumSamples == 0 || SumOfDifferences > SceneChangeThreshold_ * NumSamples;
+}
+
+template<typename EnergyType>
+bool ct::KStreamingSeamCarverT<EnergyType>::CalculateFrameEnergy(const cv::Mat& Frame,
+                                                                 KEnergyFunc computeEnergyFn)
+{
+    return this->CalculateImageEnergy(Frame, this->Workspace_.PixelEnergy, computeEnergyFn);
+}
+
+template class ct::KStreamingSeamCarverT<double>;
+template class ct::KStreamingSeamCarverT<int32_t>;
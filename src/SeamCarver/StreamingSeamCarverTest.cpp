@@ -0,0 +1,195 @@
+#include "SeamCarverTestHelpers.h"
+#include "StreamingSeamCarver.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    using ct::test::IsEqual;
+    using ct::test::MakeRandomImage;
+
+    /**
+     * @brief exposes the seams tracked from frame to frame
+     */
+    class KSeamTrackingCarver : public ct::KStreamingSeamCarver
+    {
+    public:
+        using ct::KStreamingSeamCarver::PreviousSeams_;
+        using ct::KStreamingSeamCarver::SearchHalfWidth_;
+    };
+
+    /**
+     * @brief copies every pixel of Frame that none of Seams removes
+     */
+    cv::Mat RemoveSeamColumns(const cv::Mat& Frame, const ct::KSeamMatrix& Seams)
+    {
+        const int32_t NumSeams = Seams.GetNumColumns();
+        const size_t PixelSize = Frame.elemSize();
+        cv::Mat Carved(Frame.rows, Frame.cols - NumSeams, Frame.type());
+        for (int32_t Row = 0; Row < Frame.rows; Row++)
+        {
+            int32_t Seam = 0;
+            int32_t CarvedColumn = 0;
+            for (int32_t Column = 0; Column < Frame.cols; Column++)
+            {
+                if (Seam < NumSeams && Seams[Row][Seam] == Column)
+                {
+                    Seam++;
+                    continue;
+                }
+                std::memcpy(Carved.ptr<uint8_t>(Row) + CarvedColumn * PixelSize,
+                            Frame.ptr<uint8_t>(Row) + Column * PixelSize, PixelSize);
+                CarvedColumn++;
+            }
+        }
+        return Carved;
+    }
+
+    /**
+     * @brief blocks the band of the first seam in the middle row, as wide as the band is allowed
+     *      to grow. Only the tracked search sees the blocked pixels, the full search recalculates
+     *      the energy of the frame
+     */
+    class KBlockedBandSeamCarver : public ct::KStreamingSeamCarver
+    {
+    public:
+        int32_t NumBandSearches = 0;
+
+    protected:
+        bool FindVerticalSeamsInBands(int32_t NumSeams, ct::KMatrix2D<double>& PixelEnergy,
+                                      const ct::KSeamMatrix& GuideSeams, int32_t HalfWidth,
+                                      int32_t MaxHalfWidth, ct::KSeamMatrix& OutDiscoveredSeams) override
+        {
+            NumBandSearches++;
+            const int32_t Row = PixelEnergy.GetNumRows() / 2;
+            const int32_t Guide = GuideSeams[Row][0];
+            const int32_t Blocked = SearchHalfWidth_ * CMaxBandWideningFactor_;
+            for (int32_t Column = std::max(Guide - Blocked, 0);
+                 Column <= std::min(Guide + Blocked, PixelEnergy.GetNumColumns() - 1); Column++)
+            {
+                PixelEnergy[Row][Column] = ct::KEnergyTraits<double>::PosInf();
+            }
+            return ct::KStreamingSeamCarver::FindVerticalSeamsInBands(NumSeams, PixelEnergy, GuideSeams, HalfWidth,
+                                                                      MaxHalfWidth, OutDiscoveredSeams);
+        }
+    };
+}
+
+TEST(StreamingSeamCarver, TracksSeamsOfSimilarFrames)
+{
+    const int32_t NumSeams = 6;
+    cv::Mat Frame = MakeRandomImage(48, 64, 1);
+
+    KSeamTrackingCarver Carver;
+    cv::Mat OutFrame;
+    ASSERT_TRUE(Carver.CarveFrame(NumSeams, Frame, OutFrame));
+    EXPECT_TRUE(Carver.WasLastFrameFullSearch());
+    EXPECT_EQ(OutFrame.rows, Frame.rows);
+    EXPECT_EQ(OutFrame.cols, Frame.cols - NumSeams);
+    EXPECT_TRUE(IsEqual(OutFrame, RemoveSeamColumns(Frame, Carver.PreviousSeams_)));
+
+    // slightly changed frames reuse the seams of the previous one
+    for (int32_t Step = 0; Step < 4; Step++)
+    {
+        const ct::KSeamMatrix PreviousSeams = Carver.PreviousSeams_;
+        Frame.ptr<uint8_t>(10 + Step * 8)[20 + Step * 30] ^= 0x0F;
+        ASSERT_TRUE(Carver.CarveFrame(NumSeams, Frame, OutFrame)) << "step " << Step;
+        EXPECT_FALSE(Carver.WasLastFrameFullSearch()) << "step " << Step;
+
+        // the k-th seam pixels of the rows form connected, disjoint seams that stay within the
+        //      search window of the seams of the previous frame
+        const ct::KSeamMatrix& Seams = Carver.PreviousSeams_;
+        ASSERT_EQ(Seams.GetNumRows(), Frame.rows);
+        ASSERT_EQ(Seams.GetNumColumns(), NumSeams);
+        for (int32_t Row = 0; Row < Frame.rows; Row++)
+        {
+            ASSERT_GE(Seams[Row][0], 0) << "row " << Row;
+            ASSERT_LT(Seams[Row][NumSeams - 1], Frame.cols) << "row " << Row;
+            for (int32_t Seam = 0; Seam < NumSeams; Seam++)
+            {
+                ASSERT_TRUE(Seam == 0 || Seams[Row][Seam] > Seams[Row][Seam - 1]) << "row " << Row;
+                ASSERT_TRUE(Row == 0 || std::abs(Seams[Row][Seam] - Seams[Row - 1][Seam]) <= 1) << "row " << Row;
+                ASSERT_LE(std::abs(Seams[Row][Seam] - PreviousSeams[Row][Seam]), Carver.SearchHalfWidth_)
+                    << "row " << Row << " seam " << Seam;
+            }
+        }
+
+        // exactly the pixels of the tracked seams are removed
+        EXPECT_TRUE(IsEqual(OutFrame, RemoveSeamColumns(Frame, Seams))) << "step " << Step;
+    }
+}
+
+TEST(StreamingSeamCarver, FullSearchOnSceneChangeAndNewSize)
+{
+    const int32_t NumSeams = 4;
+    ct::KStreamingSeamCarverT<int32_t> Carver;
+    cv::Mat OutFrame;
+
+    ASSERT_TRUE(Carver.CarveFrame(NumSeams, MakeRandomImage(32, 40, 1), OutFrame));
+    ASSERT_TRUE(Carver.CarveFrame(NumSeams, MakeRandomImage(32, 40, 2), OutFrame));
+    EXPECT_TRUE(Carver.WasLastFrameFullSearch());
+
+    ASSERT_TRUE(Carver.CarveFrame(NumSeams, MakeRandomImage(32, 48, 2), OutFrame));
+    EXPECT_TRUE(Carver.WasLastFrameFullSearch());
+    EXPECT_EQ(OutFrame.cols, 48 - NumSeams);
+
+    // a different number of seams cannot be tracked either
+    ASSERT_TRUE(Carver.CarveFrame(NumSeams + 1, MakeRandomImage(32, 48, 2), OutFrame));
+    EXPECT_TRUE(Carver.WasLastFrameFullSearch());
+
+    Carver.Reset();
+    ASSERT_TRUE(Carver.CarveFrame(NumSeams + 1, MakeRandomImage(32, 48, 2), OutFrame));
+    EXPECT_TRUE(Carver.WasLastFrameFullSearch());
+}
+
+TEST(StreamingSeamCarver, StatsOfSteadyStateFrames)
+{
+    const int32_t NumSeams = 5;
+    cv::Mat Frame = MakeRandomImage(40, 56, 3);
+
+    ct::KStreamingSeamCarver Carver;
+    cv::Mat OutFrame;
+    ASSERT_TRUE(Carver.CarveFrame(NumSeams, Frame, OutFrame));
+    const ct::KSeamCarverStats& Stats = Carver.GetStats();
+    EXPECT_GT(Stats.NumBytesAllocated, 0u);
+    EXPECT_EQ(Stats.WorkspaceSize, Stats.PeakWorkspaceSize);
+    EXPECT_GE(Stats.TotalTime, Stats.EnergyTime + Stats.SeamSearchTime + Stats.SeamRemovalTime);
+
+    // once every buffer was used, frames of the same size allocate nothing
+    for (int32_t FrameIndex = 0; FrameIndex < 3; FrameIndex++)
+    {
+        Frame.ptr<uint8_t>(FrameIndex)[FrameIndex] ^= 0x0F;
+        ASSERT_TRUE(Carver.CarveFrame(NumSeams, Frame, OutFrame));
+    }
+    EXPECT_FALSE(Carver.WasLastFrameFullSearch());
+    EXPECT_EQ(Stats.NumBytesAllocated, 0u);
+    EXPECT_EQ(Stats.WorkspaceSize, Stats.PeakWorkspaceSize);
+
+    Carver.ReleaseWorkspace();
+    EXPECT_EQ(Stats.PeakWorkspaceSize, 0u);
+}
+
+
+TEST(StreamingSeamCarver, FullSearchWhenBandCannotWiden)
+{
+    const int32_t NumSeams = 4;
+    cv::Mat Frame = MakeRandomImage(40, 80, 4);
+
+    KBlockedBandSeamCarver Carver;
+    Carver.SetSearchHalfWidth(2);
+    cv::Mat OutFrame;
+    ASSERT_TRUE(Carver.CarveFrame(NumSeams, Frame, OutFrame));
+    EXPECT_EQ(Carver.NumBandSearches, 0);
+
+    // the first band is blocked as far as it may widen, so the frame falls back to the full search
+    ASSERT_TRUE(Carver.CarveFrame(NumSeams, Frame, OutFrame));
+    EXPECT_EQ(Carver.NumBandSearches, 1);
+    EXPECT_TRUE(Carver.WasLastFrameFullSearch());
+
+    ct::KStreamingSeamCarver FullSearchCarver;
+    cv::Mat Expected;
+    ASSERT_TRUE(FullSearchCarver.CarveFrame(NumSeams, Frame, Expected));
+    EXPECT_TRUE(IsEqual(OutFrame, Expected));
+}
@@ -0,0 +1,198 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ct::KThreadPool::KThreadPool(int32_t NumThreads) :
+    JobGeneration_(0),
+    bShutdown_(false),
+    JobFunction_(nullptr),
+    JobBegin_(0),
+    JobEnd_(0),
+    JobChunkSize_(0),
+    JobNumChunks_(0),
+    NumActiveWorkers_(0),
+    NextChunk_(0),
+    RemainingChunks_(0)
+{
+    if (NumThreads <= 0)
+    {
+        NumThreads = static_cast<int32_t>(std::thread::hardware_concurrency());
+        NumThreads = std::max(NumThreads, 1);
+    }
+
+    // calling thread is the first participant
+    for (int32_t Thread = 1; Thread < NumThreads; Thread++)
+    {
+        Workers_.emplace_back(&KThreadPool::WorkerLoop, this);
+    }
+}
+
+ct::KThreadPool::~KThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> Lock(StateMutex_);
+        bShutdown_ = true;
+    }
+    JobAvailable_.notify_all();
+
+    for (std::thread& Worker : Workers_)
+    {
+        Worker.join();
+    }
+}
+
+int32_t ct::KThreadPool::GetNumThreads() const
+{
+    return static_cast<int32_t>(Workers_.size()) + 1;
+}
+
+void ct::KThreadPool::ParallelFor(int32_t Begin, int32_t End,
+                                  const std::function<void(int32_t, int32_t)>& Function,
+                                  int32_t MinChunkSize)
+{
+    if (End <= Begin)
+    {
+        return;
+    }
+
+    MinChunkSize = std::max(MinChunkSize, 1);
+    int32_t NumIndices = End - Begin;
+
+    // not worth waking up other threads
+    if (Workers_.empty() || NumIndices < 2 * MinChunkSize)
+    {
+        Function(Begin, End);
+        return;
+    }
+
+    std::lock_guard<std::mutex> JobLock(JobMutex_);
+
+    // one chunk per thread keeps the chunks as large as possible while still using every thread
+    int32_t NumChunks = std::min(GetNumThreads(), NumIndices / MinChunkSize);
+    int32_t ChunkSize = (NumIndices + NumChunks - 1) / NumChunks;
+    NumChunks = (NumIndices + ChunkSize - 1) / ChunkSize;
+
+    {
+        std::unique_lock<std::mutex> Lock(StateMutex_);
+
+        // a worker that woke up late for the previous job may still be looking at its state
+        JobFinished_.wait(Lock, [this]() { return NumActiveWorkers_ == 0; });
+
+        JobFunction_ = &Function;
+        JobBegin_ = Begin;
+        JobEnd_ = End;
+        JobChunkSize_ = ChunkSize;
+        JobNumChunks_ = NumChunks;
+        RemainingChunks_.store(NumChunks);
+        NextChunk_.store(0);
+        JobGeneration_++;
+    }
+    JobAvailable_.notify_all();
+
+    // calling thread works on the job as well
+    RunChunks();
+
+    std::unique_lock<std::mutex> Lock(StateMutex_);
+    // workers only touch the job state while registered as active, so once they are all gone the
+    //      job state can safely be replaced by the next caller
+    JobFinished_.wait(Lock, [this]() { return RemainingChunks_.load() == 0 && NumActiveWorkers_ == 0; });
+    JobFunction_ = nullptr;
+}
+
+int32_t ct::KThreadPool::RunConcurrently(int32_t NumTasks, const std::function<void(int32_t)>& Function)
+{
+    NumTasks = std::min(NumTasks, GetNumThreads());
+
+    // with at most one task per thread every chunk of size 1 is claimed by a different thread,
+    //      because a thread cannot finish its task until all tasks have been claimed
+    ParallelFor(0, NumTasks, [&Function](int32_t ChunkBegin, int32_t ChunkEnd)
+    {
+        for (int32_t Task = ChunkBegin; Task < ChunkEnd; Task++)
+        {
+            Function(Task);
+        }
+    }, 1);
+    return std::max(NumTasks, 0);
+}
+
+void ct::KThreadPool::WorkerLoop()
+{
+    uint64_t LastJobGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> Lock(StateMutex_);
+            JobAvailable_.wait(Lock, [this, LastJobGeneration]()
+            {
+                return bShutdown_ || JobGeneration_ != LastJobGeneration;
+            });
+
+            if (bShutdown_)
+            {
+                return;
+            }
+            LastJobGeneration = JobGeneration_;
+            NumActiveWorkers_++;
+        }
+
+        RunChunks();
+
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex_);
+            NumActiveWorkers_--;
+        }
+        JobFinished_.notify_all();
+    }
+}
+
+void ct::KThreadPool::RunChunks()
+{
+    while (true)
+    {
+        int32_t Chunk = NextChunk_.fetch_add(1);
+        if (Chunk >= JobNumChunks_)
+        {
+            return;
+        }
+
+        int32_t ChunkBegin = JobBegin_ + Chunk * JobChunkSize_;
+        int32_t ChunkEnd = std::min(ChunkBegin + JobChunkSize_, JobEnd_);
+        (*JobFunction_)(ChunkBegin, ChunkEnd);
+
+        // last chunk wakes up the thread waiting in ParallelFor
+        if (RemainingChunks_.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> Lock(StateMutex_);
+            JobFinished_.notify_all();
+        }
+    }
+}
+
+
+ct::KSpinBarrier::KSpinBarrier(int32_t NumThreads) :
+    NumThreads_(NumThreads),
+    NumWaiting_(0),
+    Generation_(0)
+{}
+
+void ct::KSpinBarrier::Wait()
+{
+    const uint32_t Generation = Generation_.load();
+
+    // last thread to arrive opens the barrier for everyone
+    if (NumWaiting_.fetch_add(1) == NumThreads_ - 1)
+    {
+        NumWaiting_.store(0);
+        Generation_.fetch_add(1);
+        return;
+    }
+
+    const int32_t CSpinsBeforeYield = 256;
+    int32_t NumSpins = 0;
+    while (Generation_.load() == Generation)
+    {
+        if (++NumSpins >= CSpinsBeforeYield)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#include "ThreadPool.h"
+#include <gtest/gtest.h>
+
+TEST(ThreadPool, NumThreads)
+{
+    ct::KThreadPool SingleThreadPool(1);
+    EXPECT_EQ(SingleThreadPool.GetNumThreads(), 1);
+
+    ct::KThreadPool Pool(4);
+    EXPECT_EQ(Pool.GetNumThreads(), 4);
+
+    // 0 selects the number of hardware threads, which is always at least 1
+    ct::KThreadPool DefaultPool(0);
+    EXPECT_GE(DefaultPool.GetNumThreads(), 1);
+}
+
+TEST(ThreadPool, ParallelForVisitsEveryIndexOnce)
+{
+    ct::KThreadPool Pool(4);
+    const int32_t NumIndices = 1000;
+
+    // run many jobs back to back to catch workers leaking from one job into the next
+    for (int32_t Job = 0; Job < 200; Job++)
+    {
+        std::vector<std::atomic<int32_t>> Visits(NumIndices);
+        for (std::atomic<int32_t>& Visit : Visits)
+        {
+            Visit.store(0);
+        }
+
+        int32_t Begin = Job % 7;
+        Pool.ParallelFor(Begin, NumIndices, [&Visits](int32_t ChunkBegin, int32_t ChunkEnd)
+        {
+            for (int32_t Index = ChunkBegin; Index < ChunkEnd; Index++)
+            {
+                Visits[Index]++;
+            }
+        }, 1 + Job % 50);
+
+        for (int32_t Index = 0; Index < NumIndices; Index++)
+        {
+            ASSERT_EQ(Visits[Index].load(), Index < Begin ? 0 : 1);
+        }
+    }
+}
+
+TEST(ThreadPool, SmallRangesRunOnCallingThread)
+{
+    ct::KThreadPool Pool(4);
+    std::thread::id CallerId = std::this_thread::get_id();
+    bool bRanOnCaller = false;
+
+    Pool.ParallelFor(0, 10, [&](int32_t ChunkBegin, int32_t ChunkEnd)
+    {
+        bRanOnCaller = std::this_thread::get_id() == CallerId && ChunkBegin == 0 && ChunkEnd == 10;
+    }, 8);
+    EXPECT_TRUE(bRanOnCaller);
+
+    // empty ranges must not call the function at all
+    bool bCalled = false;
+    Pool.ParallelFor(5, 5, [&](int32_t, int32_t) { bCalled = true; });
+    EXPECT_FALSE(bCalled);
+}
+
+TEST(ThreadPool, RunConcurrentlyWithBarrier)
+{
+    ct::KThreadPool Pool(4);
+    const int32_t NumSteps = 500;
+
+    // every task writes its slot of the current step, then checks that all other tasks have
+    //      written theirs, which only works if the barrier holds all tasks together
+    std::vector<std::vector<int32_t>> Steps(NumSteps, std::vector<int32_t>(4, -1));
+    ct::KSpinBarrier Barrier(4);
+    std::atomic<bool> bInOrder(true);
+
+    int32_t NumTasks = Pool.RunConcurrently(4, [&](int32_t Task)
+    {
+        for (int32_t Step = 0; Step < NumSteps; Step++)
+        {
+            Steps[Step][Task] = Step;
+            Barrier.Wait();
+            for (int32_t Other = 0; Other < 4; Other++)
+            {
+                if (Steps[Step][Other] != Step)
+                {
+                    bInOrder = false;
+                }
+            }
+            Barrier.Wait();
+        }
+    });
+
+    EXPECT_EQ(NumTasks, 4);
+    EXPECT_TRUE(bInOrder);
+
+    // never more tasks than threads
+    EXPECT_EQ(Pool.RunConcurrently(10, [](int32_t) {}), 4);
+}